@@ -0,0 +1,38 @@
+#ifndef X_ANIMATION_COMPONENT_H
+#define X_ANIMATION_COMPONENT_H
+
+#include "../Core/defines.h"
+
+// Which clip of a skeletal mesh plays and where it is, replicated instead of bone poses.
+struct CAnimation
+{
+    u32 Clip = 0;
+    // Normalized, 0 is the first frame and 1 wraps back to it
+    f32 Time = 0.f;
+    // Loops per second
+    f32 Rate = 0.f;
+    // The clip played before, mixed in by BlendWeight. It keeps its own time and rate, so it carries on
+    // from where it was instead of restarting. The weight fades to zero over NetAnimation::FadeSeconds on
+    // both ends without being sent again.
+    u32 BlendClip = 0;
+    f32 BlendTime = 0.f;
+    f32 BlendRate = 0.f;
+    f32 BlendWeight = 0.f;
+    // Server time Time was taken at. The server keeps both current, clients extrapolate from them.
+    u32 StampMs = 0;
+};
+
+// Client playback of a replicated CAnimation, advanced every frame and pulled towards the server's time.
+struct CAnimationPlayback
+{
+    u32 Clip = 0;
+    f32 Time = 0.f;
+    u32 BlendClip = 0;
+    f32 BlendTime = 0.f;
+    f32 BlendWeight = 0.f;
+    // The full server time of the CAnimation it follows, which only carries the low bits of it
+    u32 StampMs = 0;
+    bool bSynced = false;
+};
+
+#endif //X_ANIMATION_COMPONENT_H
@@ -2,6 +2,7 @@
 #define X_FOLLOW_COMPONENT_H
 
 #include "../Core/defines.h"
+#include <vector>
 
 struct CFollow
 {
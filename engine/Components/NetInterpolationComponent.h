@@ -0,0 +1,23 @@
+#ifndef X_NET_INTERPOLATION_COMPONENT_H
+#define X_NET_INTERPOLATION_COMPONENT_H
+
+#include "../Core/defines.h"
+
+struct NetTransformSample
+{
+    f64 Time = 0.0;
+    v3 Position = v3(0.f);
+    q4 Rotation = q4(1.f, 0.f, 0.f, 0.f);
+    v3 Scale = v3(1.f);
+};
+
+// Server timestamped transforms of a replicated entity, oldest first.
+struct CNetInterpolation
+{
+    static constexpr u32 Capacity = 8;
+
+    NetTransformSample Samples[Capacity];
+    u32 Count = 0;
+};
+
+#endif //X_NET_INTERPOLATION_COMPONENT_H
@@ -0,0 +1,44 @@
+#ifndef X_NET_PREDICTED_COMPONENT_H
+#define X_NET_PREDICTED_COMPONENT_H
+
+#include "../Core/defines.h"
+#include "FollowComponent.h"
+#include <vector>
+
+// The path an order started a unit on, kept while a replay may still need it
+struct NetPredictedPath
+{
+    u32 Sequence = 0;
+    std::vector<v2> Points;
+};
+
+struct NetPredictedState
+{
+    u32 Sequence = 0;
+    v3 Position = v3(0.f);
+    // Where the unit was on the path of the order PathSequence, the rest of CFollow follows from it
+    u32 PathSequence = 0;
+    i32 PathIndex = 0;
+    bool bFollow = false;
+};
+
+// A replicated unit owned by this client, simulated locally ahead of the server.
+struct CNetPredicted
+{
+    static constexpr u32 HistorySize = 64;
+
+    // Simulated position after the newest and the previous input tick
+    v3 Position = v3(0.f);
+    v3 PreviousPosition = v3(0.f);
+    // Visual offset left by the last correction, decays towards zero
+    v3 ErrorOffset = v3(0.f);
+    CFollow Follow;
+    // Order that started Follow's path
+    u32 PathSequence = 0;
+    // Paths of the orders the history still refers to, oldest first. Only grows when an order starts one.
+    std::vector<NetPredictedPath> Paths;
+    // State after each input command, indexed by sequence
+    NetPredictedState History[HistorySize];
+};
+
+#endif //X_NET_PREDICTED_COMPONENT_H
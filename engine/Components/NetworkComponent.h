@@ -8,4 +8,26 @@ struct CNetwork
     u32 Id;
 };
 
+// Server side: the client whose input commands drive this entity.
+struct CNetOwner
+{
+    u32 PeerId;
+};
+
+// Server side, sharded worlds: mirror of an entity that the neighbouring zone is authoritative over.
+struct CNetGhost
+{
+    u32 Zone;
+    // Last ghost update from Zone that listed it
+    u32 Generation;
+    // Updates it may still be missing from before it is dropped, covers a handoff still on its way back
+    u32 Grace;
+};
+
+// Server side: bit per ENetCompId of the replicated components changed since the last tick.
+struct CNetDirty
+{
+    u32 Mask;
+};
+
 #endif //X_NETWORK_COMPONENT_H
@@ -0,0 +1,104 @@
+#ifndef X_FIXED_H
+#define X_FIXED_H
+
+#include "defines.h"
+#include <cmath>
+
+// Signed 16.16 fixed point. Integer arithmetic gives bit-identical results on every machine, which
+// lockstep simulation depends on. Products and quotients go through 64 bits and truncate towards zero.
+struct Fixed
+{
+    static constexpr i32 FractionBits = 16;
+    static constexpr i32 One = 1 << FractionBits;
+
+    i32 Raw = 0;
+
+    constexpr Fixed() = default;
+
+    [[nodiscard]] static constexpr Fixed FromRaw(i32 raw)
+    {
+        Fixed value;
+        value.Raw = raw;
+        return value;
+    }
+    [[nodiscard]] static constexpr Fixed FromInt(i32 value) { return FromRaw(value * One); }
+    [[nodiscard]] static constexpr Fixed FromRatio(i32 numerator, i32 denominator)
+    {
+        return FromRaw((i32)(((i64)numerator << FractionBits) / denominator));
+    }
+    // Rounds to the nearest step. Only deterministic if value is, so use it on inputs, not inside a simulation.
+    [[nodiscard]] static Fixed FromFloat(f64 value) { return FromRaw((i32)std::llround(value * One)); }
+
+    [[nodiscard]] constexpr f32 ToFloat() const { return (f32)Raw / (f32)One; }
+
+    constexpr Fixed operator+(Fixed other) const { return FromRaw(Raw + other.Raw); }
+    constexpr Fixed operator-(Fixed other) const { return FromRaw(Raw - other.Raw); }
+    constexpr Fixed operator-() const { return FromRaw(-Raw); }
+    constexpr Fixed operator*(Fixed other) const { return FromRaw((i32)(((i64)Raw * other.Raw) / One)); }
+    constexpr Fixed operator/(Fixed other) const { return FromRaw((i32)(((i64)Raw * One) / other.Raw)); }
+    Fixed& operator+=(Fixed other) { Raw += other.Raw; return *this; }
+    Fixed& operator-=(Fixed other) { Raw -= other.Raw; return *this; }
+
+    constexpr bool operator==(Fixed other) const { return Raw == other.Raw; }
+    constexpr bool operator!=(Fixed other) const { return Raw != other.Raw; }
+    constexpr bool operator<(Fixed other) const { return Raw < other.Raw; }
+    constexpr bool operator<=(Fixed other) const { return Raw <= other.Raw; }
+    constexpr bool operator>(Fixed other) const { return Raw > other.Raw; }
+    constexpr bool operator>=(Fixed other) const { return Raw >= other.Raw; }
+};
+
+struct FixedVec2
+{
+    Fixed x;
+    Fixed y;
+
+    constexpr FixedVec2 operator+(const FixedVec2& other) const { return {x + other.x, y + other.y}; }
+    constexpr FixedVec2 operator-(const FixedVec2& other) const { return {x - other.x, y - other.y}; }
+    constexpr bool operator==(const FixedVec2& other) const { return x == other.x && y == other.y; }
+    constexpr bool operator!=(const FixedVec2& other) const { return !(*this == other); }
+
+    [[nodiscard]] static FixedVec2 FromFloat(const v2& value) { return {Fixed::FromFloat(value.x), Fixed::FromFloat(value.y)}; }
+    [[nodiscard]] v2 ToFloat() const { return {x.ToFloat(), y.ToFloat()}; }
+};
+
+namespace FixedMath
+{
+// Floor of the square root of a 64-bit integer, bit by bit
+inline u64 SqrtU64(u64 value)
+{
+    u64 result = 0;
+    u64 bit = 1ull << 62;
+    while(bit > value)
+    {
+        bit >>= 2;
+    }
+    while(bit != 0)
+    {
+        if(value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+// Squared raw components stay in 64 bits for any two points in the 16.16 range
+inline Fixed Length(const FixedVec2& value)
+{
+    const u64 squared = (u64)((i64)value.x.Raw * value.x.Raw) + (u64)((i64)value.y.Raw * value.y.Raw);
+    return Fixed::FromRaw((i32)SqrtU64(squared));
+}
+
+inline Fixed Distance(const FixedVec2& a, const FixedVec2& b)
+{
+    return Length(b - a);
+}
+}
+
+#endif //X_FIXED_H
@@ -1,7 +1,5 @@
 #include "Scene.h"
 #include "../Components/MeshComponent.h"
-#include "imgui.h"
-#include "../Engine.h"
 
 Scene::Scene() : bShowUI(false){}
 
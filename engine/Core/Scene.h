@@ -3,9 +3,11 @@
 
 #include "../Core/defines.h"
 #include <entt.hpp>
-#include <SDL2/SDL_events.h>
 #include "../Components/QueuedComponent.h"
 
+// Only used by reference, so headless builds do not need SDL
+union SDL_Event;
+
 class Scene
 {
 protected:
@@ -38,7 +40,10 @@ public:
 
     void RemoveEntity(entt::entity entity)
     {
-        Registry.destroy(entity);
+        if(Registry.valid(entity))
+        {
+            Registry.destroy(entity);
+        }
     }
 
     template<typename T>
@@ -7,14 +7,14 @@
 
 SkeletalMesh::SkeletalMesh(const std::vector<SkeletalVertex> &vertices, const std::vector<u32> &indices,
                            u32 textureId, VkQueue transferQueue, VkCommandPool transferCommandPool,
-                           VkPhysicalDevice physicalDevice, VkDevice device, SkeletalAnimation animation, u32 boneCount,
+                           VkPhysicalDevice physicalDevice, VkDevice device, std::vector<SkeletalAnimation> animations, u32 boneCount,
                            Bone rootBone, m4 globalInverseTransform) :
         Vertices(vertices),
         Indices(indices),
         TextureId(textureId),
         PhysicalDevice(physicalDevice),
         Device(device),
-        Animation(std::move(animation)),
+        Animations(std::move(animations)),
         BoneCount(boneCount),
         RootBone(std::move(rootBone)),
         GlobalInverseTransform(globalInverseTransform)
@@ -30,9 +30,8 @@ void SkeletalMesh::CalculateGlobalInverseTransform(const aiScene *scene)
     GlobalInverseTransform = glm::inverse(GlobalInverseTransform);
 }
 
-SkeletalAnimation SkeletalMesh::LoadAnimation(const aiScene *scene)
+SkeletalAnimation SkeletalMesh::LoadAnimation(const aiAnimation *anim)
 {
-    aiAnimation* anim = scene->mAnimations[0];
     SkeletalAnimation animation = {};
 
     if(anim->mTicksPerSecond != 0.0f)
@@ -155,12 +154,16 @@ SkeletalMesh SkeletalMesh::LoadMesh(VkPhysicalDevice physicalDevice, VkDevice de
     }
 
     ReadSkeleton(rootBone, scene->mRootNode, boneInfo);
-    SkeletalAnimation animation = LoadAnimation(scene);
+    std::vector<SkeletalAnimation> animations = {};
+    for(u32 i = 0; i < scene->mNumAnimations; i++)
+    {
+        animations.push_back(LoadAnimation(scene->mAnimations[i]));
+    }
 
     m4 globalInverseTransform = AssimpToGlmMat4(scene->mRootNode->mTransformation);
     globalInverseTransform = glm::inverse(globalInverseTransform);
 
-    SkeletalMesh skeletalMesh = SkeletalMesh(vertices, indices, textureId, transferQueue, transferCommandPool, physicalDevice, device, animation, boneCount, rootBone, globalInverseTransform);
+    SkeletalMesh skeletalMesh = SkeletalMesh(vertices, indices, textureId, transferQueue, transferCommandPool, physicalDevice, device, animations, boneCount, rootBone, globalInverseTransform);
     skeletalMesh.CalculateGlobalInverseTransform(scene);
 
     return skeletalMesh;
@@ -263,23 +266,19 @@ std::pair<u32, f32> SkeletalMesh::GetTimeFraction(const std::vector<f32>& timeSt
     return std::make_pair(segment, fraction);
 }
 
-void SkeletalMesh::GetPose(SkeletalAnimation &animation, const Bone &skeleton, f32 animationTime, std::vector<m4> &outPose,
-                           const m4 &parentTransform, const m4 &globalInverseTransform)
+void SkeletalMesh::SampleTrack(const BoneTransformTrack &track, f32 animationTime, v3 &outPosition, q4 &outRotation, v3 &outScale)
 {
-    const BoneTransformTrack &track = animation.BoneTransformTracks[skeleton.Name];
-
-    animationTime = fmod(animationTime, animation.Duration);
-    v3 position = v3(0.f);
-    v3 scale = v3(1.f);
-    q4 rotation = glm::identity<q4>();
+    outPosition = v3(0.f);
+    outScale = v3(1.f);
+    outRotation = glm::identity<q4>();
     std::pair<u32, f32> timeFraction;
     if (!track.Positions.empty())
     {
         timeFraction = GetTimeFraction(track.PositionTimeStamps, animationTime);
         if (timeFraction.first == track.PositionTimeStamps.size() - 1)
             timeFraction.first = 0;
-        position = glm::mix(track.Positions[timeFraction.first], track.Positions[timeFraction.first + 1],
-                            timeFraction.second);
+        outPosition = glm::mix(track.Positions[timeFraction.first], track.Positions[timeFraction.first + 1],
+                               timeFraction.second);
     }
 
     if (!track.Rotations.empty())
@@ -287,8 +286,8 @@ void SkeletalMesh::GetPose(SkeletalAnimation &animation, const Bone &skeleton, f
         timeFraction = GetTimeFraction(track.RotationTimeStamps, animationTime);
         if (timeFraction.first == track.RotationTimeStamps.size() - 1)
             timeFraction.first = 0;
-        rotation = glm::slerp(track.Rotations[timeFraction.first], track.Rotations[timeFraction.first + 1],
-                              timeFraction.second);
+        outRotation = glm::slerp(track.Rotations[timeFraction.first], track.Rotations[timeFraction.first + 1],
+                                 timeFraction.second);
     }
 
     if (!track.Scales.empty())
@@ -296,8 +295,19 @@ void SkeletalMesh::GetPose(SkeletalAnimation &animation, const Bone &skeleton, f
         timeFraction = GetTimeFraction(track.ScaleTimeStamps, animationTime);
         if (timeFraction.first == track.ScaleTimeStamps.size() - 1)
             timeFraction.first = 0;
-        scale = glm::mix(track.Scales[timeFraction.first], track.Scales[timeFraction.first + 1], timeFraction.second);
+        outScale = glm::mix(track.Scales[timeFraction.first], track.Scales[timeFraction.first + 1], timeFraction.second);
     }
+}
+
+void SkeletalMesh::GetPose(SkeletalAnimation &animation, const Bone &skeleton, f32 animationTime, std::vector<m4> &outPose,
+                           const m4 &parentTransform, const m4 &globalInverseTransform)
+{
+    const BoneTransformTrack &track = animation.BoneTransformTracks[skeleton.Name];
+
+    animationTime = fmod(animationTime, animation.Duration);
+    v3 position, scale;
+    q4 rotation;
+    SampleTrack(track, animationTime, position, rotation, scale);
 
     m4 localTransform = glm::translate(m4(1.0f), position) * glm::toMat4(rotation) * glm::scale(m4(1.0f), scale);
     m4 globalTransform = parentTransform * localTransform;
@@ -69,7 +69,8 @@ class SkeletalMesh
     std::vector<SkeletalVertex> Vertices = {};
     std::vector<u32> Indices = {};
     u32 BoneCount = 0;
-    SkeletalAnimation Animation = {};
+    // Every clip in the file, in file order
+    std::vector<SkeletalAnimation> Animations = {};
     Bone RootBone = {};
 
     u32 TextureId = 0;
@@ -87,7 +88,7 @@ class SkeletalMesh
 
     void CalculateGlobalInverseTransform(const aiScene* scene);
 
-    static SkeletalAnimation LoadAnimation(const aiScene* scene);
+    static SkeletalAnimation LoadAnimation(const aiAnimation* anim);
 
     static bool ReadSkeleton(Bone& bone, aiNode* node, std::unordered_map<std::string, std::pair<i32, m4>>& boneInfoTable);
 
@@ -95,13 +96,15 @@ class SkeletalMesh
 
     SkeletalMesh(const std::vector<SkeletalVertex>& vertices, const std::vector<u32>& indices,
                  u32 textureId, VkQueue transferQueue, VkCommandPool transferCommandPool,
-                 VkPhysicalDevice physicalDevice, VkDevice device, SkeletalAnimation animation, u32 boneCount,
+                 VkPhysicalDevice physicalDevice, VkDevice device, std::vector<SkeletalAnimation> animations, u32 boneCount,
                  Bone rootBone, m4 globalInverseTransform);
 
     VkBuffer CreateVertexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool);
     VkBuffer CreateIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool);
 
     static std::pair<u32, f32> GetTimeFraction(const std::vector<f32>& timeStamps, f32& animationTime);
+    // Local transform of one bone at animationTime, which is already wrapped into the clip
+    static void SampleTrack(const BoneTransformTrack& track, f32 animationTime, v3& outPosition, q4& outRotation, v3& outScale);
 public:
     static SkeletalMesh LoadMesh(VkPhysicalDevice physicalDevice, VkDevice device,
                                  VkQueue transferQueue, VkCommandPool transferCommandPool,
@@ -112,7 +115,8 @@ public:
 
     inline u32 GetIndexCount() const { return Indices.size(); }
 
-    inline SkeletalAnimation& GetAnimation() { return Animation; }
+    // Clips the mesh does not have play the first one
+    inline SkeletalAnimation& GetAnimation(u32 clip = 0) { return Animations[clip < Animations.size() ? clip : 0]; }
     inline Bone& GetRootBone() { return RootBone; }
     inline std::vector<m4>& GetCurrentPose() { return CurrentPose; }
 
@@ -1,10 +1,10 @@
 #include "Navigation.h"
 #include "../Util/Util.h"
-#include "../Components/MeshComponent.h"
-#include "../Engine.h"
-#include "../Util/Primitives.h"
 #include <vector>
 #include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
 
 namespace Navigation
 {
@@ -237,6 +237,12 @@ void AStar(const v2 &start, const v2 &end, std::vector<TriangleNode*> &path, std
         }
     }
 
+    // The goal was never reached, e.g. it lies in a region cut off by blocked triangles
+    if(closed.find(endTriangle) == closed.end())
+    {
+        return;
+    }
+
     path = ReconstructPath(endTriangle, startTriangle, portals);
 }
 
@@ -304,6 +310,12 @@ void AStar(const v2 &start, const v2 &end, std::vector<TriangleNode*> &path, std
         }
     }
 
+    // The goal was never reached, e.g. it lies in a region cut off by blocked triangles
+    if(closed.find(endTriangle) == closed.end())
+    {
+        return;
+    }
+
     path = ReconstructPath(endTriangle, startTriangle, portals);
 }
 
@@ -448,10 +460,7 @@ bool IsOnRight(const v2 &O, const v2 &A, const v2 &B)
 
 void TriangleNode::AddNeighbor(TriangleNode *neighbor)
 {
-    if(std::find(neighbors.begin(), neighbors.end(), neighbor) != neighbors.end() && *neighbors.end() == neighbor)
-        return;
-
-    if(std::find(neighbor->neighbors.begin(), neighbor->neighbors.end(), this) != neighbor->neighbors.end() && *neighbor->neighbors.end() == this)
+    if(std::find(neighbors.begin(), neighbors.end(), neighbor) != neighbors.end())
         return;
 
     neighbors.push_back(neighbor);
@@ -485,4 +494,37 @@ TriangleNode::TriangleNode(const Triangle2D &triangle, u32 index) :
     FindCircumcircle(triangle, circumcenter, circumradius);
     FindIncenter(triangle, incenter);
 }
-}
\ No newline at end of file
+
+bool LoadNavMesh(const std::string& path, std::vector<v2>& outPoints, std::vector<TriangleNode>& outTriangles)
+{
+    std::ifstream file(path);
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    std::string line;
+    while(std::getline(file, line) && line != "TRIANGLES")
+    {
+        std::stringstream ss(line);
+        f32 x, y;
+        ss >> x >> y;
+        outPoints.emplace_back(x, y);
+    }
+
+    outTriangles = BowyerWatson(outPoints);
+
+    while(std::getline(file, line))
+    {
+        std::stringstream ss(line);
+        u32 idx;
+        bool blocked;
+        ss >> idx >> blocked;
+        if(idx < outTriangles.size())
+        {
+            outTriangles[idx].SetBlocked(blocked);
+        }
+    }
+    return true;
+}
+}
@@ -3,8 +3,9 @@
 
 #include "../Core/defines.h"
 #include <glm/gtx/norm.hpp>
+#include <string>
 #include <vector>
-#include "../Util/Primitives.h"
+#include "../Util/Geometry.h"
 
 namespace Navigation {
 
@@ -64,6 +65,9 @@ f32 TriangleArea2(const v2& A, const v2& B, const v2& C);
 std::vector<v2> StringPull(const std::vector<Edge2D>& portals, const v2& start, const v2& end);
 const Edge2D* GetSharedEdge(const Triangle2D& t1, const Triangle2D& t2);
 
+// Reads the points and blocked triangles written by the editor and triangulates them.
+bool LoadNavMesh(const std::string& path, std::vector<v2>& outPoints, std::vector<TriangleNode>& outTriangles);
+
 bool IsOnRight(const v2& O, const v2& A, const v2& B);
 
 inline void vcpy(float* v1, const float* v2)
@@ -0,0 +1,59 @@
+#include "PathFollow.h"
+
+namespace Navigation
+{
+std::vector<v2> FindPath(const v2& start, const v2& end, std::vector<TriangleNode>& triangles)
+{
+    std::vector<TriangleNode*> path;
+    std::vector<Edge2D> portals;
+    AStar(start, end, path, portals, triangles);
+
+    if(path.empty())
+    {
+        return {};
+    }
+    if(portals.empty())
+    {
+        return {start, end};
+    }
+    return StringPull(portals, start, end);
+}
+
+void StartFollow(CFollow& follow, std::vector<v2> path)
+{
+    follow.StringPath = std::move(path);
+    follow.bFollow = follow.StringPath.size() > 1;
+    follow.index = 1;
+    if(follow.bFollow)
+    {
+        follow.TargetPos = follow.StringPath[follow.index];
+    }
+}
+
+void StepFollow(CFollow& follow, v3& position, f32 deltaTime)
+{
+    f32 distance = FollowSpeed * deltaTime;
+    while(follow.bFollow && distance > 0.f)
+    {
+        const v3 target = {follow.TargetPos.x, position.y, follow.TargetPos.y};
+        const f32 remaining = glm::distance(position, target);
+        if(remaining > distance)
+        {
+            position += (target - position) / remaining * distance;
+            return;
+        }
+
+        position = target;
+        distance -= remaining;
+        follow.index++;
+        if(follow.index < (i32)follow.StringPath.size())
+        {
+            follow.TargetPos = follow.StringPath[follow.index];
+        }
+        else
+        {
+            follow.bFollow = false;
+        }
+    }
+}
+}
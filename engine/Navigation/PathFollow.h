@@ -0,0 +1,24 @@
+#ifndef X_PATH_FOLLOW_H
+#define X_PATH_FOLLOW_H
+
+#include "../Core/defines.h"
+#include <vector>
+#include "Navigation.h"
+#include "../Components/FollowComponent.h"
+
+// Unit movement shared by the local simulation, client prediction and the server, so all of
+// them produce the same positions for the same orders.
+namespace Navigation
+{
+constexpr f32 FollowSpeed = 50.f;
+
+// A* over the triangulation followed by string pulling. Empty if either point is off the mesh.
+std::vector<v2> FindPath(const v2& start, const v2& end, std::vector<TriangleNode>& triangles);
+
+void StartFollow(CFollow& follow, std::vector<v2> path);
+
+// Moves position along the follow path for deltaTime seconds without overshooting waypoints.
+void StepFollow(CFollow& follow, v3& position, f32 deltaTime);
+}
+
+#endif //X_PATH_FOLLOW_H
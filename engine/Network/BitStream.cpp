@@ -0,0 +1,127 @@
+#include "BitStream.h"
+#include <cstring>
+
+void BitWriter::WriteBits(u32 value, u32 bits)
+{
+    if(bits == 0)
+    {
+        return;
+    }
+    if(bits < 32)
+    {
+        value &= (1u << bits) - 1u;
+    }
+
+    Scratch |= (u64)value << ScratchBits;
+    ScratchBits += bits;
+
+    while(ScratchBits >= 8)
+    {
+        if(BytePosition >= Capacity)
+        {
+            bOverflow = true;
+            Scratch = 0;
+            ScratchBits = 0;
+            return;
+        }
+        pData[BytePosition++] = (u8)(Scratch & 0xFF);
+        Scratch >>= 8;
+        ScratchBits -= 8;
+    }
+}
+
+void BitWriter::WriteF32(f32 value)
+{
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    WriteBits(bits, 32);
+}
+
+void BitWriter::WriteVarU32(u32 value)
+{
+    while(value >= 0x80)
+    {
+        WriteBits((value & 0x7F) | 0x80, 8);
+        value >>= 7;
+    }
+    WriteBits(value, 8);
+}
+
+void BitWriter::WriteBytes(const u8* data, u32 size)
+{
+    for(u32 i = 0; i < size; i++)
+    {
+        WriteBits(data[i], 8);
+    }
+}
+
+void BitWriter::Flush()
+{
+    if(ScratchBits > 0)
+    {
+        WriteBits(0, 8 - ScratchBits);
+    }
+}
+
+u32 BitReader::ReadBits(u32 bits)
+{
+    if(bits == 0)
+    {
+        return 0;
+    }
+
+    while(ScratchBits < bits)
+    {
+        if(BytePosition >= Size)
+        {
+            bOverflow = true;
+            return 0;
+        }
+        Scratch |= (u64)pData[BytePosition++] << ScratchBits;
+        ScratchBits += 8;
+    }
+
+    u32 value = bits < 32 ? (u32)(Scratch & ((1ull << bits) - 1ull)) : (u32)Scratch;
+    Scratch >>= bits;
+    ScratchBits -= bits;
+    return value;
+}
+
+f32 BitReader::ReadF32()
+{
+    u32 bits = ReadBits(32);
+    f32 value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+u32 BitReader::ReadVarU32()
+{
+    u32 value = 0;
+    for(u32 shift = 0; shift < 35; shift += 7)
+    {
+        u32 byte = ReadBits(8);
+        value |= (byte & 0x7F) << shift;
+        if((byte & 0x80) == 0 || bOverflow)
+        {
+            return value;
+        }
+    }
+    bOverflow = true;
+    return value;
+}
+
+void BitReader::ReadBytes(u8* data, u32 size)
+{
+    for(u32 i = 0; i < size; i++)
+    {
+        data[i] = (u8)ReadBits(8);
+    }
+}
+
+void BitReader::AlignToByte()
+{
+    u32 drop = ScratchBits % 8;
+    Scratch >>= drop;
+    ScratchBits -= drop;
+}
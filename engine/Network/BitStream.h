@@ -0,0 +1,67 @@
+#ifndef X_BIT_STREAM_H
+#define X_BIT_STREAM_H
+
+#include "../Core/defines.h"
+
+// Bits are packed least significant first and flushed as little-endian bytes,
+// so the wire layout does not depend on the host byte order.
+class BitWriter
+{
+    u8* pData = nullptr;
+    u32 Capacity = 0;
+    u32 BytePosition = 0;
+    u64 Scratch = 0;
+    u32 ScratchBits = 0;
+    bool bOverflow = false;
+
+public:
+    BitWriter(u8* data, u32 capacity) : pData(data), Capacity(capacity) {}
+
+    void WriteBits(u32 value, u32 bits);
+    void WriteBool(bool value) { WriteBits(value ? 1u : 0u, 1); }
+    void WriteU8(u8 value) { WriteBits(value, 8); }
+    void WriteU16(u16 value) { WriteBits(value, 16); }
+    void WriteU32(u32 value) { WriteBits(value, 32); }
+    void WriteF32(f32 value);
+    void WriteVarU32(u32 value);
+    void WriteBytes(const u8* data, u32 size);
+
+    // Pads to the next byte boundary and writes any pending bits. Must be called before the buffer is sent.
+    void Flush();
+
+    [[nodiscard]] inline u32 GetBitsWritten() const { return BytePosition * 8 + ScratchBits; }
+    [[nodiscard]] inline u32 GetBytesWritten() const { return BytePosition + (ScratchBits + 7) / 8; }
+    [[nodiscard]] inline bool HasOverflowed() const { return bOverflow; }
+    [[nodiscard]] inline u8* GetData() const { return pData; }
+};
+
+class BitReader
+{
+    const u8* pData = nullptr;
+    u32 Size = 0;
+    u32 BytePosition = 0;
+    u64 Scratch = 0;
+    u32 ScratchBits = 0;
+    bool bOverflow = false;
+
+public:
+    BitReader(const u8* data, u32 size) : pData(data), Size(size) {}
+
+    u32 ReadBits(u32 bits);
+    bool ReadBool() { return ReadBits(1) != 0; }
+    u8 ReadU8() { return (u8)ReadBits(8); }
+    u16 ReadU16() { return (u16)ReadBits(16); }
+    u32 ReadU32() { return ReadBits(32); }
+    f32 ReadF32();
+    u32 ReadVarU32();
+    void ReadBytes(u8* data, u32 size);
+
+    // Discards the remaining bits of the current byte.
+    void AlignToByte();
+
+    [[nodiscard]] inline u32 GetBitsRead() const { return BytePosition * 8 - ScratchBits; }
+    [[nodiscard]] inline u32 GetBitsRemaining() const { return Size * 8 - GetBitsRead(); }
+    [[nodiscard]] inline bool HasOverflowed() const { return bOverflow; }
+};
+
+#endif //X_BIT_STREAM_H
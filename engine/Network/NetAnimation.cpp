@@ -0,0 +1,131 @@
+#include "NetAnimation.h"
+#include "NetQuantize.h"
+#include <algorithm>
+#include <cmath>
+
+namespace NetAnimation
+{
+constexpr u32 StampMask = (1u << StampBits) - 1u;
+
+static f32 Wrap(f32 time)
+{
+    return time - std::floor(time);
+}
+
+// From time to target the short way round the loop, in [-0.5, 0.5)
+static f32 GetError(f32 target, f32 time)
+{
+    return Wrap(target - time + 0.5f) - 0.5f;
+}
+
+void Write(BitWriter& writer, const CAnimation& animation)
+{
+    writer.WriteVarU32(animation.Clip);
+    writer.WriteBits(NetQuantize::QuantizeFloat(animation.Time, 0.f, 1.f, TimeBits), TimeBits);
+    writer.WriteBits(NetQuantize::QuantizeFloat(animation.Rate, 0.f, MaxRate, RateBits), RateBits);
+    writer.WriteBits(animation.StampMs & StampMask, StampBits);
+    const u32 weight = NetQuantize::QuantizeFloat(animation.BlendWeight, 0.f, 1.f, WeightBits);
+    writer.WriteBool(weight > 0);
+    if(weight > 0)
+    {
+        writer.WriteVarU32(animation.BlendClip);
+        writer.WriteBits(NetQuantize::QuantizeFloat(animation.BlendTime, 0.f, 1.f, TimeBits), TimeBits);
+        writer.WriteBits(NetQuantize::QuantizeFloat(animation.BlendRate, 0.f, MaxRate, RateBits), RateBits);
+        writer.WriteBits(weight, WeightBits);
+    }
+}
+
+void Read(BitReader& reader, CAnimation& animation)
+{
+    animation.Clip = reader.ReadVarU32();
+    animation.Time = Wrap(NetQuantize::DequantizeFloat(reader.ReadBits(TimeBits), 0.f, 1.f, TimeBits));
+    animation.Rate = NetQuantize::DequantizeFloat(reader.ReadBits(RateBits), 0.f, MaxRate, RateBits);
+    animation.StampMs = reader.ReadBits(StampBits);
+    animation.BlendClip = 0;
+    animation.BlendTime = 0.f;
+    animation.BlendRate = 0.f;
+    animation.BlendWeight = 0.f;
+    if(reader.ReadBool())
+    {
+        animation.BlendClip = reader.ReadVarU32();
+        animation.BlendTime = Wrap(NetQuantize::DequantizeFloat(reader.ReadBits(TimeBits), 0.f, 1.f, TimeBits));
+        animation.BlendRate = NetQuantize::DequantizeFloat(reader.ReadBits(RateBits), 0.f, MaxRate, RateBits);
+        animation.BlendWeight = NetQuantize::DequantizeFloat(reader.ReadBits(WeightBits), 0.f, 1.f, WeightBits);
+    }
+}
+
+void Play(entt::registry& registry, entt::entity e, u32 clip, f32 rate)
+{
+    // Played at the rate clients get, so both ends extrapolate at the same speed
+    rate = NetQuantize::DequantizeFloat(NetQuantize::QuantizeFloat(rate, 0.f, MaxRate, RateBits), 0.f, MaxRate, RateBits);
+    const CAnimation& current = registry.get<CAnimation>(e);
+    if(current.Clip == clip && current.Rate == rate)
+    {
+        return;
+    }
+
+    registry.patch<CAnimation>(e, [clip, rate](CAnimation& animation)
+    {
+        if(animation.Clip != clip)
+        {
+            // The outgoing clip fades out from where it is, not from its first frame
+            animation.BlendClip = animation.Clip;
+            animation.BlendTime = animation.Time;
+            animation.BlendRate = animation.Rate;
+            animation.BlendWeight = 1.f;
+            animation.Clip = clip;
+            animation.Time = 0.f;
+        }
+        animation.Rate = rate;
+    });
+}
+
+void Advance(entt::registry& registry, u32 serverTimeMs, f32 deltaTime)
+{
+    // Plain writes, patching would send every animation every tick
+    for(auto [e, animation] : registry.view<CAnimation>().each())
+    {
+        animation.Time = Wrap(animation.Time + animation.Rate * deltaTime);
+        animation.BlendTime = Wrap(animation.BlendTime + animation.BlendRate * deltaTime);
+        animation.BlendWeight = std::max(0.f, animation.BlendWeight - deltaTime / FadeSeconds);
+        animation.StampMs = serverTimeMs;
+    }
+}
+
+void Update(entt::registry& registry, f64 serverTime, f64 renderTime, f32 deltaTime)
+{
+    const u32 serverMs = (u32)std::max(0.0, serverTime * 1000.0);
+    for(auto [e, animation] : registry.view<CAnimation>().each())
+    {
+        CAnimationPlayback& playback = registry.get_or_emplace<CAnimationPlayback>(e);
+        bool bSnap = false;
+        if(!playback.bSynced || (playback.StampMs & StampMask) != animation.StampMs)
+        {
+            // A new state, taken at most half the stamp range from the server time we estimate
+            playback.StampMs = serverMs + (u32)(i32)(i16)(u16)(animation.StampMs - serverMs);
+            bSnap = !playback.bSynced || playback.Clip != animation.Clip;
+        }
+
+        const f32 elapsed = (f32)(renderTime - playback.StampMs / 1000.0);
+        const f32 target = Wrap(animation.Time + animation.Rate * elapsed);
+        playback.Time = Wrap(playback.Time + animation.Rate * deltaTime);
+        const f32 error = GetError(target, playback.Time);
+        if(bSnap || std::abs(error) > SnapError)
+        {
+            playback.Time = target;
+        }
+        else
+        {
+            // Spread over a few frames, a visible jump in a walk cycle is worse than running a little fast
+            playback.Time = Wrap(playback.Time + error * std::min(1.f, deltaTime / CorrectionSeconds));
+        }
+
+        playback.Clip = animation.Clip;
+        playback.BlendClip = animation.BlendClip;
+        // Only seen during a short fade, so it follows the server without easing
+        playback.BlendTime = Wrap(animation.BlendTime + animation.BlendRate * elapsed);
+        playback.BlendWeight = std::clamp(animation.BlendWeight - std::max(0.f, elapsed) / FadeSeconds, 0.f, 1.f);
+        playback.bSynced = true;
+    }
+}
+}
@@ -0,0 +1,42 @@
+#ifndef X_NET_ANIMATION_H
+#define X_NET_ANIMATION_H
+
+#include "../Core/defines.h"
+#include <entt.hpp>
+#include "BitStream.h"
+#include "../Components/AnimationComponent.h"
+
+// Animation state replication. The server sends a CAnimation only when gameplay changes the clip or the
+// rate, a few bytes each, and both ends advance time and fade blends on their own in between. Clients
+// keep a CAnimationPlayback per unit to pose from. Nothing renders it yet: replicated units have no
+// skeletal mesh and poses are still kept per mesh, not per entity.
+namespace NetAnimation
+{
+constexpr u32 TimeBits = 12;
+constexpr u32 RateBits = 8;
+constexpr f32 MaxRate = 8.f;
+constexpr u32 WeightBits = 8;
+// Low bits of CAnimation::StampMs on the wire, the client restores the rest from its server clock
+constexpr u32 StampBits = 16;
+constexpr f32 FadeSeconds = 0.2f;
+// A client further off than this fraction of a loop jumps, anything closer is eased in over CorrectionSeconds
+constexpr f32 SnapError = 0.25f;
+constexpr f32 CorrectionSeconds = 0.5f;
+
+void Write(BitWriter& writer, const CAnimation& animation);
+void Read(BitReader& reader, CAnimation& animation);
+
+// Server. Switches to clip at rate, fading out the clip that played before. Replicated only if it differs
+// from the current state as it would arrive on the wire.
+void Play(entt::registry& registry, entt::entity e, u32 clip, f32 rate);
+
+// Server, once per tick after gameplay. Advances time and blends to serverTimeMs without marking anything
+// for replication, clients extrapolate the same way.
+void Advance(entt::registry& registry, u32 serverTimeMs, f32 deltaTime);
+
+// Client, once per frame. Advances every playback by deltaTime and pulls it towards where the server's
+// state puts it at renderTime. Both times are server seconds.
+void Update(entt::registry& registry, f64 serverTime, f64 renderTime, f32 deltaTime);
+}
+
+#endif //X_NET_ANIMATION_H
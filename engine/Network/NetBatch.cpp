@@ -0,0 +1,80 @@
+#include "NetBatch.h"
+#include "NetPacketPool.h"
+
+NetBatcher::~NetBatcher()
+{
+    for(OpenBatch& batch : Batches)
+    {
+        if(batch.pPacket)
+        {
+            enet_packet_destroy(batch.pPacket);
+        }
+    }
+    for(NetOutbound& outbound : Ready)
+    {
+        enet_packet_destroy(outbound.pPacket);
+    }
+}
+
+NetBatcher::OpenBatch& NetBatcher::GetBatch(u32 peerId, u8 channel, u32 flags)
+{
+    for(OpenBatch& batch : Batches)
+    {
+        if(batch.PeerId == peerId && batch.Channel == channel && batch.Flags == flags)
+        {
+            return batch;
+        }
+    }
+
+    OpenBatch& batch = Batches.emplace_back();
+    batch.PeerId = peerId;
+    batch.Channel = channel;
+    batch.Flags = flags;
+    return batch;
+}
+
+bool NetBatcher::Open(OpenBatch& batch, u32 capacity)
+{
+    batch.pPacket = NetPacketPool::Create(capacity, batch.Flags);
+    if(!batch.pPacket)
+    {
+        return false;
+    }
+
+    BitWriter writer(batch.pPacket->data, capacity);
+    WriteNetHeader(writer, ENetMsg::Batch);
+    writer.Flush();
+    batch.Size = writer.GetBytesWritten();
+    batch.Capacity = capacity;
+    batch.Count = 0;
+    return true;
+}
+
+void NetBatcher::Close(OpenBatch& batch)
+{
+    if(!batch.pPacket)
+    {
+        return;
+    }
+
+    if(batch.Count > 0)
+    {
+        enet_packet_resize(batch.pPacket, batch.Size);
+        Ready.push_back(NetOutbound{batch.PeerId, batch.Channel, batch.pPacket});
+    }
+    else
+    {
+        enet_packet_destroy(batch.pPacket);
+    }
+    batch.pPacket = nullptr;
+    batch.Size = 0;
+    batch.Count = 0;
+}
+
+void NetBatcher::Flush()
+{
+    for(OpenBatch& batch : Batches)
+    {
+        Close(batch);
+    }
+}
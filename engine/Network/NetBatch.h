@@ -0,0 +1,196 @@
+#ifndef X_NET_BATCH_H
+#define X_NET_BATCH_H
+
+#include "../Core/defines.h"
+#include <../../vendor/enet/include/enet/enet.h>
+#include <algorithm>
+#include <vector>
+#include "BitStream.h"
+#include "NetClock.h"
+#include "NetMessage.h"
+#include "NetTelemetry.h"
+
+// Handed from the game thread to the network thread, which sends and releases the packet.
+struct NetOutbound
+{
+    u32 PeerId = 0;
+    u8 Channel = 0;
+    ENetPacket* pPacket = nullptr;
+};
+
+constexpr u32 NetBatchMtu = 1200;
+// [type u8][payload length u16]
+constexpr u32 NetBatchFrameHeaderSize = 3;
+constexpr u32 NetBatchMaxPayloadSize = 0xFFFF;
+
+// Collects every message queued for a peer during a tick and packs them into MTU-sized
+// ENet packets, one per peer, channel and flag combination. A message larger than the MTU
+// is sent alone and left to ENet to fragment.
+class NetBatcher
+{
+    struct OpenBatch
+    {
+        u32 PeerId = 0;
+        u8 Channel = 0;
+        u32 Flags = 0;
+        ENetPacket* pPacket = nullptr;
+        u32 Size = 0;
+        u32 Capacity = 0;
+        u32 Count = 0;
+    };
+
+    std::vector<OpenBatch> Batches;
+    std::vector<NetOutbound> Ready;
+    NetTelemetry* pTelemetry = nullptr;
+    // Frame header and payload of the last message written
+    u32 LastFrameSize = 0;
+
+    OpenBatch& GetBatch(u32 peerId, u8 channel, u32 flags);
+    bool Open(OpenBatch& batch, u32 capacity);
+    void Close(OpenBatch& batch);
+
+    template<typename F>
+    bool TryWrite(OpenBatch& batch, ENetMsg type, F& serialize)
+    {
+        if(batch.Size + NetBatchFrameHeaderSize > batch.Capacity)
+        {
+            return false;
+        }
+
+        u8* frame = batch.pPacket->data + batch.Size;
+        u32 capacity = std::min(batch.Capacity - batch.Size - NetBatchFrameHeaderSize, NetBatchMaxPayloadSize);
+        BitWriter writer(frame + NetBatchFrameHeaderSize, capacity);
+        serialize(writer);
+        writer.Flush();
+        if(writer.HasOverflowed())
+        {
+            return false;
+        }
+
+        u32 size = writer.GetBytesWritten();
+        frame[0] = (u8)type;
+        frame[1] = (u8)(size & 0xFF);
+        frame[2] = (u8)(size >> 8);
+        batch.Size += NetBatchFrameHeaderSize + size;
+        batch.Count++;
+        LastFrameSize = NetBatchFrameHeaderSize + size;
+        return true;
+    }
+
+    template<typename F>
+    bool WriteFrame(u32 peerId, u8 channel, u32 flags, ENetMsg type, F& serialize)
+    {
+        OpenBatch& batch = GetBatch(peerId, channel, flags);
+        if((batch.pPacket || Open(batch, NetBatchMtu)) && TryWrite(batch, type, serialize))
+        {
+            return true;
+        }
+
+        if(batch.Count > 0)
+        {
+            Close(batch);
+            if(Open(batch, NetBatchMtu) && TryWrite(batch, type, serialize))
+            {
+                return true;
+            }
+        }
+
+        // Too large for one datagram, send it on its own
+        Close(batch);
+        if(Open(batch, NetBatchMaxPayloadSize + NetBatchFrameHeaderSize + 2) && TryWrite(batch, type, serialize))
+        {
+            Close(batch);
+            return true;
+        }
+        Close(batch);
+        return false;
+    }
+
+public:
+    NetBatcher() = default;
+    NetBatcher(const NetBatcher&) = delete;
+    NetBatcher& operator=(const NetBatcher&) = delete;
+    ~NetBatcher();
+
+    // serialize is called with a BitWriter over the frame payload, possibly twice if the
+    // first attempt did not fit into the current packet.
+    template<typename F>
+    bool Write(u32 peerId, u8 channel, u32 flags, ENetMsg type, F&& serialize)
+    {
+        if(!pTelemetry)
+        {
+            return WriteFrame(peerId, channel, flags, type, serialize);
+        }
+
+        const f64 start = NetClock::Now();
+        const bool bWritten = WriteFrame(peerId, channel, flags, type, serialize);
+        if(bWritten)
+        {
+            pTelemetry->RecordEncoded(type, LastFrameSize, NetClock::Now() - start);
+        }
+        return bWritten;
+    }
+
+    template<typename T>
+    bool Add(u32 peerId, u8 channel, u32 flags, const T& message)
+    {
+        return Write(peerId, channel, flags, message.Type, [&message](BitWriter& writer) { message.Serialize(writer); });
+    }
+
+    // Counts every message written from now on, with its size and encode time.
+    inline void SetTelemetry(NetTelemetry* telemetry) { pTelemetry = telemetry; }
+
+    // Closes every open batch. The resulting packets are then available from GetReady.
+    void Flush();
+
+    [[nodiscard]] inline std::vector<NetOutbound>& GetReady() { return Ready; }
+};
+
+namespace NetUnbatch
+{
+// Calls dispatch(type, reader) for the framed messages of a batch payload from offset on, until one returns
+// false. offset is left at that frame, or at size once every frame was dispatched, so a later call goes on
+// where this one stopped. The payload starts right after the packet header. Returns false if the framing
+// is malformed.
+template<typename F>
+bool ForEachFrom(const u8* data, u32 size, u32& offset, F&& dispatch)
+{
+    while(offset < size)
+    {
+        if(offset + NetBatchFrameHeaderSize > size)
+        {
+            return false;
+        }
+        ENetMsg type = (ENetMsg)data[offset];
+        u32 length = (u32)data[offset + 1] | ((u32)data[offset + 2] << 8);
+        const u32 start = offset + NetBatchFrameHeaderSize;
+        if(start + length > size || type == ENetMsg::None || type >= ENetMsg::Count)
+        {
+            return false;
+        }
+
+        BitReader reader(data + start, length);
+        if(!dispatch(type, reader))
+        {
+            return true;
+        }
+        offset = start + length;
+    }
+    return true;
+}
+
+// Calls dispatch(type, reader) for every framed message in a batch payload, which starts right
+// after the packet header. Returns false if the framing is malformed.
+template<typename F>
+bool ForEach(const u8* data, u32 size, F&& dispatch)
+{
+    u32 offset = 0;
+    return ForEachFrom(data, size, offset, [&dispatch](ENetMsg type, BitReader& reader)
+    {
+        dispatch(type, reader);
+        return true;
+    });
+}
+}
+
+#endif //X_NET_BATCH_H
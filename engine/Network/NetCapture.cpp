@@ -0,0 +1,152 @@
+#include "NetCapture.h"
+#include "NetMessage.h"
+#include <cstring>
+
+static constexpr char CaptureMagic[4] = {'X', 'N', 'C', 'P'};
+static constexpr u8 CaptureFormatVersion = 1;
+static constexpr u32 CaptureMaxRecordSize = 1 << 24;
+
+static u32 WriteVar(u8* buffer, u64 value)
+{
+    u32 size = 0;
+    while(value >= 0x80)
+    {
+        buffer[size++] = (u8)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[size++] = (u8)value;
+    return size;
+}
+
+bool NetCaptureWriter::Open(const std::string& path, f64 startTime)
+{
+    Close();
+    if(pFile = fopen(path.c_str(), "wb"); !pFile)
+    {
+        return false;
+    }
+    setvbuf(pFile, nullptr, _IOFBF, 1 << 16);
+
+    const u8 versions[2] = {CaptureFormatVersion, NetProtocolVersion};
+    fwrite(CaptureMagic, 1, sizeof(CaptureMagic), pFile);
+    fwrite(versions, 1, sizeof(versions), pFile);
+
+    StartTime = startTime;
+    LastMicros = 0;
+    RecordCount = 0;
+    ByteCount = sizeof(CaptureMagic) + sizeof(versions);
+    return true;
+}
+
+void NetCaptureWriter::Record(ENetCaptureKind kind, u32 peerId, u8 channel, const u8* data, u32 size, f64 time)
+{
+    if(!pFile)
+    {
+        return;
+    }
+
+    const f64 elapsed = time - StartTime;
+    const u64 micros = elapsed > 0.0 ? (u64)(elapsed * 1e6) : 0;
+    // Deltas are unsigned, so the stream stays monotonic even if a caller passes an older time
+    const u64 delta = micros > LastMicros ? micros - LastMicros : 0;
+    LastMicros += delta;
+
+    u8 header[2 + 3 * 10];
+    u32 headerSize = 0;
+    header[headerSize++] = (u8)kind;
+    header[headerSize++] = channel;
+    headerSize += WriteVar(header + headerSize, peerId);
+    headerSize += WriteVar(header + headerSize, delta);
+    headerSize += WriteVar(header + headerSize, size);
+
+    fwrite(header, 1, headerSize, pFile);
+    if(size > 0)
+    {
+        fwrite(data, 1, size, pFile);
+    }
+    RecordCount++;
+    ByteCount += headerSize + size;
+}
+
+void NetCaptureWriter::Close()
+{
+    if(pFile)
+    {
+        fclose(pFile);
+        pFile = nullptr;
+    }
+}
+
+bool NetCaptureReader::Open(const std::string& path)
+{
+    Close();
+    if(pFile = fopen(path.c_str(), "rb"); !pFile)
+    {
+        return false;
+    }
+
+    char magic[4];
+    u8 versions[2];
+    if(fread(magic, 1, sizeof(magic), pFile) != sizeof(magic) || memcmp(magic, CaptureMagic, sizeof(magic)) != 0 ||
+       fread(versions, 1, sizeof(versions), pFile) != sizeof(versions) ||
+       versions[0] != CaptureFormatVersion || versions[1] != NetProtocolVersion)
+    {
+        Close();
+        return false;
+    }
+
+    Micros = 0;
+    return true;
+}
+
+bool NetCaptureReader::ReadVar(u64& outValue)
+{
+    outValue = 0;
+    for(u32 shift = 0; shift < 64; shift += 7)
+    {
+        const i32 byte = fgetc(pFile);
+        if(byte == EOF)
+        {
+            return false;
+        }
+        outValue |= (u64)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NetCaptureReader::Next(NetCaptureRecord& outRecord)
+{
+    if(!pFile)
+    {
+        return false;
+    }
+
+    u8 header[2];
+    u64 peerId, delta, size;
+    if(fread(header, 1, sizeof(header), pFile) != sizeof(header) || header[0] >= (u8)ENetCaptureKind::Count ||
+       !ReadVar(peerId) || !ReadVar(delta) || !ReadVar(size) || size > CaptureMaxRecordSize)
+    {
+        return false;
+    }
+
+    outRecord.Kind = (ENetCaptureKind)header[0];
+    outRecord.Channel = header[1];
+    outRecord.PeerId = (u32)peerId;
+    Micros += delta;
+    outRecord.Time = (f64)Micros * 1e-6;
+    outRecord.Data.resize(size);
+    return size == 0 || fread(outRecord.Data.data(), 1, size, pFile) == size;
+}
+
+void NetCaptureReader::Close()
+{
+    if(pFile)
+    {
+        fclose(pFile);
+        pFile = nullptr;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef X_NET_CAPTURE_H
+#define X_NET_CAPTURE_H
+
+#include "../Core/defines.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Capture file layout:
+//   header  "XNCP", format version u8, protocol version u8
+//   record  kind u8, channel u8, peer varint, microseconds since the previous record varint,
+//           payload length varint, payload
+enum class ENetCaptureKind : u8
+{
+    Receive = 0,
+    Send,
+    Connect,
+    Disconnect,
+    Count,
+};
+
+struct NetCaptureRecord
+{
+    ENetCaptureKind Kind = ENetCaptureKind::Receive;
+    u8 Channel = 0;
+    u32 PeerId = 0;
+    // Seconds since the capture started
+    f64 Time = 0.0;
+    std::vector<u8> Data;
+};
+
+// Appends records to a capture file. Only ever used from the network thread.
+class NetCaptureWriter
+{
+    FILE* pFile = nullptr;
+    f64 StartTime = 0.0;
+    u64 LastMicros = 0;
+    u64 RecordCount = 0;
+    u64 ByteCount = 0;
+
+public:
+    NetCaptureWriter() = default;
+    NetCaptureWriter(const NetCaptureWriter&) = delete;
+    NetCaptureWriter& operator=(const NetCaptureWriter&) = delete;
+    ~NetCaptureWriter() { Close(); }
+
+    bool Open(const std::string& path, f64 startTime);
+    void Record(ENetCaptureKind kind, u32 peerId, u8 channel, const u8* data, u32 size, f64 time);
+    void Close();
+
+    [[nodiscard]] inline bool IsOpen() const { return pFile != nullptr; }
+    [[nodiscard]] inline u64 GetRecordCount() const { return RecordCount; }
+    [[nodiscard]] inline u64 GetByteCount() const { return ByteCount; }
+};
+
+class NetCaptureReader
+{
+    FILE* pFile = nullptr;
+    u64 Micros = 0;
+
+    bool ReadVar(u64& outValue);
+
+public:
+    NetCaptureReader() = default;
+    NetCaptureReader(const NetCaptureReader&) = delete;
+    NetCaptureReader& operator=(const NetCaptureReader&) = delete;
+    ~NetCaptureReader() { Close(); }
+
+    // Fails on a missing file, a foreign format or a capture of a different protocol version.
+    bool Open(const std::string& path);
+
+    // Returns false at the end of the capture or on a truncated record.
+    bool Next(NetCaptureRecord& outRecord);
+    void Close();
+
+    [[nodiscard]] inline bool IsOpen() const { return pFile != nullptr; }
+};
+
+#endif //X_NET_CAPTURE_H
@@ -0,0 +1,48 @@
+#include "NetClock.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+f64 NetClock::Now()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+}
+
+void NetClock::OnSnapshot(f64 serverTime, f64 localTime)
+{
+    const f64 offset = serverTime - localTime;
+    if(!bSynced)
+    {
+        Offset = offset;
+        LastServerTime = serverTime;
+        bSynced = true;
+        return;
+    }
+
+    if(serverTime > LastServerTime)
+    {
+        Interval += (serverTime - LastServerTime - Interval) * 0.1;
+        LastServerTime = serverTime;
+    }
+
+    // Late packets only pull the offset down slowly, early ones snap it up, so the estimate tracks
+    // the fastest path through the network and jitter shows up as deviation from it.
+    const f64 deviation = offset - Offset;
+    Offset += deviation > 0.0 ? deviation * 0.5 : deviation * 0.02;
+    Jitter += (std::abs(deviation) - Jitter) * 0.1;
+
+    TargetDelay = std::clamp(Interval * 1.5 + Jitter * 2.0, MinDelay, MaxDelay);
+}
+
+void NetClock::Update(f64 deltaTime)
+{
+    // Change the delay by at most 10% of real time so playback never visibly jumps
+    const f64 step = deltaTime * 0.1;
+    Delay += std::clamp(TargetDelay - Delay, -step, step);
+}
+
+void NetClock::Reset()
+{
+    *this = NetClock{};
+}
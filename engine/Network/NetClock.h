@@ -0,0 +1,41 @@
+#ifndef X_NET_CLOCK_H
+#define X_NET_CLOCK_H
+
+#include "../Core/defines.h"
+
+// Client estimate of the server clock. Tracks the offset between local and server time, the
+// snapshot interval and the arrival jitter, and derives how far in the past to render so
+// that the next snapshot has usually arrived before it is needed.
+class NetClock
+{
+    f64 Offset = 0.0;
+    f64 Jitter = 0.0;
+    f64 Interval = 0.05;
+    f64 Delay = 0.1;
+    f64 TargetDelay = 0.1;
+    f64 LastServerTime = 0.0;
+    bool bSynced = false;
+
+public:
+    static constexpr f64 MinDelay = 0.03;
+    static constexpr f64 MaxDelay = 0.5;
+
+    static f64 Now();
+
+    // Called for every snapshot with the server time it was captured at.
+    void OnSnapshot(f64 serverTime, f64 localTime);
+
+    // Eases the render delay towards its target, called once per frame.
+    void Update(f64 deltaTime);
+
+    void Reset();
+
+    [[nodiscard]] inline f64 GetServerTime(f64 localTime) const { return localTime + Offset; }
+    [[nodiscard]] inline f64 GetRenderTime(f64 localTime) const { return localTime + Offset - Delay; }
+    [[nodiscard]] inline f64 GetJitter() const { return Jitter; }
+    [[nodiscard]] inline f64 GetDelay() const { return Delay; }
+    [[nodiscard]] inline f64 GetInterval() const { return Interval; }
+    [[nodiscard]] inline bool IsSynced() const { return bSynced; }
+};
+
+#endif //X_NET_CLOCK_H
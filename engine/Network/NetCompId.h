@@ -1,7 +1,7 @@
 #ifndef X_NETCOMPID_H
 #define X_NETCOMPID_H
 
-#include "base/defines.h"
+#include "../Core/defines.h"
 
 enum class ENetCompId : u32
 {
@@ -14,6 +14,10 @@ enum class ENetCompId : u32
     Axes,
     Target,
     Mesh,
+    Animation,
+    Count,
 };
 
+constexpr u32 NetCompIdCount = (u32)ENetCompId::Count;
+
 #endif //X_NETCOMPID_H
@@ -0,0 +1,164 @@
+#include "NetComponents.h"
+#include "NetAnimation.h"
+#include "NetQuantize.h"
+#include "../Components/AxesComponent.h"
+#include "../Components/PhysicsComponent.h"
+#include "../Components/TargetComponent.h"
+
+namespace
+{
+void WritePlanarPosition(BitWriter& writer, const v2& position)
+{
+    const NetQuantization& quantization = GetNetQuantization();
+    const u32 bitsX = quantization.GetPositionBits(0), bitsZ = quantization.GetPositionBits(2);
+    writer.WriteBits(NetQuantize::QuantizeFloat(position.x, quantization.WorldMin.x, quantization.WorldMax.x, bitsX), bitsX);
+    writer.WriteBits(NetQuantize::QuantizeFloat(position.y, quantization.WorldMin.z, quantization.WorldMax.z, bitsZ), bitsZ);
+}
+
+v2 ReadPlanarPosition(BitReader& reader)
+{
+    const NetQuantization& quantization = GetNetQuantization();
+    const u32 bitsX = quantization.GetPositionBits(0), bitsZ = quantization.GetPositionBits(2);
+    const f32 x = NetQuantize::DequantizeFloat(reader.ReadBits(bitsX), quantization.WorldMin.x, quantization.WorldMax.x, bitsX);
+    const f32 z = NetQuantize::DequantizeFloat(reader.ReadBits(bitsZ), quantization.WorldMin.z, quantization.WorldMax.z, bitsZ);
+    return {x, z};
+}
+
+void WritePhysics2d(BitWriter& writer, const CPhysics2d& physics)
+{
+    for(u32 i = 0; i < 2; i++)
+    {
+        writer.WriteF32(physics.Velocity[i]);
+        writer.WriteF32(physics.Acceleration[i]);
+    }
+    writer.WriteF32(physics.Mass);
+}
+
+void ReadPhysics2d(BitReader& reader, CPhysics2d& physics)
+{
+    for(u32 i = 0; i < 2; i++)
+    {
+        physics.Velocity[i] = reader.ReadF32();
+        physics.Acceleration[i] = reader.ReadF32();
+    }
+    physics.Mass = reader.ReadF32();
+}
+
+void WritePhysics3d(BitWriter& writer, const CPhysics3d& physics)
+{
+    for(u32 i = 0; i < 3; i++)
+    {
+        writer.WriteF32(physics.Velocity[i]);
+        writer.WriteF32(physics.Acceleration[i]);
+    }
+    writer.WriteF32(physics.Mass);
+}
+
+void ReadPhysics3d(BitReader& reader, CPhysics3d& physics)
+{
+    for(u32 i = 0; i < 3; i++)
+    {
+        physics.Velocity[i] = reader.ReadF32();
+        physics.Acceleration[i] = reader.ReadF32();
+    }
+    physics.Mass = reader.ReadF32();
+}
+
+void WriteAxes(BitWriter& writer, const CAxes& axes)
+{
+    const u32 bits = GetNetQuantization().AngleBits;
+    writer.WriteBits(NetQuantize::QuantizeAngle(glm::radians(axes.Yaw), bits), bits);
+    writer.WriteBits(NetQuantize::QuantizeAngle(glm::radians(axes.Pitch), bits), bits);
+    writer.WriteBits(NetQuantize::QuantizeAngle(glm::radians(axes.Roll), bits), bits);
+}
+
+void ReadAxes(BitReader& reader, CAxes& axes)
+{
+    const u32 bits = GetNetQuantization().AngleBits;
+    axes.Yaw = glm::degrees(NetQuantize::DequantizeAngle(reader.ReadBits(bits), bits));
+    axes.Pitch = glm::degrees(NetQuantize::DequantizeAngle(reader.ReadBits(bits), bits));
+    axes.Roll = glm::degrees(NetQuantize::DequantizeAngle(reader.ReadBits(bits), bits));
+}
+
+void WriteTarget(BitWriter& writer, const CTarget& target)
+{
+    WritePlanarPosition(writer, target.Position);
+}
+
+void ReadTarget(BitReader& reader, CTarget& target)
+{
+    target.Position = ReadPlanarPosition(reader);
+}
+}
+
+NetComponentRegistry::NetComponentRegistry()
+{
+    // Transforms travel in the delta compressed snapshots and mesh ids are local renderer handles,
+    // so neither is registered here.
+    Register<CPhysics2d, &WritePhysics2d, &ReadPhysics2d>(ENetCompId::Physics2d);
+    Register<CPhysics3d, &WritePhysics3d, &ReadPhysics3d>(ENetCompId::Physics3d);
+    Register<CAxes, &WriteAxes, &ReadAxes>(ENetCompId::Axes);
+    Register<CTarget, &WriteTarget, &ReadTarget>(ENetCompId::Target);
+    Register<CAnimation, &NetAnimation::Write, &NetAnimation::Read>(ENetCompId::Animation);
+}
+
+void NetComponentRegistry::Connect(entt::registry& registry) const
+{
+    for(const Entry& entry : Entries)
+    {
+        if(entry.Connect)
+        {
+            entry.Connect(registry, entry);
+        }
+    }
+}
+
+void NetComponentRegistry::Disconnect(entt::registry& registry) const
+{
+    for(const Entry& entry : Entries)
+    {
+        if(entry.Disconnect)
+        {
+            entry.Disconnect(registry, entry);
+        }
+    }
+}
+
+u32 NetComponentRegistry::GetMask(const entt::registry& registry, entt::entity e) const
+{
+    u32 mask = 0;
+    for(const Entry& entry : Entries)
+    {
+        if(entry.Has && entry.Has(registry, e))
+        {
+            mask |= entry.Bit;
+        }
+    }
+    return mask;
+}
+
+void NetComponentRegistry::WriteChanges(BitWriter& writer, const entt::registry& registry, const NetComponentChange* changes, u32 count) const
+{
+    writer.WriteVarU32(count);
+    u32 lastId = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+        const NetComponentChange& change = changes[i];
+        writer.WriteVarU32(change.NetId - lastId);
+        lastId = change.NetId;
+        writer.WriteBits(change.Mask, NetCompIdCount);
+        for(u32 id = 0; id < NetCompIdCount; id++)
+        {
+            if(change.Mask & (1u << id))
+            {
+                Entries[id].Write(writer, registry, change.Entity);
+            }
+        }
+    }
+}
+
+const NetComponentRegistry& GetNetComponents()
+{
+    static NetComponentRegistry components{};
+    return components;
+}
@@ -0,0 +1,146 @@
+#ifndef X_NET_COMPONENTS_H
+#define X_NET_COMPONENTS_H
+
+#include "../Core/defines.h"
+#include <entt.hpp>
+#include "BitStream.h"
+#include "NetCompId.h"
+#include "../Components/NetworkComponent.h"
+
+// A replicated component of one entity that has to be sent this tick.
+struct NetComponentChange
+{
+    u32 NetId = 0;
+    entt::entity Entity = entt::null;
+    u32 Mask = 0;
+};
+
+// Entities per AddComponent message, keeps a message well inside one batch
+constexpr u32 NetComponentChangesPerMessage = 32;
+
+// Maps every replicated ENetCompId to its serializer. On the server, Connect installs entt hooks
+// that set the component's bit in CNetDirty whenever it is emplaced, replaced or patched, so the
+// replicator only sends what changed. Components mutated through get<T>() must be patched to be sent.
+class NetComponentRegistry
+{
+    struct Entry
+    {
+        u32 Bit = 0;
+        bool (*Has)(const entt::registry&, entt::entity) = nullptr;
+        void (*Write)(BitWriter&, const entt::registry&, entt::entity) = nullptr;
+        // Reads one component and stores it on entity, or discards it when entity is null
+        void (*Read)(BitReader&, entt::registry&, entt::entity) = nullptr;
+        void (*Connect)(entt::registry&, const Entry&) = nullptr;
+        void (*Disconnect)(entt::registry&, const Entry&) = nullptr;
+
+        void MarkDirty(entt::registry& registry, entt::entity e) const
+        {
+            registry.get_or_emplace<CNetDirty>(e).Mask |= Bit;
+        }
+    };
+
+    Entry Entries[NetCompIdCount];
+    u32 RegisteredMask = 0;
+
+    template<typename T>
+    static bool HasThunk(const entt::registry& registry, entt::entity e)
+    {
+        return registry.all_of<T>(e);
+    }
+
+    template<typename T, void (*WriteFn)(BitWriter&, const T&)>
+    static void WriteThunk(BitWriter& writer, const entt::registry& registry, entt::entity e)
+    {
+        WriteFn(writer, registry.get<T>(e));
+    }
+
+    template<typename T, void (*ReadFn)(BitReader&, T&)>
+    static void ReadThunk(BitReader& reader, entt::registry& registry, entt::entity e)
+    {
+        T component{};
+        ReadFn(reader, component);
+        if(e != entt::null && !reader.HasOverflowed())
+        {
+            registry.emplace_or_replace<T>(e, component);
+        }
+    }
+
+    template<typename T>
+    static void ConnectThunk(entt::registry& registry, const Entry& entry)
+    {
+        registry.on_construct<T>().template connect<&Entry::MarkDirty>(entry);
+        registry.on_update<T>().template connect<&Entry::MarkDirty>(entry);
+    }
+
+    template<typename T>
+    static void DisconnectThunk(entt::registry& registry, const Entry& entry)
+    {
+        registry.on_construct<T>().disconnect(&entry);
+        registry.on_update<T>().disconnect(&entry);
+    }
+
+public:
+    NetComponentRegistry();
+
+    // One call per replicated component type, both ends must register the same ids.
+    template<typename T, void (*WriteFn)(BitWriter&, const T&), void (*ReadFn)(BitReader&, T&)>
+    void Register(ENetCompId id)
+    {
+        Entry& entry = Entries[(u32)id];
+        entry.Bit = 1u << (u32)id;
+        entry.Has = &HasThunk<T>;
+        entry.Write = &WriteThunk<T, WriteFn>;
+        entry.Read = &ReadThunk<T, ReadFn>;
+        entry.Connect = &ConnectThunk<T>;
+        entry.Disconnect = &DisconnectThunk<T>;
+        RegisteredMask |= entry.Bit;
+    }
+
+    void Connect(entt::registry& registry) const;
+    void Disconnect(entt::registry& registry) const;
+
+    // Registered components present on an entity, which is everything a client needs when it first sees it.
+    [[nodiscard]] u32 GetMask(const entt::registry& registry, entt::entity e) const;
+
+    // AddComponent message body: the changes sorted by NetId, each with its mask and the masked components.
+    void WriteChanges(BitWriter& writer, const entt::registry& registry, const NetComponentChange* changes, u32 count) const;
+
+    // Applies an AddComponent message body. resolve(netId) returns the local entity or entt::null, in which
+    // case the components are read and dropped. Returns false if the stream is malformed.
+    template<typename F>
+    bool ReadChanges(BitReader& reader, entt::registry& registry, F&& resolve) const
+    {
+        const u32 count = reader.ReadVarU32();
+        u32 netId = 0;
+        for(u32 i = 0; i < count && !reader.HasOverflowed(); i++)
+        {
+            netId += reader.ReadVarU32();
+            const u32 mask = reader.ReadBits(NetCompIdCount);
+            if(mask & ~RegisteredMask)
+            {
+                return false;
+            }
+
+            entt::entity e = resolve(netId);
+            if(e != entt::null && !registry.valid(e))
+            {
+                e = entt::null;
+            }
+            for(u32 id = 0; id < NetCompIdCount; id++)
+            {
+                if(mask & (1u << id))
+                {
+                    Entries[id].Read(reader, registry, e);
+                }
+            }
+        }
+        return !reader.HasOverflowed();
+    }
+
+    [[nodiscard]] inline u32 GetRegisteredMask() const { return RegisteredMask; }
+};
+
+// The shared registry with every component the game replicates.
+const NetComponentRegistry& GetNetComponents();
+
+#endif //X_NET_COMPONENTS_H
@@ -0,0 +1,390 @@
+#include "NetCompression.h"
+#include "BitStream.h"
+#include "NetMessage.h"
+#include "NetPacketPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+constexpr u32 Total = 1u << NetCompressionTotalBits;
+constexpr u32 LookupStep = Total / NetCompressionLookupSize;
+constexpr u8 ModelFormatVersion = 1;
+// Weight of the context-free distribution in every context, in bytes of training data
+constexpr f64 ContextPrior = 128.0;
+
+// Carryless range coder after Subbotin: 32-bit low and range, one byte out whenever the top byte
+// of the interval is settled or the range gets too small to split.
+constexpr u32 RangeTop = 1u << 24;
+constexpr u32 RangeBottom = 1u << 16;
+
+class RangeEncoder
+{
+    u8* pOut;
+    u32 Capacity;
+    u32 Size = 0;
+    u32 Low = 0;
+    u32 Range = ~0u;
+
+    void Put(u8 byte)
+    {
+        if(Size < Capacity)
+        {
+            pOut[Size] = byte;
+        }
+        Size++;
+    }
+
+public:
+    RangeEncoder(u8* out, u32 capacity) : pOut(out), Capacity(capacity) {}
+
+    void Encode(u32 cum, u32 freq)
+    {
+        Range >>= NetCompressionTotalBits;
+        Low += cum * Range;
+        Range *= freq;
+        while((Low ^ (Low + Range)) < RangeTop || (Range < RangeBottom && ((Range = (0u - Low) & (RangeBottom - 1)), true)))
+        {
+            Put((u8)(Low >> 24));
+            Low <<= 8;
+            Range <<= 8;
+        }
+    }
+
+    // Returns the coded size or 0 if it did not fit. Writes as few bytes as pin down a value inside the
+    // final interval, the decoder reads the rest as zeros.
+    u32 Finish()
+    {
+        for(u32 bytes = 1; bytes <= 4; bytes++)
+        {
+            const u64 mask = (1ull << (32 - 8 * bytes)) - 1;
+            const u64 value = ((u64)Low + mask) & ~mask;
+            if(value - Low < Range)
+            {
+                for(u32 i = 0; i < bytes; i++)
+                {
+                    Put((u8)(value >> (24 - 8 * i)));
+                }
+                break;
+            }
+        }
+        return Size <= Capacity ? Size : 0;
+    }
+};
+
+class RangeDecoder
+{
+    const u8* pIn;
+    u32 Size;
+    u32 Position = 0;
+    u32 Low = 0;
+    u32 Range = ~0u;
+    u32 Code = 0;
+
+    u8 Next()
+    {
+        return Position < Size ? pIn[Position++] : (Position++, 0);
+    }
+
+public:
+    RangeDecoder(const u8* in, u32 size) : pIn(in), Size(size)
+    {
+        for(u32 i = 0; i < 4; i++)
+        {
+            Code = (Code << 8) | Next();
+        }
+    }
+
+    u32 GetFreq()
+    {
+        Range >>= NetCompressionTotalBits;
+        return std::min((Code - Low) / Range, Total - 1);
+    }
+
+    void Decode(u32 cum, u32 freq)
+    {
+        Low += cum * Range;
+        Range *= freq;
+        while((Low ^ (Low + Range)) < RangeTop || (Range < RangeBottom && ((Range = (0u - Low) & (RangeBottom - 1)), true)))
+        {
+            Code = (Code << 8) | Next();
+            Low <<= 8;
+            Range <<= 8;
+        }
+    }
+
+    // The encoder writes one byte per shift plus at least one, a valid stream never reads further
+    [[nodiscard]] inline bool HasOverrun() const { return Position > Size + 3; }
+};
+
+void WriteVar(std::vector<u8>& out, u32 value)
+{
+    while(value >= 0x80)
+    {
+        out.push_back((u8)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((u8)value);
+}
+
+bool ReadVar(const std::vector<u8>& in, size_t& position, u32& outValue)
+{
+    outValue = 0;
+    for(u32 shift = 0; shift < 32 && position < in.size(); shift += 7)
+    {
+        const u8 byte = in[position++];
+        outValue |= (u32)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+void NetCompressionModel::Finalize()
+{
+    Cum.assign(NetCompressionContexts * (NetCompressionSymbols + 1), 0);
+    Lookup.assign(NetCompressionContexts * NetCompressionLookupSize, 0);
+    // FNV-1a
+    u32 hash = 2166136261u;
+    for(u32 context = 0; context < NetCompressionContexts; context++)
+    {
+        const u16* freq = &Freq[context * NetCompressionSymbols];
+        u16* cum = &Cum[context * (NetCompressionSymbols + 1)];
+        for(u32 symbol = 0; symbol < NetCompressionSymbols; symbol++)
+        {
+            cum[symbol + 1] = (u16)(cum[symbol] + freq[symbol]);
+            // First symbol of every bucket the symbol's range reaches into
+            u8* lookup = &Lookup[context * NetCompressionLookupSize];
+            for(u32 bucket = (cum[symbol] + LookupStep - 1) / LookupStep; bucket * LookupStep < cum[symbol + 1]; bucket++)
+            {
+                lookup[bucket] = (u8)symbol;
+            }
+            hash = (hash ^ (freq[symbol] & 0xFF)) * 16777619u;
+            hash = (hash ^ (freq[symbol] >> 8)) * 16777619u;
+        }
+    }
+    Id = hash != 0 ? hash : 1;
+}
+
+void NetCompressionModel::Build(const std::vector<u64>& counts)
+{
+    f64 global[NetCompressionSymbols];
+    f64 globalTotal = NetCompressionSymbols;
+    std::fill(std::begin(global), std::end(global), 1.0);
+    for(u32 i = 0; i < NetCompressionContexts * NetCompressionSymbols; i++)
+    {
+        global[i % NetCompressionSymbols] += (f64)counts[i];
+        globalTotal += (f64)counts[i];
+    }
+
+    Freq.assign(NetCompressionContexts * NetCompressionSymbols, 0);
+    for(u32 context = 0; context < NetCompressionContexts; context++)
+    {
+        const u64* count = &counts[context * NetCompressionSymbols];
+        u16* freq = &Freq[context * NetCompressionSymbols];
+        f64 contextTotal = ContextPrior;
+        for(u32 symbol = 0; symbol < NetCompressionSymbols; symbol++)
+        {
+            contextTotal += (f64)count[symbol];
+        }
+
+        // Every symbol keeps a frequency of at least one, the rounding remainder goes to the most likely
+        u32 assigned = 0, mostLikely = 0;
+        for(u32 symbol = 0; symbol < NetCompressionSymbols; symbol++)
+        {
+            const f64 p = ((f64)count[symbol] + ContextPrior * global[symbol] / globalTotal) / contextTotal;
+            freq[symbol] = (u16)(1 + (u32)(p * (Total - NetCompressionSymbols)));
+            assigned += freq[symbol];
+            mostLikely = freq[symbol] > freq[mostLikely] ? symbol : mostLikely;
+        }
+        freq[mostLikely] = (u16)(freq[mostLikely] + Total - assigned);
+    }
+    Finalize();
+}
+
+bool NetCompressionModel::Load(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file)
+    {
+        return false;
+    }
+    std::vector<u8> data;
+    u8 buffer[4096];
+    size_t read;
+    while((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    fclose(file);
+
+    if(data.size() < 5 || memcmp(data.data(), "XNCM", 4) != 0 || data[4] != ModelFormatVersion)
+    {
+        return false;
+    }
+
+    std::vector<u16> freq(NetCompressionContexts * NetCompressionSymbols);
+    size_t position = 5;
+    for(u32 context = 0; context < NetCompressionContexts; context++)
+    {
+        u32 sum = 0;
+        for(u32 symbol = 0; symbol < NetCompressionSymbols; symbol++)
+        {
+            u32 value;
+            if(!ReadVar(data, position, value) || value == 0 || value >= Total)
+            {
+                return false;
+            }
+            freq[context * NetCompressionSymbols + symbol] = (u16)value;
+            sum += value;
+        }
+        if(sum != Total)
+        {
+            return false;
+        }
+    }
+
+    Freq = std::move(freq);
+    Finalize();
+    return true;
+}
+
+bool NetCompressionModel::Save(const std::string& path) const
+{
+    if(!IsValid())
+    {
+        return false;
+    }
+
+    std::vector<u8> data = {'X', 'N', 'C', 'M', ModelFormatVersion};
+    for(u16 freq : Freq)
+    {
+        WriteVar(data, freq);
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file)
+    {
+        return false;
+    }
+    const bool bWritten = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && bWritten;
+}
+
+u32 NetCompressionModel::Encode(const u8* src, u32 size, u8* dst, u32 capacity) const
+{
+    RangeEncoder encoder(dst, capacity);
+    u32 context = 0;
+    for(u32 i = 0; i < size; i++)
+    {
+        const u8 symbol = src[i];
+        encoder.Encode(Cum[context * (NetCompressionSymbols + 1) + symbol], Freq[context * NetCompressionSymbols + symbol]);
+        context = symbol;
+    }
+    return encoder.Finish();
+}
+
+bool NetCompressionModel::Decode(const u8* src, u32 size, u8* dst, u32 rawSize) const
+{
+    RangeDecoder decoder(src, size);
+    u32 context = 0;
+    for(u32 i = 0; i < rawSize; i++)
+    {
+        const u16* cum = &Cum[context * (NetCompressionSymbols + 1)];
+        const u32 value = decoder.GetFreq();
+        // Last symbol whose cumulative frequency does not exceed value, starting from its bucket
+        u32 symbol = Lookup[context * NetCompressionLookupSize + value / LookupStep];
+        while(cum[symbol + 1] <= value)
+        {
+            symbol++;
+        }
+        decoder.Decode(cum[symbol], Freq[context * NetCompressionSymbols + symbol]);
+        dst[i] = (u8)symbol;
+        context = symbol;
+    }
+    return !decoder.HasOverrun();
+}
+
+void NetCompressionTrainer::AddPacket(const u8* data, u32 size)
+{
+    u32 context = 0;
+    for(u32 i = 0; i < size; i++)
+    {
+        Counts[context * NetCompressionSymbols + data[i]]++;
+        context = data[i];
+    }
+    PacketCount++;
+    ByteCount += size;
+}
+
+void NetCompressionTrainer::Build(NetCompressionModel& outModel) const
+{
+    outModel.Build(Counts);
+}
+
+namespace NetCompression
+{
+ENetPacket* Compress(const NetCompressionModel& model, ENetPacket* packet)
+{
+    const u32 size = (u32)packet->dataLength;
+    if(!model.IsValid() || size > NetCompressionMaxRawSize)
+    {
+        return packet;
+    }
+
+    const u32 flags = packet->flags & (ENET_PACKET_FLAG_RELIABLE | ENET_PACKET_FLAG_UNSEQUENCED | ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT);
+    ENetPacket* compressed = NetPacketPool::Create(size, flags);
+    if(!compressed)
+    {
+        return packet;
+    }
+
+    BitWriter writer(compressed->data, size);
+    WriteNetHeader(writer, ENetMsg::Compressed);
+    writer.WriteVarU32(size);
+    writer.Flush();
+    const u32 headerSize = writer.GetBytesWritten();
+
+    // Only worth it if at least one byte smaller
+    const u32 coded = !writer.HasOverflowed() && headerSize + 1 < size
+        ? model.Encode(packet->data, size, compressed->data + headerSize, size - headerSize - 1) : 0;
+    if(coded == 0)
+    {
+        enet_packet_destroy(compressed);
+        return packet;
+    }
+
+    enet_packet_resize(compressed, headerSize + coded);
+    enet_packet_destroy(packet);
+    return compressed;
+}
+
+ENetPacket* Decompress(const NetCompressionModel& model, ENetPacket* packet)
+{
+    BitReader reader(packet->data, (u32)packet->dataLength);
+    ENetMsg type;
+    if(!ReadNetHeader(reader, type) || type != ENetMsg::Compressed)
+    {
+        return packet;
+    }
+
+    const u32 rawSize = reader.ReadVarU32();
+    const u32 headerSize = reader.GetBitsRead() / 8;
+    ENetPacket* raw = nullptr;
+    if(model.IsValid() && !reader.HasOverflowed() && rawSize > 0 && rawSize <= NetCompressionMaxRawSize)
+    {
+        raw = NetPacketPool::Create(rawSize, packet->flags & ENET_PACKET_FLAG_RELIABLE);
+    }
+    if(raw && !model.Decode(packet->data + headerSize, (u32)packet->dataLength - headerSize, raw->data, rawSize))
+    {
+        enet_packet_destroy(raw);
+        raw = nullptr;
+    }
+    enet_packet_destroy(packet);
+    return raw;
+}
+}
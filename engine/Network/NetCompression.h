@@ -0,0 +1,80 @@
+#ifndef X_NET_COMPRESSION_H
+#define X_NET_COMPRESSION_H
+
+#include "../Core/defines.h"
+#include <../../vendor/enet/include/enet/enet.h>
+#include <string>
+#include <vector>
+
+// Symbol frequencies of every context add up to 1 << NetCompressionTotalBits
+constexpr u32 NetCompressionTotalBits = 15;
+constexpr u32 NetCompressionContexts = 256;
+constexpr u32 NetCompressionSymbols = 256;
+// Decoder buckets per context, each names the symbol at its start so that the search is a short scan
+constexpr u32 NetCompressionLookupSize = 256;
+// Larger packets are sent as they are
+constexpr u32 NetCompressionMaxRawSize = 1u << 17;
+
+// Static order-1 byte model for the range coder: the probability of each byte given the byte before it,
+// trained offline on captured traffic. Both ends of a connection must use the same model, which the
+// client proves by sending GetId() as its ENet connect data.
+//
+// Model file layout:
+//   header  "XNCM", format version u8
+//   body    NetCompressionContexts * NetCompressionSymbols frequencies, LEB128 varints, context major
+class NetCompressionModel
+{
+    std::vector<u16> Freq;
+    // NetCompressionSymbols + 1 cumulative frequencies per context
+    std::vector<u16> Cum;
+    std::vector<u8> Lookup;
+    u32 Id = 0;
+
+    void Finalize();
+
+public:
+    // Normalizes trained byte pair counts, counts[context * NetCompressionSymbols + symbol]. Pairs never
+    // seen fall back to the context-free distribution so that no byte becomes impossible.
+    void Build(const std::vector<u64>& counts);
+
+    bool Load(const std::string& path);
+    bool Save(const std::string& path) const;
+
+    // Writes the coded form of src to dst, returns its size or 0 if it did not fit into capacity.
+    u32 Encode(const u8* src, u32 size, u8* dst, u32 capacity) const;
+    // Decodes exactly rawSize bytes. Returns false if src runs out first.
+    bool Decode(const u8* src, u32 size, u8* dst, u32 rawSize) const;
+
+    // Hash of the frequencies, never 0
+    [[nodiscard]] inline u32 GetId() const { return Id; }
+    [[nodiscard]] inline bool IsValid() const { return Id != 0; }
+};
+
+// Counts byte pairs over training packets for NetCompressionModel::Build.
+class NetCompressionTrainer
+{
+    std::vector<u64> Counts = std::vector<u64>(NetCompressionContexts * NetCompressionSymbols, 0);
+    u64 PacketCount = 0;
+    u64 ByteCount = 0;
+
+public:
+    void AddPacket(const u8* data, u32 size);
+    void Build(NetCompressionModel& outModel) const;
+
+    [[nodiscard]] inline u64 GetPacketCount() const { return PacketCount; }
+    [[nodiscard]] inline u64 GetByteCount() const { return ByteCount; }
+};
+
+// Compressed packets are a regular message: the header with ENetMsg::Compressed, the size of the
+// original packet as a varint, then the original packet, header included, range coded with the model.
+namespace NetCompression
+{
+// Returns a pooled Compressed packet and destroys packet if that is smaller, otherwise packet itself.
+ENetPacket* Compress(const NetCompressionModel& model, ENetPacket* packet);
+
+// Returns the original of a Compressed packet and destroys packet, or nullptr if it is malformed or no
+// model is loaded. Any other packet is returned as it is.
+ENetPacket* Decompress(const NetCompressionModel& model, ENetPacket* packet);
+}
+
+#endif //X_NET_COMPRESSION_H
@@ -0,0 +1,146 @@
+#include "NetConditioner.h"
+#include <algorithm>
+
+static ENetSocket CreateSocket(const ENetAddress* bindAddress)
+{
+    ENetSocket socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+    if(socket == ENET_SOCKET_NULL)
+    {
+        return socket;
+    }
+    if(enet_socket_bind(socket, bindAddress) < 0)
+    {
+        enet_socket_destroy(socket);
+        return ENET_SOCKET_NULL;
+    }
+    enet_socket_set_option(socket, ENET_SOCKOPT_NONBLOCK, 1);
+    enet_socket_set_option(socket, ENET_SOCKOPT_RCVBUF, 1 << 20);
+    enet_socket_set_option(socket, ENET_SOCKOPT_SNDBUF, 1 << 20);
+    return socket;
+}
+
+bool NetConditioner::Start(u16 listenPort, const ENetAddress& target, const NetConditionerConfig& config)
+{
+    Stop();
+
+    ENetAddress address{};
+    address.host = ENET_HOST_ANY;
+    address.port = listenPort;
+    if(Listen = CreateSocket(&address); Listen == ENET_SOCKET_NULL)
+    {
+        return false;
+    }
+
+    Target = target;
+    Config = config;
+    Random.seed(config.Seed);
+    return true;
+}
+
+void NetConditioner::Stop()
+{
+    for(Route& route : Routes)
+    {
+        enet_socket_destroy(route.Upstream);
+    }
+    Routes.clear();
+    if(Listen != ENET_SOCKET_NULL)
+    {
+        enet_socket_destroy(Listen);
+        Listen = ENET_SOCKET_NULL;
+    }
+    Pending = {};
+}
+
+NetConditioner::Route* NetConditioner::FindRoute(const ENetAddress& client)
+{
+    for(Route& route : Routes)
+    {
+        if(route.Client.host == client.host && route.Client.port == client.port)
+        {
+            return &route;
+        }
+    }
+
+    ENetSocket upstream = CreateSocket(nullptr);
+    if(upstream == ENET_SOCKET_NULL)
+    {
+        return nullptr;
+    }
+    Route& route = Routes.emplace_back();
+    route.Client = client;
+    route.Upstream = upstream;
+    return &route;
+}
+
+void NetConditioner::Schedule(ENetSocket socket, const ENetAddress& to, u32 size, f64 now)
+{
+    std::uniform_real_distribution<f32> percent(0.f, 100.f);
+    if(percent(Random) < Config.LossPercent)
+    {
+        Dropped++;
+        return;
+    }
+
+    f64 delayMs = Config.LatencyMs + std::uniform_real_distribution<f32>(0.f, Config.JitterMs)(Random);
+    if(percent(Random) < Config.ReorderPercent)
+    {
+        // Late enough to land behind whatever is sent right after it
+        delayMs += Config.JitterMs + std::max(Config.LatencyMs * 0.5f, 5.f);
+    }
+
+    Pending.push(Delayed{now + delayMs * 1e-3, NextOrder++, socket, to, std::vector<u8>(Buffer, Buffer + size)});
+}
+
+void NetConditioner::Drain(ENetSocket socket, bool bFromClient, const ENetAddress* to, f64 now)
+{
+    for(;;)
+    {
+        ENetAddress from{};
+        ENetBuffer buffer{};
+        buffer.data = Buffer;
+        buffer.dataLength = sizeof(Buffer);
+        const i32 size = enet_socket_receive(socket, &from, &buffer, 1);
+        if(size <= 0)
+        {
+            return;
+        }
+
+        if(bFromClient)
+        {
+            if(Route* route = FindRoute(from))
+            {
+                Schedule(route->Upstream, Target, (u32)size, now);
+            }
+        }
+        else
+        {
+            Schedule(Listen, *to, (u32)size, now);
+        }
+    }
+}
+
+void NetConditioner::Update(f64 now)
+{
+    if(Listen == ENET_SOCKET_NULL)
+    {
+        return;
+    }
+
+    Drain(Listen, true, nullptr, now);
+    for(size_t i = 0; i < Routes.size(); i++)
+    {
+        Drain(Routes[i].Upstream, false, &Routes[i].Client, now);
+    }
+
+    while(!Pending.empty() && Pending.top().ReleaseTime <= now)
+    {
+        const Delayed& delayed = Pending.top();
+        ENetBuffer buffer{};
+        buffer.data = const_cast<u8*>(delayed.Data.data());
+        buffer.dataLength = delayed.Data.size();
+        enet_socket_send(delayed.Socket, &delayed.To, &buffer, 1);
+        Relayed++;
+        Pending.pop();
+    }
+}
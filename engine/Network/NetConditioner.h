@@ -0,0 +1,81 @@
+#ifndef X_NET_CONDITIONER_H
+#define X_NET_CONDITIONER_H
+
+#include "../Core/defines.h"
+#include <../../vendor/enet/include/enet/enet.h>
+#include <queue>
+#include <random>
+#include <vector>
+
+struct NetConditionerConfig
+{
+    // One way, applied to both directions
+    f32 LatencyMs = 0.f;
+    // Uniform extra delay in [0, JitterMs]
+    f32 JitterMs = 0.f;
+    f32 LossPercent = 0.f;
+    // Chance a datagram is held back long enough to arrive after the ones sent after it
+    f32 ReorderPercent = 0.f;
+    u32 Seed = 1;
+};
+
+// UDP relay that degrades traffic between clients and a server. Clients connect to the listen
+// port, every client address gets its own upstream socket so the server still sees distinct
+// peers. ENet reliability runs end to end on top, only the datagrams are delayed, dropped and
+// reordered.
+class NetConditioner
+{
+    struct Route
+    {
+        ENetAddress Client = {};
+        ENetSocket Upstream = ENET_SOCKET_NULL;
+    };
+
+    struct Delayed
+    {
+        f64 ReleaseTime = 0.0;
+        u64 Order = 0;
+        ENetSocket Socket = ENET_SOCKET_NULL;
+        ENetAddress To = {};
+        std::vector<u8> Data;
+
+        bool operator>(const Delayed& other) const
+        {
+            return ReleaseTime != other.ReleaseTime ? ReleaseTime > other.ReleaseTime : Order > other.Order;
+        }
+    };
+
+    NetConditionerConfig Config;
+    ENetSocket Listen = ENET_SOCKET_NULL;
+    ENetAddress Target = {};
+    std::vector<Route> Routes;
+    std::priority_queue<Delayed, std::vector<Delayed>, std::greater<>> Pending;
+    std::mt19937 Random;
+    u64 NextOrder = 0;
+    u64 Dropped = 0;
+    u64 Relayed = 0;
+    u8 Buffer[ENET_PROTOCOL_MAXIMUM_MTU];
+
+    Route* FindRoute(const ENetAddress& client);
+    void Schedule(ENetSocket socket, const ENetAddress& to, u32 size, f64 now);
+    void Drain(ENetSocket socket, bool bFromClient, const ENetAddress* to, f64 now);
+
+public:
+    NetConditioner() = default;
+    NetConditioner(const NetConditioner&) = delete;
+    NetConditioner& operator=(const NetConditioner&) = delete;
+    ~NetConditioner() { Stop(); }
+
+    bool Start(u16 listenPort, const ENetAddress& target, const NetConditionerConfig& config);
+    void Stop();
+
+    // Relays everything that arrived and sends what is due. Call in a loop, it never blocks.
+    void Update(f64 now);
+
+    inline void SetConfig(const NetConditionerConfig& config) { Config = config; }
+    [[nodiscard]] inline u64 GetDropped() const { return Dropped; }
+    [[nodiscard]] inline u64 GetRelayed() const { return Relayed; }
+    [[nodiscard]] inline size_t GetRouteCount() const { return Routes.size(); }
+};
+
+#endif //X_NET_CONDITIONER_H
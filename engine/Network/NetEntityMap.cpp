@@ -0,0 +1,67 @@
+#include "NetEntityMap.h"
+
+void NetEntityMap::Add(u32 netId, entt::entity entity)
+{
+    if(auto it = NetToEntity.find(netId); it != NetToEntity.end())
+    {
+        EntityToNet.erase(it->second);
+        it->second = entity;
+    }
+    else
+    {
+        NetToEntity.emplace(netId, entity);
+    }
+    EntityToNet[entity] = netId;
+}
+
+entt::entity NetEntityMap::Remove(u32 netId)
+{
+    auto it = NetToEntity.find(netId);
+    if(it == NetToEntity.end())
+    {
+        return entt::null;
+    }
+
+    entt::entity entity = it->second;
+    EntityToNet.erase(entity);
+    NetToEntity.erase(it);
+    return entity;
+}
+
+void NetEntityMap::RemoveEntity(entt::entity entity)
+{
+    if(auto it = EntityToNet.find(entity); it != EntityToNet.end())
+    {
+        NetToEntity.erase(it->second);
+        EntityToNet.erase(it);
+    }
+}
+
+void NetEntityMap::Clear()
+{
+    NetToEntity.clear();
+    EntityToNet.clear();
+}
+
+void NetEntityMap::Reserve(size_t count)
+{
+    NetToEntity.reserve(count);
+    EntityToNet.reserve(count);
+}
+
+entt::entity NetEntityMap::Find(u32 netId) const
+{
+    auto it = NetToEntity.find(netId);
+    return it != NetToEntity.end() ? it->second : entt::entity{entt::null};
+}
+
+bool NetEntityMap::FindNetId(entt::entity entity, u32& outNetId) const
+{
+    auto it = EntityToNet.find(entity);
+    if(it == EntityToNet.end())
+    {
+        return false;
+    }
+    outNetId = it->second;
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef X_NET_ENTITY_MAP_H
+#define X_NET_ENTITY_MAP_H
+
+#include "../Core/defines.h"
+#include <entt.hpp>
+#include <unordered_map>
+
+// Bidirectional network id <-> entity index, kept in sync by the spawn and kill handlers.
+class NetEntityMap
+{
+    std::unordered_map<u32, entt::entity> NetToEntity;
+    std::unordered_map<entt::entity, u32> EntityToNet;
+
+public:
+    NetEntityMap() = default;
+
+    void Add(u32 netId, entt::entity entity);
+    entt::entity Remove(u32 netId);
+    void RemoveEntity(entt::entity entity);
+    void Clear();
+    void Reserve(size_t count);
+
+    [[nodiscard]] entt::entity Find(u32 netId) const;
+    [[nodiscard]] bool FindNetId(entt::entity entity, u32& outNetId) const;
+    [[nodiscard]] inline bool Contains(u32 netId) const { return NetToEntity.find(netId) != NetToEntity.end(); }
+    [[nodiscard]] inline size_t Size() const { return NetToEntity.size(); }
+};
+
+#endif //X_NET_ENTITY_MAP_H
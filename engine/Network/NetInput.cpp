@@ -0,0 +1,255 @@
+#include "NetInput.h"
+#include "../Components/FollowComponent.h"
+#include "../Components/NetworkComponent.h"
+#include "../Components/TargetComponent.h"
+#include "../Components/TransformComponent.h"
+#include "BitStream.h"
+#include "NetQuantize.h"
+#include "../Navigation/PathFollow.h"
+#include <algorithm>
+
+namespace NetInput
+{
+bool IsOrdered(const NetInputCommand& command, u32 netId)
+{
+    return command.bMove && (command.Units.empty() || std::binary_search(command.Units.begin(), command.Units.end(), netId));
+}
+
+std::vector<v2> FindGroupPath(const NetInputCommand& command, std::vector<Navigation::TriangleNode>* pTriangles)
+{
+    if(!command.bMove || !pTriangles)
+    {
+        return {};
+    }
+    return Navigation::FindPath(command.Origin, command.Target, *pTriangles);
+}
+
+void Simulate(const NetInputCommand& command, const std::vector<v2>* pGroupPath, CFollow& follow, v3& position,
+              std::vector<Navigation::TriangleNode>* pTriangles)
+{
+    if(pGroupPath && pTriangles)
+    {
+        const v2 start(position.x, position.z);
+        // StartFollow skips the first waypoint, so the group origin is never walked to
+        const bool bShared = pGroupPath->size() > 1 && glm::distance(start, command.Origin) <= NetInputGroupRadius;
+        Navigation::StartFollow(follow, bShared ? *pGroupPath : Navigation::FindPath(start, command.Target, *pTriangles));
+    }
+    Navigation::StepFollow(follow, position, NetInputTickDelta);
+}
+
+v2 QuantizeTarget(const v2& target)
+{
+    const NetQuantization& quantization = GetNetQuantization();
+    const u32 bitsX = quantization.GetPositionBits(0), bitsZ = quantization.GetPositionBits(2);
+    return {NetQuantize::DequantizeFloat(NetQuantize::QuantizeFloat(target.x, quantization.WorldMin.x, quantization.WorldMax.x, bitsX),
+                                         quantization.WorldMin.x, quantization.WorldMax.x, bitsX),
+            NetQuantize::DequantizeFloat(NetQuantize::QuantizeFloat(target.y, quantization.WorldMin.z, quantization.WorldMax.z, bitsZ),
+                                         quantization.WorldMin.z, quantization.WorldMax.z, bitsZ)};
+}
+
+void Consume(entt::registry& registry, u32 peerId, NetInputBuffer& buffer, std::vector<Navigation::TriangleNode>* pTriangles)
+{
+    auto view = registry.view<CNetOwner, CNetwork, CFollow, CTransform3d>();
+    NetInputCommand command;
+    std::vector<v2> path;
+    for(u32 count = buffer.GetConsumeCount(); count > 0 && buffer.Pop(command); count--)
+    {
+        path = FindGroupPath(command, pTriangles);
+        for(entt::entity e : view)
+        {
+            if(view.get<CNetOwner>(e).PeerId != peerId)
+            {
+                continue;
+            }
+            const bool bOrdered = IsOrdered(command, view.get<CNetwork>(e).Id);
+            Simulate(command, bOrdered ? &path : nullptr, view.get<CFollow>(e), view.get<CTransform3d>(e).WorldPosition, pTriangles);
+            // Replicated so other clients can show where the unit is heading
+            if(bOrdered)
+            {
+                registry.emplace_or_replace<CTarget>(e, CTarget{command.Target});
+            }
+        }
+    }
+}
+
+static u32 GetVarU32Bits(u32 value)
+{
+    u32 bytes = 1;
+    while(value >= 0x80)
+    {
+        value >>= 7;
+        bytes++;
+    }
+    return bytes * 8;
+}
+
+// Calls run(first, length) for every stretch of consecutive ids
+template<typename F>
+static void ForEachRun(const std::vector<u32>& units, F&& run)
+{
+    for(size_t i = 0; i < units.size();)
+    {
+        size_t end = i + 1;
+        while(end < units.size() && units[end] == units[end - 1] + 1)
+        {
+            end++;
+        }
+        run(units[i], (u32)(end - i));
+        i = end;
+    }
+}
+
+void WriteUnits(BitWriter& writer, const std::vector<u32>& units)
+{
+    writer.WriteVarU32((u32)units.size());
+    if(units.empty())
+    {
+        return;
+    }
+
+    // Runs: start as the gap from the end of the previous run, then length - 1
+    u32 runs = 0, runBits = 0, next = 0;
+    ForEachRun(units, [&runs, &runBits, &next](u32 first, u32 length)
+    {
+        runBits += GetVarU32Bits(first - next) + GetVarU32Bits(length - 1);
+        next = first + length;
+        runs++;
+    });
+    runBits += GetVarU32Bits(runs);
+    const u32 span = units.back() - units.front() + 1;
+    const bool bBitset = GetVarU32Bits(units.front()) + GetVarU32Bits(span) + span < runBits;
+
+    writer.WriteBool(bBitset);
+    if(bBitset)
+    {
+        writer.WriteVarU32(units.front());
+        writer.WriteVarU32(span);
+        for(size_t i = 0, id = units.front(); id <= units.back(); id++)
+        {
+            const bool bSet = units[i] == id;
+            writer.WriteBool(bSet);
+            i += bSet;
+        }
+        return;
+    }
+    writer.WriteVarU32(runs);
+    next = 0;
+    ForEachRun(units, [&writer, &next](u32 first, u32 length)
+    {
+        writer.WriteVarU32(first - next);
+        writer.WriteVarU32(length - 1);
+        next = first + length;
+    });
+}
+
+bool ReadUnits(BitReader& reader, std::vector<u32>& outUnits)
+{
+    outUnits.clear();
+    const u32 count = reader.ReadVarU32();
+    if(count == 0)
+    {
+        return !reader.HasOverflowed();
+    }
+    if(count > NetInputMaxOrderUnits)
+    {
+        return false;
+    }
+
+    if(reader.ReadBool())
+    {
+        const u32 first = reader.ReadVarU32();
+        const u32 span = reader.ReadVarU32();
+        if(reader.HasOverflowed() || span > reader.GetBitsRemaining() || span < count)
+        {
+            return false;
+        }
+        for(u32 i = 0; i < span; i++)
+        {
+            if(reader.ReadBool())
+            {
+                outUnits.push_back(first + i);
+            }
+        }
+        return !reader.HasOverflowed() && outUnits.size() == count;
+    }
+
+    const u32 runs = reader.ReadVarU32();
+    if(runs > count)
+    {
+        return false;
+    }
+    u32 next = 0;
+    for(u32 run = 0; run < runs && !reader.HasOverflowed(); run++)
+    {
+        const u32 start = next + reader.ReadVarU32();
+        const u32 length = reader.ReadVarU32() + 1;
+        if(length > count - (u32)outUnits.size())
+        {
+            return false;
+        }
+        for(u32 i = 0; i < length; i++)
+        {
+            outUnits.push_back(start + i);
+        }
+        next = start + length;
+    }
+    return !reader.HasOverflowed() && outUnits.size() == count;
+}
+}
+
+void NetInputBuffer::Receive(const NetInputCommand& command)
+{
+    // Already simulated, or so far ahead it would overwrite commands still waiting
+    if((i32)(command.Sequence - LastProcessed) <= 0 || command.Sequence - LastProcessed > Size)
+    {
+        return;
+    }
+
+    const u32 slot = command.Sequence & (Size - 1);
+    Commands[slot] = command;
+    bValid[slot] = true;
+    if((i32)(command.Sequence - Newest) > 0)
+    {
+        Newest = command.Sequence;
+    }
+}
+
+bool NetInputBuffer::Pop(NetInputCommand& outCommand)
+{
+    for(u32 sequence = LastProcessed + 1; (i32)(sequence - Newest) <= 0; sequence++)
+    {
+        const u32 slot = sequence & (Size - 1);
+        if(bValid[slot] && Commands[slot].Sequence == sequence)
+        {
+            bValid[slot] = false;
+            outCommand = Commands[slot];
+            LastProcessed = sequence;
+            return true;
+        }
+
+        // A later command arrived without this one although every message repeats the last
+        // NetInputRedundancy commands, so it is gone for good
+        if(Newest - sequence < NetInputRedundancy)
+        {
+            return false;
+        }
+        LastProcessed = sequence;
+    }
+    return false;
+}
+
+u32 NetInputBuffer::GetConsumeCount() const
+{
+    const u32 buffered = GetBuffered();
+    return buffered > MaxBuffered ? buffered - MaxBuffered + 1 : 1;
+}
+
+void NetInputBuffer::Clear()
+{
+    for(bool& valid : bValid)
+    {
+        valid = false;
+    }
+    LastProcessed = 0;
+    Newest = 0;
+}
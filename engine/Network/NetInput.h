@@ -0,0 +1,96 @@
+#ifndef X_NET_INPUT_H
+#define X_NET_INPUT_H
+
+#include "../Core/defines.h"
+#include <entt.hpp>
+#include <vector>
+
+namespace Navigation
+{
+class TriangleNode;
+}
+struct CFollow;
+class BitReader;
+class BitWriter;
+
+// Client and server both advance controlled units in fixed steps of one input command each.
+constexpr f32 NetInputTickRate = 30.f;
+constexpr f32 NetInputTickDelta = 1.f / NetInputTickRate;
+// Unacknowledged commands repeated in every input message to ride out packet loss
+constexpr u32 NetInputRedundancy = 8;
+// Most units a single move order can name
+constexpr u32 NetInputMaxOrderUnits = 4096;
+// Ordered units further than this from the group's origin find a path of their own
+constexpr f32 NetInputGroupRadius = 64.f;
+
+// One simulation tick of player orders for the units the client owns.
+struct NetInputCommand
+{
+    u32 Sequence = 0;
+    bool bMove = false;
+    v2 Target = v2(0.f);
+    // Move orders are group orders: one path from Origin, the centre of the group, to Target
+    v2 Origin = v2(0.f);
+    // Network ids of the ordered units, sorted. Empty orders every unit the client owns.
+    std::vector<u32> Units;
+};
+
+namespace NetInput
+{
+// Whether a command orders the unit with this network id.
+bool IsOrdered(const NetInputCommand& command, u32 netId);
+
+// The one navigation query of a move order, shared by every unit in the group. Empty if the
+// origin or the target is off the mesh.
+std::vector<v2> FindGroupPath(const NetInputCommand& command, std::vector<Navigation::TriangleNode>* pTriangles);
+
+// Applies a command to one unit and advances it by one tick. Client prediction and the server run
+// exactly this, so the same commands give the same positions on both. pGroupPath is the command's
+// group path when it orders this unit and null otherwise. The unit heads straight for the second
+// waypoint and follows the group from there, or finds a path of its own if the group has none or
+// it is too far from the group's origin.
+void Simulate(const NetInputCommand& command, const std::vector<v2>* pGroupPath, CFollow& follow, v3& position,
+              std::vector<Navigation::TriangleNode>* pTriangles);
+
+// Rounds a move target to what the server receives, so prediction starts from the same point.
+v2 QuantizeTarget(const v2& target);
+
+// Sorted, unique unit ids as runs of consecutive ids with delta coded starts, or as a bitset over their
+// span when that is smaller. Units spawned together have consecutive ids, so a whole army is a few bytes.
+void WriteUnits(BitWriter& writer, const std::vector<u32>& units);
+bool ReadUnits(BitReader& reader, std::vector<u32>& outUnits);
+}
+
+// Server side: orders the commands received from one client and hands them out one per tick.
+class NetInputBuffer
+{
+    static constexpr u32 Size = 64;
+    // Commands allowed to queue up before the server starts consuming extra ones per tick
+    static constexpr u32 MaxBuffered = 3;
+
+    NetInputCommand Commands[Size];
+    bool bValid[Size] = {};
+    u32 LastProcessed = 0;
+    u32 Newest = 0;
+
+public:
+    void Receive(const NetInputCommand& command);
+
+    // Next command in sequence order. Commands lost beyond the redundancy window are skipped.
+    bool Pop(NetInputCommand& outCommand);
+
+    // How many commands to consume this tick so the buffer neither starves nor grows without bound.
+    [[nodiscard]] u32 GetConsumeCount() const;
+
+    [[nodiscard]] inline u32 GetLastProcessed() const { return LastProcessed; }
+    [[nodiscard]] inline u32 GetBuffered() const { return Newest - LastProcessed; }
+    void Clear();
+};
+
+namespace NetInput
+{
+// Server side: runs this tick's commands from one client on every unit it owns.
+void Consume(entt::registry& registry, u32 peerId, NetInputBuffer& buffer, std::vector<Navigation::TriangleNode>* pTriangles);
+}
+
+#endif //X_NET_INPUT_H
@@ -0,0 +1,200 @@
+#include "NetInterest.h"
+#include "../Components/NetworkComponent.h"
+#include "../Components/TransformComponent.h"
+#include <algorithm>
+#include <iterator>
+
+void NetSpatialGrid::RemoveFromCell(u64 cell, u32 netId)
+{
+    auto it = Cells.find(cell);
+    if(it == Cells.end())
+    {
+        return;
+    }
+
+    std::vector<u32>& ids = it->second;
+    if(auto id = std::find(ids.begin(), ids.end(), netId); id != ids.end())
+    {
+        *id = ids.back();
+        ids.pop_back();
+    }
+    if(ids.empty())
+    {
+        Cells.erase(it);
+    }
+}
+
+void NetSpatialGrid::Update(u32 netId, const v2& position)
+{
+    const u64 cell = GetCellKey(GetCellCoord(position.x), GetCellCoord(position.y));
+
+    auto [it, bInserted] = Entries.try_emplace(netId);
+    Entry& entry = it->second;
+    if(bInserted)
+    {
+        Cells[cell].push_back(netId);
+    }
+    else if(entry.Cell != cell)
+    {
+        RemoveFromCell(entry.Cell, netId);
+        Cells[cell].push_back(netId);
+    }
+    entry.Cell = cell;
+    entry.Position = position;
+}
+
+void NetSpatialGrid::Remove(u32 netId)
+{
+    auto it = Entries.find(netId);
+    if(it == Entries.end())
+    {
+        return;
+    }
+    RemoveFromCell(it->second.Cell, netId);
+    Entries.erase(it);
+}
+
+void NetSpatialGrid::Clear()
+{
+    Cells.clear();
+    Entries.clear();
+}
+
+void NetSpatialGrid::Sync(entt::registry& registry)
+{
+    std::vector<u32> alive;
+    alive.reserve(Entries.size());
+
+    auto view = registry.view<CNetwork, CTransform3d>();
+    for(entt::entity e : view)
+    {
+        const v3& position = view.get<CTransform3d>(e).WorldPosition;
+        const u32 netId = view.get<CNetwork>(e).Id;
+        Update(netId, {position.x, position.z});
+        alive.push_back(netId);
+    }
+
+    if(alive.size() == Entries.size())
+    {
+        return;
+    }
+
+    std::sort(alive.begin(), alive.end());
+    std::vector<u32> stale;
+    for(const auto& [netId, entry] : Entries)
+    {
+        if(!std::binary_search(alive.begin(), alive.end(), netId))
+        {
+            stale.push_back(netId);
+        }
+    }
+    for(u32 netId : stale)
+    {
+        Remove(netId);
+    }
+}
+
+bool NetSpatialGrid::GetPosition(u32 netId, v2& outPosition) const
+{
+    auto it = Entries.find(netId);
+    if(it == Entries.end())
+    {
+        return false;
+    }
+    outPosition = it->second.Position;
+    return true;
+}
+
+void NetInterestManager::SetCamera(u32 peerId, const v2& position)
+{
+    std::vector<v2>& viewers = Clients[peerId].Viewers;
+    if(viewers.empty())
+    {
+        viewers.push_back(position);
+    }
+    else
+    {
+        viewers[0] = position;
+    }
+}
+
+void NetInterestManager::AddViewer(u32 peerId, const v2& position)
+{
+    auto it = Clients.find(peerId);
+    if(it == Clients.end())
+    {
+        return;
+    }
+
+    std::vector<v2>& viewers = it->second.Viewers;
+    const f32 mergeSquared = Config.ViewerMergeDistance * Config.ViewerMergeDistance;
+    for(const v2& viewer : viewers)
+    {
+        v2 d = position - viewer;
+        if(d.x * d.x + d.y * d.y <= mergeSquared)
+        {
+            return;
+        }
+    }
+    viewers.push_back(position);
+}
+
+void NetInterestManager::ClearViewers(u32 peerId)
+{
+    if(auto it = Clients.find(peerId); it != Clients.end() && it->second.Viewers.size() > 1)
+    {
+        it->second.Viewers.resize(1);
+    }
+}
+
+void NetInterestManager::Update(u32 peerId, const NetSpatialGrid& grid, std::vector<u32>& outEntered, std::vector<u32>& outExited)
+{
+    outEntered.clear();
+    outExited.clear();
+
+    Client& client = Clients[peerId];
+    client.Next.clear();
+
+    const f32 enterSquared = Config.EnterRadius * Config.EnterRadius;
+    for(const v2& viewer : client.Viewers)
+    {
+        grid.Query(viewer, Config.ExitRadius, [&](u32 netId, const v2& position)
+        {
+            v2 d = position - viewer;
+            if(d.x * d.x + d.y * d.y <= enterSquared ||
+               std::binary_search(client.Relevant.begin(), client.Relevant.end(), netId))
+            {
+                client.Next.push_back(netId);
+            }
+        });
+    }
+
+    std::sort(client.Next.begin(), client.Next.end());
+    client.Next.erase(std::unique(client.Next.begin(), client.Next.end()), client.Next.end());
+
+    std::set_difference(client.Next.begin(), client.Next.end(), client.Relevant.begin(), client.Relevant.end(),
+                        std::back_inserter(outEntered));
+    std::set_difference(client.Relevant.begin(), client.Relevant.end(), client.Next.begin(), client.Next.end(),
+                        std::back_inserter(outExited));
+
+    std::swap(client.Relevant, client.Next);
+}
+
+const std::vector<u32>& NetInterestManager::GetRelevant(u32 peerId) const
+{
+    static const std::vector<u32> empty;
+    auto it = Clients.find(peerId);
+    return it != Clients.end() ? it->second.Relevant : empty;
+}
+
+const std::vector<v2>& NetInterestManager::GetViewers(u32 peerId) const
+{
+    static const std::vector<v2> empty;
+    auto it = Clients.find(peerId);
+    return it != Clients.end() ? it->second.Viewers : empty;
+}
+
+void NetInterestManager::RemoveClient(u32 peerId)
+{
+    Clients.erase(peerId);
+}
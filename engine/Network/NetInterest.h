@@ -0,0 +1,111 @@
+#ifndef X_NET_INTEREST_H
+#define X_NET_INTEREST_H
+
+#include "../Core/defines.h"
+#include <entt.hpp>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over the XZ plane holding every replicated entity by network id.
+class NetSpatialGrid
+{
+    struct Entry
+    {
+        u64 Cell = 0;
+        v2 Position = v2(0.f);
+    };
+
+    f32 CellSize;
+    std::unordered_map<u64, std::vector<u32>> Cells;
+    std::unordered_map<u32, Entry> Entries;
+
+    [[nodiscard]] u64 GetCellKey(i32 x, i32 y) const { return ((u64)(u32)x << 32) | (u32)y; }
+    [[nodiscard]] i32 GetCellCoord(f32 value) const { return (i32)std::floor(value / CellSize); }
+
+    void RemoveFromCell(u64 cell, u32 netId);
+
+public:
+    explicit NetSpatialGrid(f32 cellSize = 64.f) : CellSize(cellSize) {}
+
+    void Update(u32 netId, const v2& position);
+    void Remove(u32 netId);
+    void Clear();
+
+    // Inserts or moves every CNetwork entity with a transform and drops the ones that no longer exist.
+    void Sync(entt::registry& registry);
+
+    // Calls callback(netId, position) for every entity within radius of center.
+    template<typename F>
+    void Query(const v2& center, f32 radius, F&& callback) const
+    {
+        const f32 radiusSquared = radius * radius;
+        const i32 minX = GetCellCoord(center.x - radius), maxX = GetCellCoord(center.x + radius);
+        const i32 minY = GetCellCoord(center.y - radius), maxY = GetCellCoord(center.y + radius);
+        for(i32 x = minX; x <= maxX; x++)
+        {
+            for(i32 y = minY; y <= maxY; y++)
+            {
+                auto cell = Cells.find(GetCellKey(x, y));
+                if(cell == Cells.end())
+                {
+                    continue;
+                }
+                for(u32 netId : cell->second)
+                {
+                    const v2& position = Entries.at(netId).Position;
+                    v2 d = position - center;
+                    if(d.x * d.x + d.y * d.y <= radiusSquared)
+                    {
+                        callback(netId, position);
+                    }
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] bool GetPosition(u32 netId, v2& outPosition) const;
+    [[nodiscard]] inline size_t Size() const { return Entries.size(); }
+};
+
+struct NetInterestConfig
+{
+    // Entities become relevant inside EnterRadius of a viewer and stay relevant until they leave ExitRadius.
+    f32 EnterRadius = 300.f;
+    f32 ExitRadius = 360.f;
+    // A unit viewer this close to one already added is left out, a group moving together costs one query
+    f32 ViewerMergeDistance = 24.f;
+};
+
+// Tracks, per client, which replicated entities are relevant to it.
+class NetInterestManager
+{
+    struct Client
+    {
+        // The camera first, then the units the client controls
+        std::vector<v2> Viewers;
+        // Sorted by network id
+        std::vector<u32> Relevant;
+        std::vector<u32> Next;
+    };
+
+    NetInterestConfig Config;
+    std::unordered_map<u32, Client> Clients;
+
+public:
+    explicit NetInterestManager(const NetInterestConfig& config = NetInterestConfig()) : Config(config) {}
+
+    // Viewers are the camera and the units a client controls. The camera also registers the client, unit
+    // viewers of a client without one are ignored. Units move, so they are cleared and added every tick.
+    void SetCamera(u32 peerId, const v2& position);
+    void AddViewer(u32 peerId, const v2& position);
+    void ClearViewers(u32 peerId);
+
+    // Recomputes the relevant set and reports the ids that entered and exited it, both sorted.
+    void Update(u32 peerId, const NetSpatialGrid& grid, std::vector<u32>& outEntered, std::vector<u32>& outExited);
+
+    [[nodiscard]] const std::vector<u32>& GetRelevant(u32 peerId) const;
+    [[nodiscard]] const std::vector<v2>& GetViewers(u32 peerId) const;
+    void RemoveClient(u32 peerId);
+};
+
+#endif //X_NET_INTEREST_H
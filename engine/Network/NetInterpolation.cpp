@@ -0,0 +1,88 @@
+#include "NetInterpolation.h"
+#include "NetQuantize.h"
+#include "../Components/NetInterpolationComponent.h"
+#include "../Components/TransformComponent.h"
+#include <algorithm>
+
+namespace NetInterpolation
+{
+void Push(CNetInterpolation& buffer, f64 time, const CTransform3d& transform)
+{
+    if(buffer.Count > 0 && time <= buffer.Samples[buffer.Count - 1].Time)
+    {
+        return;
+    }
+
+    if(buffer.Count == CNetInterpolation::Capacity)
+    {
+        std::move(buffer.Samples + 1, buffer.Samples + buffer.Count, buffer.Samples);
+        buffer.Count--;
+    }
+
+    NetTransformSample& sample = buffer.Samples[buffer.Count++];
+    sample.Time = time;
+    sample.Position = transform.WorldPosition;
+    sample.Rotation = NetQuantize::EulerToQuat(transform.WorldRotation);
+    sample.Scale = transform.WorldScale;
+}
+
+static void Apply(CTransform3d& transform, const v3& position, const q4& rotation, const v3& scale)
+{
+    transform.WorldPosition = position;
+    transform.WorldRotation = NetQuantize::QuatToEuler(rotation);
+    transform.WorldScale = scale;
+}
+
+void Update(entt::registry& registry, f64 renderTime)
+{
+    auto view = registry.view<CNetInterpolation, CTransform3d>();
+    for(entt::entity e : view)
+    {
+        CNetInterpolation& buffer = view.get<CNetInterpolation>(e);
+        CTransform3d& transform = view.get<CTransform3d>(e);
+        if(buffer.Count == 0)
+        {
+            continue;
+        }
+
+        const NetTransformSample* samples = buffer.Samples;
+        const NetTransformSample& oldest = samples[0];
+        const NetTransformSample& newest = samples[buffer.Count - 1];
+
+        if(buffer.Count == 1 || renderTime <= oldest.Time)
+        {
+            Apply(transform, oldest.Position, oldest.Rotation, oldest.Scale);
+            continue;
+        }
+
+        if(renderTime >= newest.Time)
+        {
+            // Late packet, keep moving along the last known velocity for a short while
+            const NetTransformSample& previous = samples[buffer.Count - 2];
+            f64 span = newest.Time - previous.Time;
+            f32 t = (f32)(std::min(renderTime - newest.Time, MaxExtrapolation) / span);
+            Apply(transform, newest.Position + (newest.Position - previous.Position) * t,
+                  newest.Rotation, newest.Scale);
+            continue;
+        }
+
+        u32 next = 1;
+        while(samples[next].Time < renderTime)
+        {
+            next++;
+        }
+
+        const NetTransformSample& a = samples[next - 1];
+        const NetTransformSample& b = samples[next];
+        f32 t = (f32)((renderTime - a.Time) / (b.Time - a.Time));
+        Apply(transform, glm::mix(a.Position, b.Position, t), glm::slerp(a.Rotation, b.Rotation, t), glm::mix(a.Scale, b.Scale, t));
+
+        // Samples before a are no longer needed
+        if(next > 1)
+        {
+            std::move(buffer.Samples + next - 1, buffer.Samples + buffer.Count, buffer.Samples);
+            buffer.Count -= next - 1;
+        }
+    }
+}
+}
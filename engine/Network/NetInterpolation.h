@@ -0,0 +1,22 @@
+#ifndef X_NET_INTERPOLATION_H
+#define X_NET_INTERPOLATION_H
+
+#include "../Core/defines.h"
+#include <entt.hpp>
+
+struct CTransform3d;
+struct CNetInterpolation;
+
+namespace NetInterpolation
+{
+constexpr f64 MaxExtrapolation = 0.25;
+
+// Appends a server timestamped transform, samples older than the newest one are ignored.
+void Push(CNetInterpolation& buffer, f64 time, const CTransform3d& transform);
+
+// Writes the interpolated state at renderTime into every buffered entity's transform,
+// extrapolating for at most MaxExtrapolation seconds when the next sample is late.
+void Update(entt::registry& registry, f64 renderTime);
+}
+
+#endif //X_NET_INTERPOLATION_H
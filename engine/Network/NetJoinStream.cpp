@@ -0,0 +1,88 @@
+#include "NetJoinStream.h"
+#include <algorithm>
+
+void NetJoinStream::Add(u32 netId, f32 distance)
+{
+    if(Pending.insert(netId).second)
+    {
+        Queue.push_back(Entry{netId, distance});
+    }
+}
+
+void NetJoinStream::Sort()
+{
+    // Drop what was removed while we are at it
+    Queue.erase(std::remove_if(Queue.begin(), Queue.end(), [this](const Entry& entry) { return !IsPending(entry.NetId); }), Queue.end());
+    std::sort(Queue.begin(), Queue.end(), [](const Entry& a, const Entry& b)
+    {
+        return a.Distance != b.Distance ? a.Distance > b.Distance : a.NetId > b.NetId;
+    });
+}
+
+bool NetJoinStream::Remove(u32 netId)
+{
+    return Pending.erase(netId) != 0;
+}
+
+void NetJoinStream::Clear()
+{
+    Queue.clear();
+    Pending.clear();
+    Budget = 0;
+}
+
+bool NetJoinStream::Refill(const NetJoinStreamConfig& config)
+{
+    if(!IsActive())
+    {
+        Budget = 0;
+        return false;
+    }
+    Budget = std::min(Budget + (i32)config.BytesPerTick, 2 * (i32)config.BytesPerTick);
+    return HasBudget();
+}
+
+void NetJoinStream::Next(u32 count, std::vector<u32>& outChunk)
+{
+    outChunk.clear();
+    while(!Queue.empty() && outChunk.size() < count)
+    {
+        const u32 netId = Queue.back().NetId;
+        Queue.pop_back();
+        if(Pending.erase(netId))
+        {
+            outChunk.push_back(netId);
+        }
+    }
+    std::sort(outChunk.begin(), outChunk.end());
+}
+
+namespace NetJoinStreamCodec
+{
+void WriteHeader(BitWriter& writer, u32 remaining, u32 count)
+{
+    writer.WriteVarU32(remaining);
+    writer.WriteVarU32(count);
+}
+
+bool ReadHeader(BitReader& reader, u32& outRemaining, u32& outCount)
+{
+    outRemaining = reader.ReadVarU32();
+    outCount = reader.ReadVarU32();
+    return !reader.HasOverflowed();
+}
+
+void WriteEntity(BitWriter& writer, const NetEntityState& state, bool bOwned, const NetEntityState& previous)
+{
+    writer.WriteVarU32(state.NetId - previous.NetId);
+    writer.WriteBool(bOwned);
+    NetSnapshotCodec::WriteState(writer, state, previous);
+}
+
+bool ReadEntity(BitReader& reader, const NetEntityState& previous, NetEntityState& outState, bool& outOwned)
+{
+    outState.NetId = previous.NetId + reader.ReadVarU32();
+    outOwned = reader.ReadBool();
+    return NetSnapshotCodec::ReadState(reader, previous, outState);
+}
+}
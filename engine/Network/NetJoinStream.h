@@ -0,0 +1,72 @@
+#ifndef X_NET_JOIN_STREAM_H
+#define X_NET_JOIN_STREAM_H
+
+#include "../Core/defines.h"
+#include "BitStream.h"
+#include "NetSnapshot.h"
+#include <unordered_set>
+#include <vector>
+
+struct NetJoinStreamConfig
+{
+    // Entities entering a client's relevant set in one tick that make it stream them instead of spawning each one
+    u32 MinEntities = 64;
+    // Stream payload per client and tick, on top of the snapshot budget. Unspent budget carries over one tick.
+    u32 BytesPerTick = 2400;
+    // Entities per chunk, which bounds what a client applies at once
+    u32 ChunkEntities = 128;
+};
+
+// Server side, per client: entities that became relevant in a burst, such as the whole world on joining,
+// waiting to be sent in WorldChunk messages. Owned units come first, then the nearest to a viewer. Each
+// chunk is serialized from the world as it is when the chunk goes out, so a pending entity can never arrive
+// stale, and snapshots and component updates leave pending entities alone until then.
+class NetJoinStream
+{
+    struct Entry
+    {
+        u32 NetId = 0;
+        f32 Distance = 0.f;
+    };
+
+    // Farthest first, so the next chunk comes off the back. Ids no longer in Pending are skipped.
+    std::vector<Entry> Queue;
+    std::unordered_set<u32> Pending;
+    i32 Budget = 0;
+
+public:
+    // distance orders the stream, negative for owned units
+    void Add(u32 netId, f32 distance);
+    // Restores nearest-first order after a run of Add.
+    void Sort();
+    // Returns false if the entity was not pending, so the client knows it and needs a kill.
+    bool Remove(u32 netId);
+    void Clear();
+
+    // Adds one tick of budget and reports whether the next chunk may be sent.
+    bool Refill(const NetJoinStreamConfig& config);
+    [[nodiscard]] inline bool HasBudget() const { return Budget > 0; }
+    inline void Spend(u32 bytes) { Budget -= (i32)bytes; }
+
+    // Takes up to count of the nearest pending entities, sorted by NetId.
+    void Next(u32 count, std::vector<u32>& outChunk);
+
+    [[nodiscard]] inline bool IsActive() const { return !Pending.empty(); }
+    [[nodiscard]] inline bool IsPending(u32 netId) const { return Pending.count(netId) != 0; }
+    [[nodiscard]] inline u32 GetRemaining() const { return (u32)Pending.size(); }
+};
+
+// WorldChunk message body: the entities still pending after this chunk, then every entity of the chunk in
+// NetId order with its id delta, ownership and transform coded against the entity before it, then an
+// AddComponent body with their components.
+namespace NetJoinStreamCodec
+{
+void WriteHeader(BitWriter& writer, u32 remaining, u32 count);
+bool ReadHeader(BitReader& reader, u32& outRemaining, u32& outCount);
+
+// previous is the entity written before, zero for the first one of a chunk.
+void WriteEntity(BitWriter& writer, const NetEntityState& state, bool bOwned, const NetEntityState& previous);
+bool ReadEntity(BitReader& reader, const NetEntityState& previous, NetEntityState& outState, bool& outOwned);
+}
+
+#endif //X_NET_JOIN_STREAM_H
@@ -0,0 +1,157 @@
+#include "NetLagCompensation.h"
+#include "../Components/NetworkComponent.h"
+#include "../Components/TransformComponent.h"
+#include <algorithm>
+
+NetTransformHistory::NetTransformHistory(const NetHistoryConfig& config) : Config(config)
+{
+    // One frame per tick of the rewind window plus the newest
+    Frames.resize((u32)std::ceil(Config.MaxRewindSeconds * Config.TickRate) + 1);
+    BucketCursor.resize(Config.BucketCount);
+}
+
+i32 NetTransformHistory::Find(const Frame& frame, u32 netId)
+{
+    auto it = std::lower_bound(frame.NetIds.begin(), frame.NetIds.end(), netId);
+    return it != frame.NetIds.end() && *it == netId ? (i32)(it - frame.NetIds.begin()) : -1;
+}
+
+void NetTransformHistory::Record(const entt::registry& registry, u32 timeMs)
+{
+    Scratch.clear();
+    auto view = registry.view<const CNetwork, const CTransform3d>();
+    for(auto [e, network, transform] : view.each())
+    {
+        Scratch.push_back({network.Id, transform.WorldPosition});
+    }
+    std::sort(Scratch.begin(), Scratch.end(), [](const Sample& a, const Sample& b) { return a.NetId < b.NetId; });
+
+    const Frame* previous = Count > 0 ? &Frames[Newest] : nullptr;
+    Newest = Count > 0 ? (Newest + 1) % (u32)Frames.size() : 0;
+    Count = std::min(Count + 1, (u32)Frames.size());
+    Frame& frame = Frames[Newest];
+    frame.TimeMs = timeMs;
+
+    const u32 count = (u32)Scratch.size();
+    frame.NetIds.resize(count);
+    frame.X.resize(count);
+    frame.Y.resize(count);
+    frame.Z.resize(count);
+    for(u32 i = 0; i < count; i++)
+    {
+        frame.NetIds[i] = Scratch[i].NetId;
+        frame.X[i] = Scratch[i].Position.x;
+        frame.Y[i] = Scratch[i].Position.y;
+        frame.Z[i] = Scratch[i].Position.z;
+    }
+
+    // Both frames are sorted by id, so matching them up is a single merge
+    f32 maxMoveSquared = 0.f;
+    if(previous && previous != &frame)
+    {
+        u32 j = 0;
+        for(u32 i = 0; i < count; i++)
+        {
+            while(j < previous->NetIds.size() && previous->NetIds[j] < frame.NetIds[i])
+            {
+                j++;
+            }
+            if(j < previous->NetIds.size() && previous->NetIds[j] == frame.NetIds[i])
+            {
+                const f32 dx = frame.X[i] - previous->X[j], dz = frame.Z[i] - previous->Z[j];
+                maxMoveSquared = std::max(maxMoveSquared, dx * dx + dz * dz);
+            }
+        }
+    }
+    frame.MaxMove = std::sqrt(maxMoveSquared);
+
+    // Counting sort into buckets
+    frame.BucketStart.assign(Config.BucketCount + 1, 0);
+    for(u32 i = 0; i < count; i++)
+    {
+        frame.BucketStart[GetBucket(GetCell(frame.X[i]), GetCell(frame.Z[i])) + 1]++;
+    }
+    for(u32 bucket = 0; bucket < Config.BucketCount; bucket++)
+    {
+        frame.BucketStart[bucket + 1] += frame.BucketStart[bucket];
+        BucketCursor[bucket] = frame.BucketStart[bucket];
+    }
+    frame.BucketEntries.resize(count);
+    for(u32 i = 0; i < count; i++)
+    {
+        frame.BucketEntries[BucketCursor[GetBucket(GetCell(frame.X[i]), GetCell(frame.Z[i]))]++] = i;
+    }
+}
+
+void NetTransformHistory::Clear()
+{
+    Newest = 0;
+    Count = 0;
+}
+
+f32 NetTransformHistory::GetFrames(u32 timeMs, const Frame*& outOlder, const Frame*& outNewer) const
+{
+    outOlder = outNewer = nullptr;
+    if(Count == 0)
+    {
+        return 0.f;
+    }
+
+    timeMs = ClampTime(timeMs);
+    outNewer = &GetFrame(0);
+    for(u32 age = 0; age < Count; age++)
+    {
+        const Frame& frame = GetFrame(age);
+        if((i32)(frame.TimeMs - timeMs) <= 0)
+        {
+            outOlder = &frame;
+            break;
+        }
+        outNewer = &frame;
+    }
+    if(!outOlder || outOlder == outNewer)
+    {
+        outOlder = outNewer;
+        return 0.f;
+    }
+    return (f32)(timeMs - outOlder->TimeMs) / (f32)(outNewer->TimeMs - outOlder->TimeMs);
+}
+
+bool NetTransformHistory::GetPosition(u32 netId, u32 timeMs, v3& outPosition) const
+{
+    const Frame* older;
+    const Frame* newer;
+    const f32 alpha = GetFrames(timeMs, older, newer);
+    const i32 index = older ? Find(*older, netId) : -1;
+    if(index < 0)
+    {
+        return false;
+    }
+
+    outPosition = v3(older->X[index], older->Y[index], older->Z[index]);
+    const i32 next = older != newer ? Find(*newer, netId) : -1;
+    if(next >= 0)
+    {
+        outPosition += (v3(newer->X[next], newer->Y[next], newer->Z[next]) - outPosition) * alpha;
+    }
+    return true;
+}
+
+u32 NetTransformHistory::ClampTime(u32 timeMs) const
+{
+    if(Count == 0)
+    {
+        return timeMs;
+    }
+    const u32 oldest = GetOldestTimeMs(), newest = GetNewestTimeMs();
+    if((i32)(timeMs - oldest) < 0)
+    {
+        return oldest;
+    }
+    return (i32)(timeMs - newest) > 0 ? newest : timeMs;
+}
+
+u32 NetTransformHistory::GetOldestTimeMs() const
+{
+    return Count > 0 ? GetFrame(Count - 1).TimeMs : 0;
+}
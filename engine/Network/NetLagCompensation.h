@@ -0,0 +1,148 @@
+#ifndef X_NET_LAG_COMPENSATION_H
+#define X_NET_LAG_COMPENSATION_H
+
+#include "../Core/defines.h"
+#include <entt.hpp>
+#include "NetInput.h"
+#include <cmath>
+#include <vector>
+
+struct NetHistoryConfig
+{
+    // Oldest view time a query can ask for, older ones are clamped so that lag can not be abused
+    f32 MaxRewindSeconds = 1.f;
+    f32 TickRate = NetInputTickRate;
+    // Spatial hash of every frame
+    f32 CellSize = 32.f;
+    // Power of two
+    u32 BucketCount = 4096;
+};
+
+// World positions of every replicated entity over the last ticks, so that authoritative checks can see
+// the world as a lagging client saw it. Each tick is one frame in a fixed ring: positions stored as
+// separate arrays sorted by network id, plus a spatial hash of that frame. Queries between two frames
+// interpolate like the client does. Nothing allocates once every frame has seen the peak entity count.
+class NetTransformHistory
+{
+    struct Frame
+    {
+        u32 TimeMs = 0;
+        std::vector<u32> NetIds;
+        std::vector<f32> X;
+        std::vector<f32> Y;
+        std::vector<f32> Z;
+        // Entity indices grouped by bucket, the bucket's range starts at BucketStart[bucket]
+        std::vector<u32> BucketStart;
+        std::vector<u32> BucketEntries;
+        // Furthest any entity moved on the XZ plane since the frame before
+        f32 MaxMove = 0.f;
+    };
+
+    NetHistoryConfig Config;
+    std::vector<Frame> Frames;
+    u32 Newest = 0;
+    u32 Count = 0;
+
+    struct Sample
+    {
+        u32 NetId;
+        v3 Position;
+    };
+    std::vector<Sample> Scratch;
+    std::vector<u32> BucketCursor;
+
+    [[nodiscard]] inline i32 GetCell(f32 value) const { return (i32)std::floor(value / Config.CellSize); }
+    [[nodiscard]] inline u32 GetBucket(i32 x, i32 z) const
+    {
+        return ((u32)x * 73856093u ^ (u32)z * 19349663u) & (Config.BucketCount - 1);
+    }
+    [[nodiscard]] inline const Frame& GetFrame(u32 age) const { return Frames[(Newest + (u32)Frames.size() - age) % Frames.size()]; }
+
+    // Index of netId in frame or -1
+    [[nodiscard]] static i32 Find(const Frame& frame, u32 netId);
+
+    // The frames around timeMs: older is at or before it, newer after it or the same frame. Returns the
+    // blend factor from older to newer.
+    f32 GetFrames(u32 timeMs, const Frame*& outOlder, const Frame*& outNewer) const;
+
+public:
+    explicit NetTransformHistory(const NetHistoryConfig& config = NetHistoryConfig());
+
+    // Appends the current positions of every entity with CNetwork and CTransform3d, overwriting the oldest frame.
+    void Record(const entt::registry& registry, u32 timeMs);
+    void Clear();
+
+    // Where netId was at timeMs. False if it was not replicated at the time.
+    bool GetPosition(u32 netId, u32 timeMs, v3& outPosition) const;
+
+    // Calls callback(netId, position) for every entity that was within radius of center on the XZ plane at timeMs.
+    template<typename F>
+    void Query(u32 timeMs, const v2& center, f32 radius, F&& callback) const
+    {
+        const Frame* older;
+        const Frame* newer;
+        const f32 alpha = GetFrames(timeMs, older, newer);
+        if(!older)
+        {
+            return;
+        }
+
+        // Candidates come from the older frame, searched wide enough to catch anything that moved into range
+        const f32 searchRadius = radius + (older != newer ? newer->MaxMove : 0.f);
+        const f32 radiusSquared = radius * radius;
+        auto visit = [&](u32 index)
+        {
+            v3 position(older->X[index], older->Y[index], older->Z[index]);
+            if(older != newer)
+            {
+                const i32 next = Find(*newer, older->NetIds[index]);
+                if(next >= 0)
+                {
+                    position += (v3(newer->X[next], newer->Y[next], newer->Z[next]) - position) * alpha;
+                }
+            }
+            const f32 dx = position.x - center.x, dz = position.z - center.y;
+            if(dx * dx + dz * dz <= radiusSquared)
+            {
+                callback(older->NetIds[index], position);
+            }
+        };
+
+        const i32 minX = GetCell(center.x - searchRadius), maxX = GetCell(center.x + searchRadius);
+        const i32 minZ = GetCell(center.y - searchRadius), maxZ = GetCell(center.y + searchRadius);
+        if((u64)(maxX - minX + 1) * (u64)(maxZ - minZ + 1) >= Config.BucketCount)
+        {
+            for(u32 i = 0; i < (u32)older->NetIds.size(); i++)
+            {
+                visit(i);
+            }
+            return;
+        }
+
+        for(i32 x = minX; x <= maxX; x++)
+        {
+            for(i32 z = minZ; z <= maxZ; z++)
+            {
+                const u32 bucket = GetBucket(x, z);
+                for(u32 i = older->BucketStart[bucket]; i < older->BucketStart[bucket + 1]; i++)
+                {
+                    // Other cells share the bucket, visit each entity from its own cell only
+                    const u32 index = older->BucketEntries[i];
+                    if(GetCell(older->X[index]) == x && GetCell(older->Z[index]) == z)
+                    {
+                        visit(index);
+                    }
+                }
+            }
+        }
+    }
+
+    // Clamps a client's view time into the recorded window.
+    [[nodiscard]] u32 ClampTime(u32 timeMs) const;
+
+    [[nodiscard]] u32 GetOldestTimeMs() const;
+    [[nodiscard]] inline u32 GetNewestTimeMs() const { return Count > 0 ? Frames[Newest].TimeMs : 0; }
+    [[nodiscard]] inline u32 GetFrameCount() const { return Count; }
+};
+
+#endif //X_NET_LAG_COMPENSATION_H
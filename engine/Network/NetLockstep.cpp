@@ -0,0 +1,239 @@
+#include "NetLockstep.h"
+#include "NetMsgType.h"
+#include "../Navigation/PathFollow.h"
+
+// Distance a unit covers in one tick, Navigation::FollowSpeed / NetInputTickRate
+static constexpr Fixed LockstepStepDistance = Fixed::FromRatio(50, 30);
+static constexpr Fixed LockstepSlotSpacing = Fixed::FromInt(2);
+
+void NetLockstepSim::Start(u32 seed, u32 playerCount, u32 unitsPerPlayer, std::vector<Navigation::TriangleNode>* triangles)
+{
+    PlayerCount = playerCount;
+    UnitsPerPlayer = unitsPerPlayer;
+    Turn = 0;
+    pTriangles = triangles && !triangles->empty() ? triangles : nullptr;
+
+    // Square formation around the path, slot 0 in the middle of the first row
+    u32 side = 1;
+    while(side * side < unitsPerPlayer)
+    {
+        side++;
+    }
+    Slots.resize(unitsPerPlayer);
+    for(u32 i = 0; i < unitsPerPlayer; i++)
+    {
+        Slots[i] = {LockstepSlotSpacing * Fixed::FromInt((i32)(i % side) - (i32)side / 2),
+                    LockstepSlotSpacing * Fixed::FromInt((i32)(i / side) - (i32)side / 2)};
+    }
+
+    std::vector<const Navigation::TriangleNode*> walkable;
+    if(pTriangles)
+    {
+        for(const Navigation::TriangleNode& node : *pTriangles)
+        {
+            if(!node.IsBlocked())
+            {
+                walkable.push_back(&node);
+            }
+        }
+    }
+    Centers.resize(playerCount);
+    for(u32 player = 0; player < playerCount; player++)
+    {
+        if(walkable.empty())
+        {
+            Centers[player] = {Fixed::FromInt((i32)(player % 8) * 200), Fixed::FromInt((i32)(player / 8) * 200)};
+            continue;
+        }
+        // Same stride as the server's spawn points so players land apart
+        const Triangle2D& triangle = walkable[((seed + player) * 7919u) % walkable.size()]->GetTriangle();
+        Centers[player] = FixedVec2::FromFloat((triangle.vertices[0] + triangle.vertices[1] + triangle.vertices[2]) / 3.f);
+    }
+
+    Paths.assign(playerCount, {});
+    Positions.resize((size_t)playerCount * unitsPerPlayer);
+    PathIndices.assign(Positions.size(), 0);
+    for(u32 i = 0; i < (u32)Positions.size(); i++)
+    {
+        Positions[i] = Centers[i / unitsPerPlayer] + Slots[i % unitsPerPlayer];
+    }
+}
+
+void NetLockstepSim::ExecuteTurn(const NetLockstepCommand* commands)
+{
+    for(u32 player = 0; player < PlayerCount; player++)
+    {
+        if(commands[player].bMove)
+        {
+            Order(player, commands[player].Target);
+        }
+    }
+    for(u32 tick = 0; tick < NetLockstepTurnTicks; tick++)
+    {
+        Step();
+    }
+    Turn++;
+}
+
+void NetLockstepSim::Order(u32 player, const FixedVec2& target)
+{
+    if(!pTriangles || UnitsPerPlayer == 0)
+    {
+        return;
+    }
+
+    const u32 first = player * UnitsPerPlayer;
+    i64 sumX = 0, sumY = 0;
+    for(u32 i = first; i < first + UnitsPerPlayer; i++)
+    {
+        sumX += Positions[i].x.Raw;
+        sumY += Positions[i].y.Raw;
+    }
+    const FixedVec2 center = {Fixed::FromRaw((i32)(sumX / UnitsPerPlayer)), Fixed::FromRaw((i32)(sumY / UnitsPerPlayer))};
+
+    const std::vector<v2> path = Navigation::FindPath(center.ToFloat(), target.ToFloat(), *pTriangles);
+    if(path.size() < 2)
+    {
+        return;
+    }
+
+    std::vector<FixedVec2>& fixedPath = Paths[player];
+    fixedPath.resize(path.size());
+    for(size_t i = 0; i < path.size(); i++)
+    {
+        fixedPath[i] = FixedVec2::FromFloat(path[i]);
+    }
+    for(u32 i = first; i < first + UnitsPerPlayer; i++)
+    {
+        PathIndices[i] = 1;
+    }
+}
+
+void NetLockstepSim::Step()
+{
+    for(u32 i = 0; i < (u32)Positions.size(); i++)
+    {
+        const std::vector<FixedVec2>& path = Paths[i / UnitsPerPlayer];
+        const FixedVec2& slot = Slots[i % UnitsPerPlayer];
+        FixedVec2& position = Positions[i];
+        u32& index = PathIndices[i];
+
+        // Same walk as Navigation::StepFollow: never overshoot a waypoint, spend what is left on the next
+        Fixed distance = LockstepStepDistance;
+        while(index != 0 && distance > Fixed())
+        {
+            const FixedVec2 target = path[index] + slot;
+            const FixedVec2 delta = target - position;
+            const Fixed remaining = FixedMath::Length(delta);
+            if(remaining > distance)
+            {
+                position.x += Fixed::FromRaw((i32)((i64)delta.x.Raw * distance.Raw / remaining.Raw));
+                position.y += Fixed::FromRaw((i32)((i64)delta.y.Raw * distance.Raw / remaining.Raw));
+                break;
+            }
+
+            position = target;
+            distance -= remaining;
+            index = index + 1 < (u32)path.size() ? index + 1 : 0;
+        }
+    }
+}
+
+u64 NetLockstepSim::Hash() const
+{
+    u64 hash = 14695981039346656037ull;
+    auto mix = [&hash](u32 value)
+    {
+        for(u32 shift = 0; shift < 32; shift += 8)
+        {
+            hash = (hash ^ ((value >> shift) & 0xFF)) * 1099511628211ull;
+        }
+    };
+
+    mix(Turn);
+    for(size_t i = 0; i < Positions.size(); i++)
+    {
+        mix((u32)Positions[i].x.Raw);
+        mix((u32)Positions[i].y.Raw);
+        mix(PathIndices[i]);
+    }
+    return hash;
+}
+
+void NetLockstepSession::Start(u32 seed, u32 playerCount, u32 playerIndex, u32 unitsPerPlayer,
+                               std::vector<Navigation::TriangleNode>* triangles)
+{
+    Stop();
+    Sim.Start(seed, playerCount, unitsPerPlayer, triangles);
+    PlayerIndex = playerIndex;
+    bStarted = true;
+}
+
+void NetLockstepSession::Stop()
+{
+    bStarted = false;
+    for(BufferedTurn& turn : Turns)
+    {
+        turn.bValid = false;
+    }
+    Queued = NetLockstepCommand();
+    bDesynced = false;
+    DesyncTurn = 0;
+}
+
+void NetLockstepSession::ReceiveTurn(u32 turn, const NetLockstepCommand* commands, u32 count)
+{
+    // Already run, or so far ahead it would overwrite a turn still waiting
+    if(!bStarted || turn < Sim.GetTurn() || turn - Sim.GetTurn() >= NetLockstepWindow)
+    {
+        return;
+    }
+
+    BufferedTurn& buffered = Turns[turn % NetLockstepWindow];
+    buffered.bValid = true;
+    buffered.Turn = turn;
+    for(u32 player = 0; player < NetLockstepMaxPlayers; player++)
+    {
+        buffered.Commands[player] = player < count ? commands[player] : NetLockstepCommand();
+    }
+}
+
+void NetLockstepSession::ReceiveDesync(u32 turn)
+{
+    if(!bDesynced)
+    {
+        bDesynced = true;
+        DesyncTurn = turn;
+    }
+}
+
+void NetLockstepSession::Order(const FixedVec2& target)
+{
+    Queued.bMove = true;
+    Queued.Target = target;
+}
+
+bool NetLockstepSession::Advance(NetLockstepInputMessage& outInput)
+{
+    if(!bStarted)
+    {
+        return false;
+    }
+
+    BufferedTurn& buffered = Turns[Sim.GetTurn() % NetLockstepWindow];
+    if(!buffered.bValid || buffered.Turn != Sim.GetTurn())
+    {
+        return false;
+    }
+
+    const u32 turn = Sim.GetTurn();
+    Sim.ExecuteTurn(buffered.Commands);
+    buffered.bValid = false;
+
+    outInput.Turn = turn + NetLockstepInputDelay;
+    outInput.Command = Queued;
+    outInput.HashTurn = turn;
+    outInput.Hash = Sim.Hash();
+    Queued = NetLockstepCommand();
+    return true;
+}
@@ -0,0 +1,114 @@
+#ifndef X_NET_LOCKSTEP_H
+#define X_NET_LOCKSTEP_H
+
+#include "../Core/defines.h"
+#include "../Core/Fixed.h"
+#include <vector>
+
+namespace Navigation
+{
+class TriangleNode;
+}
+struct NetLockstepInputMessage;
+
+// Lockstep turns span this many input ticks. Every peer runs the same turns on the same commands.
+constexpr u32 NetLockstepTurnTicks = 3;
+// Turns between issuing a command and running it, which has to cover the round trip to the server
+constexpr u32 NetLockstepInputDelay = 2;
+constexpr u32 NetLockstepMaxPlayers = 16;
+// Turns the client buffers ahead and the server keeps hashes for
+constexpr u32 NetLockstepWindow = 64;
+
+// One player's orders for one turn. Move targets are fixed point so that every peer paths to the same spot.
+struct NetLockstepCommand
+{
+    bool bMove = false;
+    FixedVec2 Target;
+};
+
+// The whole world of a lockstep match, identical on every peer that ran the same turns. Units are plain
+// arrays in spawn order, moved in fixed point. A move order paths once from the centre of the player's
+// units and every unit follows that path shifted by its formation slot.
+//
+// Path search runs on the float navigation mesh and its waypoints are rounded to fixed point. It only
+// uses IEEE basic arithmetic, which rounds the same on every machine as long as the compiler does not
+// contract or reorder it.
+class NetLockstepSim
+{
+    u32 PlayerCount = 0;
+    u32 UnitsPerPlayer = 0;
+    u32 Turn = 0;
+    std::vector<Navigation::TriangleNode>* pTriangles = nullptr;
+
+    std::vector<FixedVec2> Centers;
+    // Offset of every formation slot from the path, the same for every player
+    std::vector<FixedVec2> Slots;
+    std::vector<std::vector<FixedVec2>> Paths;
+
+    // Unit i belongs to player i / UnitsPerPlayer and stands in slot i % UnitsPerPlayer
+    std::vector<FixedVec2> Positions;
+    // Next waypoint of the owner's path, 0 when the unit stands still
+    std::vector<u32> PathIndices;
+
+    void Order(u32 player, const FixedVec2& target);
+    void Step();
+
+public:
+    // Spawns every player's units on the navigation mesh, spread by seed. Without a mesh units spawn
+    // on a grid and ignore orders.
+    void Start(u32 seed, u32 playerCount, u32 unitsPerPlayer, std::vector<Navigation::TriangleNode>* triangles);
+
+    // Applies one command per player and advances NetLockstepTurnTicks ticks.
+    void ExecuteTurn(const NetLockstepCommand* commands);
+
+    // FNV-1a over the turn number and every unit's state
+    [[nodiscard]] u64 Hash() const;
+
+    [[nodiscard]] inline u32 GetTurn() const { return Turn; }
+    [[nodiscard]] inline u32 GetPlayerCount() const { return PlayerCount; }
+    [[nodiscard]] inline u32 GetUnitCount() const { return (u32)Positions.size(); }
+    [[nodiscard]] inline const std::vector<FixedVec2>& GetPositions() const { return Positions; }
+    [[nodiscard]] inline const FixedVec2& GetSpawnCenter(u32 player) const { return Centers[player]; }
+};
+
+// Client side of a lockstep match: buffers the turns the server closed, runs them in order and reports
+// the state hash after each so the server can spot peers that drifted apart.
+class NetLockstepSession
+{
+    struct BufferedTurn
+    {
+        bool bValid = false;
+        u32 Turn = 0;
+        NetLockstepCommand Commands[NetLockstepMaxPlayers];
+    };
+
+    NetLockstepSim Sim;
+    bool bStarted = false;
+    u32 PlayerIndex = 0;
+    BufferedTurn Turns[NetLockstepWindow];
+    NetLockstepCommand Queued;
+    bool bDesynced = false;
+    u32 DesyncTurn = 0;
+
+public:
+    void Start(u32 seed, u32 playerCount, u32 playerIndex, u32 unitsPerPlayer, std::vector<Navigation::TriangleNode>* triangles);
+    void Stop();
+
+    void ReceiveTurn(u32 turn, const NetLockstepCommand* commands, u32 count);
+    void ReceiveDesync(u32 turn);
+
+    // Sent with the next input, replacing any order not sent yet.
+    void Order(const FixedVec2& target);
+
+    // Runs the next turn if it has arrived and fills outInput with the queued order, scheduled
+    // NetLockstepInputDelay turns ahead, and the hash after the turn. False if the turn is still missing.
+    bool Advance(NetLockstepInputMessage& outInput);
+
+    [[nodiscard]] inline bool IsStarted() const { return bStarted; }
+    [[nodiscard]] inline bool IsDesynced() const { return bDesynced; }
+    [[nodiscard]] inline u32 GetDesyncTurn() const { return DesyncTurn; }
+    [[nodiscard]] inline u32 GetPlayerIndex() const { return PlayerIndex; }
+    [[nodiscard]] inline const NetLockstepSim& GetSim() const { return Sim; }
+};
+
+#endif //X_NET_LOCKSTEP_H
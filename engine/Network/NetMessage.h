@@ -2,6 +2,11 @@
 #define X_NET_MESSAGE_H
 
 #include "../Core/defines.h"
+#include "BitStream.h"
+
+// Bumped whenever the wire layout of any message or the quantization settings change.
+constexpr u8 NetProtocolVersion = 17;
+constexpr u32 NetMaxMessageSize = 1024;
 
 enum class ENetMsg : u32
 {
@@ -9,9 +14,46 @@ enum class ENetMsg : u32
     SpawnEntity,
     KillEntity,
     UpdateEntity,
+    // Added or changed replicated components, see NetComponentRegistry
     AddComponent,
+    Snapshot,
+    Batch,
+    ViewUpdate,
+    Input,
+    // A typed call, see NetRpc
+    Rpc,
+    // A whole packet range coded with the connection's compression model, see NetCompression
+    Compressed,
+    // Lockstep mode, see NetLockstep
+    LockstepStart,
+    LockstepInput,
+    LockstepTurn,
+    LockstepDesync,
+    // Entities that became relevant in a burst, streamed in chunks, see NetJoinStream
+    WorldChunk,
+    // Sharded worlds, see NetZone
+    ZoneAttach,
+    ZoneGhosts,
+    ZoneHandoff,
+    Count,
+};
+
+// Every host opens these ENet channels. ENet orders reliable packets per channel and holds unreliable
+// ones back behind them, so keeping the three apart stops a lost reliable packet from delaying snapshots
+// and large transfers from delaying either.
+enum class ENetChannelId : u8
+{
+    // Reliable and ordered: spawns, kills, components
+    Reliable = 0,
+    // Unreliable and sequenced: snapshots, input, acks
+    Unreliable,
+    // Reliable, for large low-priority transfers
+    Bulk,
+    Count,
 };
 
+constexpr u8 NetChannelCount = (u8)ENetChannelId::Count;
+
 struct NetMessage
 {
     ENetMsg Type = ENetMsg::None;
@@ -19,4 +61,30 @@ struct NetMessage
     NetMessage(ENetMsg type = ENetMsg::None) : Type(type) {}
 };
 
+// Every packet starts with the protocol version and the message type, one byte each.
+inline void WriteNetHeader(BitWriter& writer, ENetMsg type)
+{
+    writer.WriteU8(NetProtocolVersion);
+    writer.WriteU8((u8)type);
+}
+
+inline bool ReadNetHeader(BitReader& reader, ENetMsg& outType)
+{
+    u8 version = reader.ReadU8();
+    outType = (ENetMsg)reader.ReadU8();
+    return !reader.HasOverflowed() && version == NetProtocolVersion &&
+           outType != ENetMsg::None && outType < ENetMsg::Count;
+}
+
+// Serializes a message with its header into buffer, returns the byte count or 0 if it did not fit.
+template<typename T>
+u32 WriteNetMessage(const T& message, u8* buffer, u32 capacity)
+{
+    BitWriter writer(buffer, capacity);
+    WriteNetHeader(writer, message.Type);
+    message.Serialize(writer);
+    writer.Flush();
+    return writer.HasOverflowed() ? 0 : writer.GetBytesWritten();
+}
+
 #endif //X_NET_MESSAGE_H
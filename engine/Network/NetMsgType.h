@@ -3,22 +3,329 @@
 
 #include "../Core/defines.h"
 #include "NetMessage.h"
+#include "NetQuantize.h"
+#include "NetInput.h"
+#include "NetLockstep.h"
+#include "NetRpc.h"
 #include "../Components/TransformComponent.h"
 
 struct NetSpawnMessage : public NetMessage
 {
     u32 EntityId;
     CTransform3d Transform;
-    NetSpawnMessage(u32 entity = 0, CTransform3d transform = CTransform3d()) : NetMessage(ENetMsg::SpawnEntity),
-        EntityId(entity), Transform(transform) {}
+    // Controlled by the receiving client, which predicts it instead of interpolating
+    bool bOwned;
+    NetSpawnMessage(u32 entity = 0, CTransform3d transform = CTransform3d(), bool owned = false) : NetMessage(ENetMsg::SpawnEntity),
+        EntityId(entity), Transform(transform), bOwned(owned) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        writer.WriteVarU32(EntityId);
+        writer.WriteBool(bOwned);
+        NetQuantize::WriteTransform(writer, Transform, true, GetNetQuantization());
+    }
+
+    bool Deserialize(BitReader& reader)
+    {
+        EntityId = reader.ReadVarU32();
+        bOwned = reader.ReadBool();
+        NetQuantize::ReadTransform(reader, Transform, GetNetQuantization());
+        return !reader.HasOverflowed();
+    }
 };
 
 struct NetUpdateMessage : public NetMessage
 {
     u32 EntityId;
     CTransform3d Transform;
-    NetUpdateMessage(u32 entity = 0, CTransform3d transform = CTransform3d()) : NetMessage(ENetMsg::UpdateEntity),
-        EntityId(entity), Transform(transform) {}
+    bool bScaleChanged;
+    NetUpdateMessage(u32 entity = 0, CTransform3d transform = CTransform3d(), bool scaleChanged = false) : NetMessage(ENetMsg::UpdateEntity),
+        EntityId(entity), Transform(transform), bScaleChanged(scaleChanged) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        writer.WriteVarU32(EntityId);
+        NetQuantize::WriteTransform(writer, Transform, bScaleChanged, GetNetQuantization());
+    }
+
+    bool Deserialize(BitReader& reader)
+    {
+        EntityId = reader.ReadVarU32();
+        bScaleChanged = NetQuantize::ReadTransform(reader, Transform, GetNetQuantization());
+        return !reader.HasOverflowed();
+    }
+};
+
+struct NetKillMessage : public NetMessage
+{
+    u32 EntityId;
+    NetKillMessage(u32 entity = 0) : NetMessage(ENetMsg::KillEntity), EntityId(entity) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        writer.WriteVarU32(EntityId);
+    }
+
+    bool Deserialize(BitReader& reader)
+    {
+        EntityId = reader.ReadVarU32();
+        return !reader.HasOverflowed();
+    }
+};
+
+// Client camera position, the server uses it to decide which entities are relevant to that client.
+struct NetViewMessage : public NetMessage
+{
+    v3 Position;
+    NetViewMessage(const v3& position = v3(0.f)) : NetMessage(ENetMsg::ViewUpdate), Position(position) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        NetQuantize::WritePosition(writer, Position, GetNetQuantization());
+    }
+
+    bool Deserialize(BitReader& reader)
+    {
+        Position = NetQuantize::ReadPosition(reader, GetNetQuantization());
+        return !reader.HasOverflowed();
+    }
+};
+
+// The newest input commands of a client, newest first. Every message repeats the commands the
+// server has not acknowledged yet, up to NetInputRedundancy, so losing one packet loses no input.
+struct NetInputMessage : public NetMessage
+{
+    NetInputCommand Commands[NetInputRedundancy];
+    u32 Count;
+    // Server time the client was rendering other entities at, for lag compensation
+    u32 ViewTimeMs;
+    NetInputMessage() : NetMessage(ENetMsg::Input), Count(0), ViewTimeMs(0) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        writer.WriteVarU32(Count > 0 ? Commands[0].Sequence : 0);
+        writer.WriteVarU32(ViewTimeMs);
+        writer.WriteBits(Count, 4);
+        for(u32 i = 0; i < Count; i++)
+        {
+            writer.WriteBool(Commands[i].bMove);
+            if(Commands[i].bMove)
+            {
+                WritePoint(writer, Commands[i].Target);
+                WritePoint(writer, Commands[i].Origin);
+                NetInput::WriteUnits(writer, Commands[i].Units);
+            }
+        }
+    }
+
+    bool Deserialize(BitReader& reader)
+    {
+        const u32 newest = reader.ReadVarU32();
+        ViewTimeMs = reader.ReadVarU32();
+        Count = reader.ReadBits(4);
+        if(Count > NetInputRedundancy)
+        {
+            return false;
+        }
+        for(u32 i = 0; i < Count; i++)
+        {
+            Commands[i].Sequence = newest - i;
+            Commands[i].bMove = reader.ReadBool();
+            Commands[i].Target = v2(0.f);
+            Commands[i].Origin = v2(0.f);
+            Commands[i].Units.clear();
+            if(Commands[i].bMove)
+            {
+                Commands[i].Target = ReadPoint(reader);
+                Commands[i].Origin = ReadPoint(reader);
+                if(!NetInput::ReadUnits(reader, Commands[i].Units))
+                {
+                    return false;
+                }
+            }
+        }
+        return !reader.HasOverflowed();
+    }
+
+private:
+    // A point on the ground, x and z of the world quantization
+    static void WritePoint(BitWriter& writer, const v2& point)
+    {
+        const NetQuantization& quantization = GetNetQuantization();
+        writer.WriteBits(NetQuantize::QuantizeFloat(point.x, quantization.WorldMin.x, quantization.WorldMax.x,
+                                                    quantization.GetPositionBits(0)), quantization.GetPositionBits(0));
+        writer.WriteBits(NetQuantize::QuantizeFloat(point.y, quantization.WorldMin.z, quantization.WorldMax.z,
+                                                    quantization.GetPositionBits(2)), quantization.GetPositionBits(2));
+    }
+
+    static v2 ReadPoint(BitReader& reader)
+    {
+        const NetQuantization& quantization = GetNetQuantization();
+        const f32 x = NetQuantize::DequantizeFloat(reader.ReadBits(quantization.GetPositionBits(0)), quantization.WorldMin.x,
+                                                   quantization.WorldMax.x, quantization.GetPositionBits(0));
+        const f32 z = NetQuantize::DequantizeFloat(reader.ReadBits(quantization.GetPositionBits(2)), quantization.WorldMin.z,
+                                                   quantization.WorldMax.z, quantization.GetPositionBits(2));
+        return {x, z};
+    }
+};
+
+namespace NetLockstepWire
+{
+inline void WriteCommand(BitWriter& writer, const NetLockstepCommand& command)
+{
+    writer.WriteBool(command.bMove);
+    if(command.bMove)
+    {
+        writer.WriteU32((u32)command.Target.x.Raw);
+        writer.WriteU32((u32)command.Target.y.Raw);
+    }
+}
+
+inline void ReadCommand(BitReader& reader, NetLockstepCommand& command)
+{
+    command.bMove = reader.ReadBool();
+    command.Target = FixedVec2();
+    if(command.bMove)
+    {
+        command.Target.x = Fixed::FromRaw((i32)reader.ReadU32());
+        command.Target.y = Fixed::FromRaw((i32)reader.ReadU32());
+    }
+}
+}
+
+// Everything a client needs to build the same world as every other player in a lockstep match.
+struct NetLockstepStartMessage : public NetMessage
+{
+    u32 Seed;
+    u32 PlayerCount;
+    u32 PlayerIndex;
+    u32 UnitsPerPlayer;
+    NetLockstepStartMessage(u32 seed = 0, u32 playerCount = 0, u32 playerIndex = 0, u32 unitsPerPlayer = 0)
+        : NetMessage(ENetMsg::LockstepStart), Seed(seed), PlayerCount(playerCount), PlayerIndex(playerIndex), UnitsPerPlayer(unitsPerPlayer) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        writer.WriteU32(Seed);
+        writer.WriteBits(PlayerCount, 5);
+        writer.WriteBits(PlayerIndex, 4);
+        writer.WriteVarU32(UnitsPerPlayer);
+    }
+
+    bool Deserialize(BitReader& reader)
+    {
+        Seed = reader.ReadU32();
+        PlayerCount = reader.ReadBits(5);
+        PlayerIndex = reader.ReadBits(4);
+        UnitsPerPlayer = reader.ReadVarU32();
+        return !reader.HasOverflowed() && PlayerCount > 0 && PlayerCount <= NetLockstepMaxPlayers && PlayerIndex < PlayerCount;
+    }
+};
+
+// A client's command for a future turn and the state hash after a turn it ran.
+struct NetLockstepInputMessage : public NetMessage
+{
+    u32 Turn;
+    NetLockstepCommand Command;
+    u32 HashTurn;
+    u64 Hash;
+    NetLockstepInputMessage() : NetMessage(ENetMsg::LockstepInput), Turn(0), HashTurn(0), Hash(0) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        writer.WriteVarU32(Turn);
+        NetLockstepWire::WriteCommand(writer, Command);
+        writer.WriteVarU32(HashTurn);
+        writer.WriteU32((u32)Hash);
+        writer.WriteU32((u32)(Hash >> 32));
+    }
+
+    bool Deserialize(BitReader& reader)
+    {
+        Turn = reader.ReadVarU32();
+        NetLockstepWire::ReadCommand(reader, Command);
+        HashTurn = reader.ReadVarU32();
+        Hash = reader.ReadU32();
+        Hash |= (u64)reader.ReadU32() << 32;
+        return !reader.HasOverflowed();
+    }
+};
+
+// The commands of every player for one closed turn. The same for every client, whatever the unit count.
+struct NetLockstepTurnMessage : public NetMessage
+{
+    u32 Turn;
+    u32 Count;
+    NetLockstepCommand Commands[NetLockstepMaxPlayers];
+    NetLockstepTurnMessage() : NetMessage(ENetMsg::LockstepTurn), Turn(0), Count(0) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        writer.WriteVarU32(Turn);
+        writer.WriteBits(Count, 5);
+        for(u32 i = 0; i < Count; i++)
+        {
+            NetLockstepWire::WriteCommand(writer, Commands[i]);
+        }
+    }
+
+    bool Deserialize(BitReader& reader)
+    {
+        Turn = reader.ReadVarU32();
+        Count = reader.ReadBits(5);
+        if(Count > NetLockstepMaxPlayers)
+        {
+            return false;
+        }
+        for(u32 i = 0; i < Count; i++)
+        {
+            NetLockstepWire::ReadCommand(reader, Commands[i]);
+        }
+        return !reader.HasOverflowed();
+    }
+};
+
+// Two players reported different state hashes after Turn.
+struct NetLockstepDesyncMessage : public NetMessage
+{
+    u32 Turn;
+    NetLockstepDesyncMessage(u32 turn = 0) : NetMessage(ENetMsg::LockstepDesync), Turn(turn) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        writer.WriteVarU32(Turn);
+    }
+
+    bool Deserialize(BitReader& reader)
+    {
+        Turn = reader.ReadVarU32();
+        return !reader.HasOverflowed();
+    }
+};
+
+// Gateway to zone, on the connection of one client: start or stop replicating to it. On a transfer the
+// client comes from another zone and already has most of what this one would spawn.
+struct NetZoneAttachMessage : public NetMessage
+{
+    bool bAttached;
+    bool bTransfer;
+    v3 View;
+    NetZoneAttachMessage(bool attached = false, bool transfer = false, const v3& view = v3(0.f)) : NetMessage(ENetMsg::ZoneAttach),
+        bAttached(attached), bTransfer(transfer), View(view) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        writer.WriteBool(bAttached);
+        writer.WriteBool(bTransfer);
+        NetQuantize::WritePosition(writer, View, GetNetQuantization());
+    }
+
+    bool Deserialize(BitReader& reader)
+    {
+        bAttached = reader.ReadBool();
+        bTransfer = reader.ReadBool();
+        View = NetQuantize::ReadPosition(reader, GetNetQuantization());
+        return !reader.HasOverflowed();
+    }
 };
 
 #endif //X_NET_EVENT_H
@@ -0,0 +1,159 @@
+#include "NetPacketPool.h"
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+namespace NetPacketPool
+{
+// Keeps the memory handed out 16 byte aligned
+struct alignas(16) BlockHeader
+{
+    u32 SizeClass = 0;
+    BlockHeader* pNext = nullptr;
+};
+
+// Covers ENet's bookkeeping structs and anything up to an MTU sized packet
+static constexpr u32 SizeClasses[] = {64, 128, 256, 512, 1024, 2048};
+static constexpr u32 SizeClassCount = sizeof(SizeClasses) / sizeof(SizeClasses[0]);
+static constexpr u32 HeapClass = SizeClassCount;
+
+struct FreeList
+{
+    std::mutex Mutex;
+    BlockHeader* pHead = nullptr;
+};
+
+static FreeList FreeLists[SizeClassCount];
+static std::atomic<u64> PooledAllocations{0};
+static std::atomic<u64> BlocksCreated{0};
+static std::atomic<u64> HeapAllocations{0};
+
+static u32 GetSizeClass(size_t size)
+{
+    for(u32 i = 0; i < SizeClassCount; i++)
+    {
+        if(size <= SizeClasses[i])
+        {
+            return i;
+        }
+    }
+    return HeapClass;
+}
+
+static void* ENET_CALLBACK AllocateCallback(size_t size)
+{
+    return Allocate(size);
+}
+
+static void ENET_CALLBACK FreeCallback(void* memory)
+{
+    Free(memory);
+}
+
+static void ENET_CALLBACK NoMemoryCallback()
+{
+    abort();
+}
+
+static void ENET_CALLBACK ReleasePacketData(ENetPacket* packet)
+{
+    Free(packet->data);
+}
+
+i32 Initialize()
+{
+    ENetCallbacks callbacks{&AllocateCallback, &FreeCallback, &NoMemoryCallback};
+    return enet_initialize_with_callbacks(ENET_VERSION, &callbacks);
+}
+
+void* Allocate(size_t size)
+{
+    const u32 sizeClass = GetSizeClass(size);
+    BlockHeader* header = nullptr;
+    if(sizeClass == HeapClass)
+    {
+        header = (BlockHeader*)malloc(sizeof(BlockHeader) + size);
+        HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        {
+            FreeList& list = FreeLists[sizeClass];
+            std::lock_guard<std::mutex> lock(list.Mutex);
+            if((header = list.pHead))
+            {
+                list.pHead = header->pNext;
+            }
+        }
+        if(header)
+        {
+            PooledAllocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            header = (BlockHeader*)malloc(sizeof(BlockHeader) + SizeClasses[sizeClass]);
+            BlocksCreated.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if(!header)
+    {
+        return nullptr;
+    }
+    header->SizeClass = sizeClass;
+    header->pNext = nullptr;
+    return header + 1;
+}
+
+void Free(void* memory)
+{
+    if(!memory)
+    {
+        return;
+    }
+
+    BlockHeader* header = (BlockHeader*)memory - 1;
+    if(header->SizeClass == HeapClass)
+    {
+        free(header);
+        return;
+    }
+
+    FreeList& list = FreeLists[header->SizeClass];
+    std::lock_guard<std::mutex> lock(list.Mutex);
+    header->pNext = list.pHead;
+    list.pHead = header;
+}
+
+ENetPacket* Create(u32 capacity, u32 flags)
+{
+    if(GetSizeClass(capacity) == HeapClass)
+    {
+        return enet_packet_create(nullptr, capacity, flags);
+    }
+
+    void* data = Allocate(capacity);
+    if(!data)
+    {
+        return nullptr;
+    }
+
+    ENetPacket* packet = enet_packet_create(data, capacity, flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+    if(!packet)
+    {
+        Free(data);
+        return nullptr;
+    }
+    packet->freeCallback = &ReleasePacketData;
+    return packet;
+}
+
+NetPacketPoolStats GetStats()
+{
+    NetPacketPoolStats stats;
+    stats.PooledAllocations = PooledAllocations.load(std::memory_order_relaxed);
+    stats.BlocksCreated = BlocksCreated.load(std::memory_order_relaxed);
+    stats.HeapAllocations = HeapAllocations.load(std::memory_order_relaxed);
+    return stats;
+}
+}
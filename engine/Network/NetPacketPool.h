@@ -0,0 +1,35 @@
+#ifndef X_NET_PACKET_POOL_H
+#define X_NET_PACKET_POOL_H
+
+#include "../Core/defines.h"
+#include <../../vendor/enet/include/enet/enet.h>
+
+struct NetPacketPoolStats
+{
+    // Served from a free list
+    u64 PooledAllocations = 0;
+    // Size classes grow on demand until the working set is covered, steady state should add none
+    u64 BlocksCreated = 0;
+    // Too large for any size class
+    u64 HeapAllocations = 0;
+};
+
+// Size-class free lists shared by every ENet host in the process. Installed as ENet's allocator, so
+// packets, commands and acknowledgements are recycled instead of going to the heap every tick. Safe to
+// use from the game and network threads at once.
+namespace NetPacketPool
+{
+// Initializes ENet with the pooled allocator. Use instead of enet_initialize.
+i32 Initialize();
+
+void* Allocate(size_t size);
+void Free(void* memory);
+
+// A packet whose data is a pooled block of at least capacity bytes, written in place by the caller and
+// returned to the pool when ENet destroys the packet. The packet may be shrunk but never grown.
+ENetPacket* Create(u32 capacity, u32 flags);
+
+NetPacketPoolStats GetStats();
+}
+
+#endif //X_NET_PACKET_POOL_H
@@ -0,0 +1,242 @@
+#include "NetPrediction.h"
+#include "NetMsgType.h"
+#include "../Components/NetInterpolationComponent.h"
+#include "../Components/NetPredictedComponent.h"
+#include "../Components/NetworkComponent.h"
+#include "../Components/TransformComponent.h"
+#include <algorithm>
+#include <cmath>
+
+void NetPrediction::IssueMove(const v2& target)
+{
+    IssueMove(target, {});
+}
+
+void NetPrediction::IssueMove(const v2& target, std::vector<u32> units)
+{
+    std::sort(units.begin(), units.end());
+    units.erase(std::unique(units.begin(), units.end()), units.end());
+    if(units.size() > NetInputMaxOrderUnits)
+    {
+        units.resize(NetInputMaxOrderUnits);
+    }
+    bPendingMove = true;
+    PendingTarget = NetInput::QuantizeTarget(target);
+    PendingUnits = std::move(units);
+}
+
+void NetPrediction::Begin(CNetPredicted& unit, const v3& position) const
+{
+    unit.Position = position;
+    unit.PreviousPosition = position;
+    unit.ErrorOffset = v3(0.f);
+    unit.Follow = CFollow{};
+    unit.Paths.clear();
+
+    // The spawn state is the baseline for reconciling the commands issued from now on
+    Record(unit, Sequence, true);
+}
+
+void NetPrediction::SetOwned(entt::registry& registry, entt::entity e, bool bOwned) const
+{
+    if(!bOwned)
+    {
+        registry.remove<CNetPredicted>(e);
+        if(!registry.all_of<CNetInterpolation>(e))
+        {
+            registry.emplace<CNetInterpolation>(e);
+        }
+        return;
+    }
+
+    registry.remove<CNetInterpolation>(e);
+    if(!registry.all_of<CNetPredicted>(e))
+    {
+        CNetPredicted unit{};
+        Begin(unit, registry.get<CTransform3d>(e).WorldPosition);
+        registry.emplace<CNetPredicted>(e, std::move(unit));
+    }
+}
+
+void NetPrediction::Record(CNetPredicted& unit, u32 sequence, bool bOrdered) const
+{
+    if(bOrdered)
+    {
+        // A replay starts the same order again, from a corrected position its path may differ
+        auto it = std::find_if(unit.Paths.begin(), unit.Paths.end(), [sequence](const NetPredictedPath& path) { return path.Sequence == sequence; });
+        if(it == unit.Paths.end())
+        {
+            it = unit.Paths.insert(unit.Paths.end(), NetPredictedPath{sequence, {}});
+        }
+        it->Points = unit.Follow.StringPath;
+        unit.PathSequence = sequence;
+    }
+
+    // Paths older than the newest one a future reconcile can start from are never restored again
+    while(unit.Paths.size() > 1 && ((i32)(unit.Paths[1].Sequence - LastAcked) <= 0 || Sequence - unit.Paths[1].Sequence >= HistorySize - 1))
+    {
+        unit.Paths.erase(unit.Paths.begin());
+    }
+
+    NetPredictedState& state = unit.History[sequence & (CNetPredicted::HistorySize - 1)];
+    state.Sequence = sequence;
+    state.Position = unit.Position;
+    state.PathSequence = unit.PathSequence;
+    state.PathIndex = unit.Follow.index;
+    state.bFollow = unit.Follow.bFollow;
+}
+
+bool NetPrediction::Restore(CNetPredicted& unit, const NetPredictedState& state)
+{
+    auto it = std::find_if(unit.Paths.begin(), unit.Paths.end(), [&state](const NetPredictedPath& path) { return path.Sequence == state.PathSequence; });
+    if(it == unit.Paths.end())
+    {
+        return false;
+    }
+
+    if(unit.PathSequence != state.PathSequence)
+    {
+        unit.Follow.StringPath = it->Points;
+        unit.PathSequence = state.PathSequence;
+    }
+    unit.Follow.index = state.PathIndex;
+    unit.Follow.bFollow = state.bFollow;
+    if(state.bFollow)
+    {
+        unit.Follow.TargetPos = unit.Follow.StringPath[state.PathIndex];
+    }
+    return true;
+}
+
+void NetPrediction::Tick(entt::registry& registry)
+{
+    NetInputCommand& command = Commands[++Sequence & (HistorySize - 1)];
+    std::vector<v2>& path = Paths[Sequence & (HistorySize - 1)];
+    command.Sequence = Sequence;
+    command.bMove = bPendingMove;
+    command.Target = PendingTarget;
+    command.Units.clear();
+    path.clear();
+    bPendingMove = false;
+
+    auto view = registry.view<CNetPredicted, CNetwork>();
+    if(command.bMove)
+    {
+        command.Units.swap(PendingUnits);
+        // The group's path starts from its centre, sent along so the server queries the same path
+        v2 sum(0.f);
+        u32 count = 0;
+        for(entt::entity e : view)
+        {
+            if(NetInput::IsOrdered(command, view.get<CNetwork>(e).Id))
+            {
+                const v3& position = view.get<CNetPredicted>(e).Position;
+                sum += v2(position.x, position.z);
+                count++;
+            }
+        }
+        command.Origin = count > 0 ? NetInput::QuantizeTarget(sum / (f32)count) : command.Target;
+        path = NetInput::FindGroupPath(command, pTriangles);
+    }
+
+    for(entt::entity e : view)
+    {
+        CNetPredicted& unit = view.get<CNetPredicted>(e);
+        unit.PreviousPosition = unit.Position;
+        const bool bOrdered = NetInput::IsOrdered(command, view.get<CNetwork>(e).Id);
+        NetInput::Simulate(command, bOrdered ? &path : nullptr, unit.Follow, unit.Position, pTriangles);
+        Record(unit, Sequence, bOrdered);
+    }
+}
+
+bool NetPrediction::Update(entt::registry& registry, f32 deltaTime, NetInputMessage& outMessage)
+{
+    auto view = registry.view<CNetPredicted, CTransform3d>();
+    if(view.begin() == view.end())
+    {
+        Accumulator = 0.f;
+        bPendingMove = false;
+        return false;
+    }
+
+    const u32 first = Sequence;
+    Accumulator += deltaTime;
+    for(u32 ticks = 0; Accumulator >= NetInputTickDelta && ticks < MaxTicksPerFrame; ticks++)
+    {
+        Accumulator -= NetInputTickDelta;
+        Tick(registry);
+    }
+    Accumulator = std::min(Accumulator, NetInputTickDelta);
+
+    // Render between the last two ticks, plus whatever is left of the last correction
+    const f32 alpha = Accumulator / NetInputTickDelta;
+    const f32 decay = std::exp(-ErrorDecayRate * deltaTime);
+    for(entt::entity e : view)
+    {
+        CNetPredicted& unit = view.get<CNetPredicted>(e);
+        unit.ErrorOffset *= decay;
+        view.get<CTransform3d>(e).WorldPosition = glm::mix(unit.PreviousPosition, unit.Position, alpha) + unit.ErrorOffset;
+    }
+
+    if(Sequence == first)
+    {
+        return false;
+    }
+
+    outMessage.Count = 0;
+    for(u32 sequence = Sequence; (i32)(sequence - LastAcked) > 0 && outMessage.Count < NetInputRedundancy; sequence--)
+    {
+        outMessage.Commands[outMessage.Count++] = Commands[sequence & (HistorySize - 1)];
+    }
+    return true;
+}
+
+void NetPrediction::Reconcile(CNetPredicted& unit, u32 netId, u32 ackedInput, const v3& serverPosition)
+{
+    if((i32)(ackedInput - LastAcked) > 0)
+    {
+        LastAcked = ackedInput;
+    }
+
+    const NetPredictedState& acked = unit.History[ackedInput & (CNetPredicted::HistorySize - 1)];
+    // Without a prediction for that command, e.g. the unit spawned later, there is nothing to compare against
+    if(acked.Sequence != ackedInput || Sequence - ackedInput >= HistorySize ||
+       glm::distance(v2(acked.Position.x, acked.Position.z), v2(serverPosition.x, serverPosition.z)) <= CorrectionEpsilon)
+    {
+        return;
+    }
+
+    // Rewind to the server state and replay every command it has not simulated yet
+    const v3 predicted = unit.Position;
+    if(!Restore(unit, acked))
+    {
+        return;
+    }
+    unit.Position = serverPosition;
+    for(u32 sequence = ackedInput + 1; (i32)(sequence - Sequence) <= 0; sequence++)
+    {
+        const NetInputCommand& command = Commands[sequence & (HistorySize - 1)];
+        const bool bOrdered = NetInput::IsOrdered(command, netId);
+        NetInput::Simulate(command, bOrdered ? &Paths[sequence & (HistorySize - 1)] : nullptr, unit.Follow, unit.Position, pTriangles);
+        Record(unit, sequence, bOrdered);
+    }
+
+    const v3 correction = unit.Position - predicted;
+    unit.PreviousPosition += correction;
+    unit.ErrorOffset -= correction;
+    if(glm::length(unit.ErrorOffset) > ErrorSnapDistance)
+    {
+        unit.ErrorOffset = v3(0.f);
+    }
+    Corrections++;
+}
+
+void NetPrediction::Reset()
+{
+    Sequence = 0;
+    LastAcked = 0;
+    Accumulator = 0.f;
+    bPendingMove = false;
+    PendingUnits.clear();
+    Corrections = 0;
+}
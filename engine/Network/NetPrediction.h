@@ -0,0 +1,78 @@
+#ifndef X_NET_PREDICTION_H
+#define X_NET_PREDICTION_H
+
+#include "../Core/defines.h"
+#include <entt.hpp>
+#include <vector>
+#include "NetInput.h"
+
+struct CNetPredicted;
+struct NetPredictedState;
+struct NetInputMessage;
+
+// Client side prediction of the units this client owns. Orders are turned into sequenced input
+// commands that are simulated immediately and sent to the server. When a snapshot shows the
+// server disagreeing about an acknowledged command, the unit is reset to the server state, the
+// commands the server has not seen yet are replayed and the difference is blended out visually.
+class NetPrediction
+{
+    static constexpr u32 HistorySize = 64;
+    static constexpr u32 MaxTicksPerFrame = 5;
+    // Differences below this are quantization noise and not worth a replay
+    static constexpr f32 CorrectionEpsilon = 0.05f;
+    // Per second decay of the visual error, corrections larger than ErrorSnapDistance are not smoothed
+    static constexpr f32 ErrorDecayRate = 10.f;
+    static constexpr f32 ErrorSnapDistance = 32.f;
+
+    std::vector<Navigation::TriangleNode>* pTriangles = nullptr;
+
+    NetInputCommand Commands[HistorySize];
+    // Group path of every move command, for replays
+    std::vector<v2> Paths[HistorySize];
+    u32 Sequence = 0;
+    u32 LastAcked = 0;
+    f32 Accumulator = 0.f;
+
+    bool bPendingMove = false;
+    v2 PendingTarget = v2(0.f);
+    std::vector<u32> PendingUnits;
+
+    u32 Corrections = 0;
+
+    void Tick(entt::registry& registry);
+    // Stores the state of a unit after command sequence. ordered means the command started a new path.
+    void Record(CNetPredicted& unit, u32 sequence, bool bOrdered) const;
+    // Sets the path and cursor of a recorded state. False if its path is no longer kept.
+    static bool Restore(CNetPredicted& unit, const NetPredictedState& state);
+
+public:
+    inline void SetNavMesh(std::vector<Navigation::TriangleNode>* triangles) { pTriangles = triangles; }
+
+    // Orders every owned unit to move to target on the next input tick.
+    void IssueMove(const v2& target);
+    // Orders the owned units with these network ids, as one group with one path.
+    void IssueMove(const v2& target, std::vector<u32> units);
+
+    // Starts predicting a unit at its spawn position.
+    void Begin(CNetPredicted& unit, const v3& position) const;
+
+    // Gives a replicated entity with a transform what its role needs: CNetPredicted if the client owns it,
+    // CNetInterpolation otherwise. Snapshots are unreliable and can overtake the spawn, so an owned unit
+    // may already exist as an interpolated one when its spawn says it is owned.
+    void SetOwned(entt::registry& registry, entt::entity e, bool bOwned) const;
+
+    // Runs the input ticks due this frame and writes the predicted positions into the transforms.
+    // Returns true and fills outMessage when new commands have to be sent.
+    bool Update(entt::registry& registry, f32 deltaTime, NetInputMessage& outMessage);
+
+    // Compares the server position of a unit after ackedInput with what was predicted for that command.
+    void Reconcile(CNetPredicted& unit, u32 netId, u32 ackedInput, const v3& serverPosition);
+
+    void Reset();
+
+    [[nodiscard]] inline u32 GetSequence() const { return Sequence; }
+    [[nodiscard]] inline u32 GetLastAcked() const { return LastAcked; }
+    [[nodiscard]] inline u32 GetCorrections() const { return Corrections; }
+};
+
+#endif //X_NET_PREDICTION_H
@@ -0,0 +1,92 @@
+#include "NetPriority.h"
+#include <algorithm>
+
+void NetPriorityAccumulator::Select(const NetSnapshot& visible, const std::vector<f32>& weights, const NetSnapshot* lastSent,
+                                    const NetSnapshot* baseline, u32 budgetBytes, NetSnapshot& outSnapshot)
+{
+    outSnapshot.Sequence = visible.Sequence;
+    outSnapshot.ServerTimeMs = visible.ServerTimeMs;
+    outSnapshot.AckedInput = visible.AckedInput;
+    outSnapshot.Entities.clear();
+
+    // Entities the baseline already has cost nothing as they are there. Everything else the client was sent
+    // is kept if it fits and every change waits in line with the priority it built up.
+    const u32 count = (u32)visible.Entities.size();
+    Candidates.clear();
+    Kept.clear();
+    Chosen.assign(count, nullptr);
+    Costs.assign(count, 0);
+    for(u32 i = 0; i < count; i++)
+    {
+        const NetEntityState& state = visible.Entities[i];
+        const NetEntityState* base = baseline ? baseline->Find(state.NetId) : nullptr;
+        const NetEntityState* last = lastSent ? lastSent->Find(state.NetId) : nullptr;
+        // Entities the client never received in a snapshot stay out until they fit, it has their spawn
+        Chosen[i] = base;
+        if(last && (!base || *last != *base))
+        {
+            Kept.push_back(Candidate{i, weights[i]});
+        }
+
+        if(last && *last == state)
+        {
+            Accumulated.erase(state.NetId);
+            continue;
+        }
+        f32& priority = Accumulated[state.NetId];
+        priority += weights[i];
+        Candidates.push_back(Candidate{i, priority});
+    }
+
+    // Every included entity is encoded against baseline, so keeping what the client last received is
+    // charged too. Only when acks lag far enough for that not to fit does anything fall back to baseline.
+    const u32 budgetBits = budgetBytes * 8;
+    u32 usedBits = NetSnapshotCodec::MeasureFrame(visible, baseline);
+    std::sort(Kept.begin(), Kept.end(), [](const Candidate& a, const Candidate& b) { return a.Priority > b.Priority; });
+    for(const Candidate& kept : Kept)
+    {
+        const NetEntityState& state = visible.Entities[kept.Index];
+        const NetEntityState* last = lastSent->Find(state.NetId);
+        const u32 bits = NetSnapshotCodec::MeasureEntity(*last, Chosen[kept.Index]);
+        if(usedBits + bits <= budgetBits)
+        {
+            usedBits += bits;
+            Costs[kept.Index] = bits;
+            Chosen[kept.Index] = last;
+        }
+    }
+
+    // Smaller updates further down may still fit after a large one did not
+    std::sort(Candidates.begin(), Candidates.end(), [](const Candidate& a, const Candidate& b) { return a.Priority > b.Priority; });
+    Deferred = 0;
+    for(const Candidate& candidate : Candidates)
+    {
+        const NetEntityState& state = visible.Entities[candidate.Index];
+        const u32 bits = NetSnapshotCodec::MeasureEntity(state, baseline ? baseline->Find(state.NetId) : nullptr);
+        if(usedBits - Costs[candidate.Index] + bits > budgetBits)
+        {
+            Deferred++;
+            continue;
+        }
+        usedBits = usedBits - Costs[candidate.Index] + bits;
+        Chosen[candidate.Index] = &state;
+        Accumulated.erase(state.NetId);
+    }
+
+    for(const NetEntityState* state : Chosen)
+    {
+        if(state)
+        {
+            outSnapshot.Entities.push_back(*state);
+        }
+    }
+
+    // Forget entities that left the client's view
+    if(Accumulated.size() > Deferred)
+    {
+        for(auto it = Accumulated.begin(); it != Accumulated.end();)
+        {
+            it = visible.Find(it->first) ? std::next(it) : Accumulated.erase(it);
+        }
+    }
+}
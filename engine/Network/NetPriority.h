@@ -0,0 +1,52 @@
+#ifndef X_NET_PRIORITY_H
+#define X_NET_PRIORITY_H
+
+#include "../Core/defines.h"
+#include <unordered_map>
+#include <vector>
+#include "NetSnapshot.h"
+
+struct NetPriorityConfig
+{
+    // Snapshot payload per client and tick, about one MTU. Reliable spawns, kills and components are not counted.
+    u32 SnapshotBytesPerTick = 1100;
+    // Priority an entity gains every tick it waits, next to a viewer and at FarDistance or beyond
+    f32 NearPriority = 4.f;
+    f32 FarPriority = 1.f;
+    f32 FarDistance = 360.f;
+    // Units the client owns are reconciled against every snapshot, so they always go first
+    f32 OwnedPriority = 1e6f;
+};
+
+// Per-client priority accumulator. Every entity whose state changed since the client last heard about
+// it gains its relevance weight each tick, and the highest ones are sent until the byte budget is spent.
+// The rest keep the state the client last received and are more likely to make it next tick. Everything
+// in the snapshot is charged what it costs against the baseline, so the encoded size stays in budget.
+class NetPriorityAccumulator
+{
+    struct Candidate
+    {
+        u32 Index = 0;
+        f32 Priority = 0.f;
+    };
+
+    std::unordered_map<u32, f32> Accumulated;
+    std::vector<Candidate> Candidates;
+    // Entities whose last sent state differs from the baseline, by weight
+    std::vector<Candidate> Kept;
+    std::vector<const NetEntityState*> Chosen;
+    // Bits charged for the state in Chosen
+    std::vector<u32> Costs;
+    u32 Deferred = 0;
+
+public:
+    // Builds the snapshot to send from visible, whose entities have the given weights. lastSent is the
+    // newest snapshot sent to the client and baseline the one the result will be delta encoded against.
+    void Select(const NetSnapshot& visible, const std::vector<f32>& weights, const NetSnapshot* lastSent,
+                const NetSnapshot* baseline, u32 budgetBytes, NetSnapshot& outSnapshot);
+
+    // Changed entities that did not fit into the last selected snapshot.
+    [[nodiscard]] inline u32 GetDeferredCount() const { return Deferred; }
+};
+
+#endif //X_NET_PRIORITY_H
@@ -0,0 +1,222 @@
+#include "NetQuantize.h"
+#include "../Components/TransformComponent.h"
+#include <cmath>
+
+u32 NetQuantization::GetPositionBits(u32 axis) const
+{
+    f32 steps = (WorldMax[axis] - WorldMin[axis]) / PositionPrecision;
+    u32 bits = 1;
+    while(bits < 32 && (f32)((1ull << bits) - 1ull) < steps)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+const NetQuantization& GetNetQuantization()
+{
+    static NetQuantization quantization{};
+    return quantization;
+}
+
+namespace NetQuantize
+{
+static constexpr f32 QuatComponentRange = 0.70710678f;
+
+u32 QuantizeFloat(f32 value, f32 min, f32 max, u32 bits)
+{
+    const u32 maxValue = bits < 32 ? (1u << bits) - 1u : 0xFFFFFFFFu;
+    f32 t = (glm::clamp(value, min, max) - min) / (max - min);
+    return (u32)std::lround((f64)t * maxValue);
+}
+
+f32 DequantizeFloat(u32 value, f32 min, f32 max, u32 bits)
+{
+    const u32 maxValue = bits < 32 ? (1u << bits) - 1u : 0xFFFFFFFFu;
+    return min + (f32)((f64)value / maxValue) * (max - min);
+}
+
+u32 QuantizeAngle(f32 radians, u32 bits)
+{
+    const f32 twoPi = glm::two_pi<f32>();
+    f32 wrapped = std::fmod(radians, twoPi);
+    if(wrapped < 0.f)
+    {
+        wrapped += twoPi;
+    }
+    u32 steps = 1u << bits;
+    return (u32)std::lround(wrapped / twoPi * (f32)steps) & (steps - 1u);
+}
+
+f32 DequantizeAngle(u32 value, u32 bits)
+{
+    f32 angle = (f32)value / (f32)(1u << bits) * glm::two_pi<f32>();
+    return angle > glm::pi<f32>() ? angle - glm::two_pi<f32>() : angle;
+}
+
+q4 EulerToQuat(const v3& euler)
+{
+    return glm::angleAxis(euler.z, v3(0.f, 0.f, 1.f)) *
+           glm::angleAxis(euler.y, v3(0.f, 1.f, 0.f)) *
+           glm::angleAxis(euler.x, v3(1.f, 0.f, 0.f));
+}
+
+v3 QuatToEuler(const q4& quat)
+{
+    // R = Rz * Ry * Rx, glm matrices are indexed [column][row]
+    m3 r = glm::mat3_cast(quat);
+    f32 sinY = glm::clamp(-r[0][2], -1.f, 1.f);
+    return {std::atan2(r[1][2], r[2][2]), std::asin(sinY), std::atan2(r[0][1], r[0][0])};
+}
+
+void WritePosition(BitWriter& writer, const v3& position, const NetQuantization& quantization)
+{
+    for(u32 axis = 0; axis < 3; axis++)
+    {
+        u32 bits = quantization.GetPositionBits(axis);
+        writer.WriteBits(QuantizeFloat(position[axis], quantization.WorldMin[axis], quantization.WorldMax[axis], bits), bits);
+    }
+}
+
+v3 ReadPosition(BitReader& reader, const NetQuantization& quantization)
+{
+    v3 position;
+    for(u32 axis = 0; axis < 3; axis++)
+    {
+        u32 bits = quantization.GetPositionBits(axis);
+        position[axis] = DequantizeFloat(reader.ReadBits(bits), quantization.WorldMin[axis], quantization.WorldMax[axis], bits);
+    }
+    return position;
+}
+
+static void WriteOptionalAngle(BitWriter& writer, f32 angle, u32 bits)
+{
+    u32 quantized = QuantizeAngle(angle, bits);
+    writer.WriteBool(quantized != 0);
+    if(quantized != 0)
+    {
+        writer.WriteBits(quantized, bits);
+    }
+}
+
+static f32 ReadOptionalAngle(BitReader& reader, u32 bits)
+{
+    return reader.ReadBool() ? DequantizeAngle(reader.ReadBits(bits), bits) : 0.f;
+}
+
+void WriteRotation(BitWriter& writer, const v3& euler, const NetQuantization& quantization)
+{
+    writer.WriteBits((u32)quantization.RotationMode, 1);
+
+    if(quantization.RotationMode == ENetRotationMode::Yaw)
+    {
+        // Units mostly turn around Y only, pitch and roll cost a single bit when they are zero
+        writer.WriteBits(QuantizeAngle(euler.y, quantization.AngleBits), quantization.AngleBits);
+        WriteOptionalAngle(writer, euler.x, quantization.AngleBits);
+        WriteOptionalAngle(writer, euler.z, quantization.AngleBits);
+        return;
+    }
+
+    q4 q = EulerToQuat(euler);
+    f32 components[4] = {q.x, q.y, q.z, q.w};
+
+    u32 largest = 0;
+    for(u32 i = 1; i < 4; i++)
+    {
+        if(std::abs(components[i]) > std::abs(components[largest]))
+        {
+            largest = i;
+        }
+    }
+
+    // q and -q are the same rotation, so the dropped component can always be made positive
+    f32 sign = components[largest] < 0.f ? -1.f : 1.f;
+    writer.WriteBits(largest, 2);
+    for(u32 i = 0; i < 4; i++)
+    {
+        if(i != largest)
+        {
+            writer.WriteBits(QuantizeFloat(components[i] * sign, -QuatComponentRange, QuatComponentRange, quantization.QuatComponentBits),
+                             quantization.QuatComponentBits);
+        }
+    }
+}
+
+v3 ReadRotation(BitReader& reader, const NetQuantization& quantization)
+{
+    ENetRotationMode mode = (ENetRotationMode)reader.ReadBits(1);
+
+    if(mode == ENetRotationMode::Yaw)
+    {
+        v3 euler;
+        euler.y = DequantizeAngle(reader.ReadBits(quantization.AngleBits), quantization.AngleBits);
+        euler.x = ReadOptionalAngle(reader, quantization.AngleBits);
+        euler.z = ReadOptionalAngle(reader, quantization.AngleBits);
+        return euler;
+    }
+
+    u32 largest = reader.ReadBits(2);
+    f32 components[4];
+    f32 sumSquares = 0.f;
+    for(u32 i = 0; i < 4; i++)
+    {
+        if(i != largest)
+        {
+            components[i] = DequantizeFloat(reader.ReadBits(quantization.QuatComponentBits), -QuatComponentRange, QuatComponentRange,
+                                            quantization.QuatComponentBits);
+            sumSquares += components[i] * components[i];
+        }
+    }
+    components[largest] = std::sqrt(std::max(0.f, 1.f - sumSquares));
+
+    return QuatToEuler(glm::normalize(q4(components[3], components[0], components[1], components[2])));
+}
+
+void WriteScale(BitWriter& writer, const v3& scale, const NetQuantization& quantization)
+{
+    bool bUniform = scale.x == scale.y && scale.y == scale.z;
+    writer.WriteBool(bUniform);
+    for(u32 axis = 0; axis < (bUniform ? 1u : 3u); axis++)
+    {
+        writer.WriteBits(QuantizeFloat(scale[axis], 0.f, quantization.ScaleMax, quantization.ScaleBits), quantization.ScaleBits);
+    }
+}
+
+v3 ReadScale(BitReader& reader, const NetQuantization& quantization)
+{
+    if(reader.ReadBool())
+    {
+        return v3(DequantizeFloat(reader.ReadBits(quantization.ScaleBits), 0.f, quantization.ScaleMax, quantization.ScaleBits));
+    }
+
+    v3 scale;
+    for(u32 axis = 0; axis < 3; axis++)
+    {
+        scale[axis] = DequantizeFloat(reader.ReadBits(quantization.ScaleBits), 0.f, quantization.ScaleMax, quantization.ScaleBits);
+    }
+    return scale;
+}
+
+void WriteTransform(BitWriter& writer, const CTransform3d& transform, bool bWriteScale, const NetQuantization& quantization)
+{
+    WritePosition(writer, transform.WorldPosition, quantization);
+    WriteRotation(writer, transform.WorldRotation, quantization);
+    writer.WriteBool(bWriteScale);
+    if(bWriteScale)
+    {
+        WriteScale(writer, transform.WorldScale, quantization);
+    }
+}
+
+bool ReadTransform(BitReader& reader, CTransform3d& transform, const NetQuantization& quantization)
+{
+    transform.WorldPosition = ReadPosition(reader, quantization);
+    transform.WorldRotation = ReadRotation(reader, quantization);
+    if(reader.ReadBool())
+    {
+        transform.WorldScale = ReadScale(reader, quantization);
+        return true;
+    }
+    return false;
+}
+}
@@ -0,0 +1,62 @@
+#ifndef X_NET_QUANTIZE_H
+#define X_NET_QUANTIZE_H
+
+#include "../Core/defines.h"
+#include "BitStream.h"
+
+struct CTransform3d;
+
+enum class ENetRotationMode : u8
+{
+    Yaw = 0,
+    SmallestThree,
+};
+
+// Both ends must agree on these values, so changing them requires a NetProtocolVersion bump.
+struct NetQuantization
+{
+    v3 WorldMin = v3{-1024.f, -64.f, -1024.f};
+    v3 WorldMax = v3{1024.f, 64.f, 1024.f};
+    f32 PositionPrecision = 1.f / 64.f;
+
+    u32 AngleBits = 12;
+    u32 QuatComponentBits = 10;
+
+    f32 ScaleMax = 64.f;
+    u32 ScaleBits = 16;
+
+    ENetRotationMode RotationMode = ENetRotationMode::Yaw;
+
+    [[nodiscard]] u32 GetPositionBits(u32 axis) const;
+};
+
+const NetQuantization& GetNetQuantization();
+
+namespace NetQuantize
+{
+u32 QuantizeFloat(f32 value, f32 min, f32 max, u32 bits);
+f32 DequantizeFloat(u32 value, f32 min, f32 max, u32 bits);
+
+u32 QuantizeAngle(f32 radians, u32 bits);
+f32 DequantizeAngle(u32 value, u32 bits);
+
+// Euler angles as applied by the renderer: X first, then Y, then Z.
+q4 EulerToQuat(const v3& euler);
+v3 QuatToEuler(const q4& quat);
+
+void WritePosition(BitWriter& writer, const v3& position, const NetQuantization& quantization);
+v3 ReadPosition(BitReader& reader, const NetQuantization& quantization);
+
+void WriteRotation(BitWriter& writer, const v3& euler, const NetQuantization& quantization);
+v3 ReadRotation(BitReader& reader, const NetQuantization& quantization);
+
+void WriteScale(BitWriter& writer, const v3& scale, const NetQuantization& quantization);
+v3 ReadScale(BitReader& reader, const NetQuantization& quantization);
+
+// Writes the replicated world-space part of a transform. Scale is only written when bWriteScale is set;
+// ReadTransform leaves the destination scale untouched otherwise and returns whether scale was present.
+void WriteTransform(BitWriter& writer, const CTransform3d& transform, bool bWriteScale, const NetQuantization& quantization);
+bool ReadTransform(BitReader& reader, CTransform3d& transform, const NetQuantization& quantization);
+}
+
+#endif //X_NET_QUANTIZE_H
@@ -0,0 +1,321 @@
+#include "NetReplicator.h"
+#include "NetBatch.h"
+#include "NetMsgType.h"
+#include "../Components/NetworkComponent.h"
+#include <algorithm>
+#include <limits>
+
+void NetReplicator::Bind(entt::registry& registry)
+{
+    GetNetComponents().Connect(registry);
+}
+
+void NetReplicator::Unbind(entt::registry& registry)
+{
+    GetNetComponents().Disconnect(registry);
+    registry.clear<CNetDirty>();
+}
+
+void NetReplicator::AddClient(u32 peerId, bool bStream)
+{
+    if(std::find(Peers.begin(), Peers.end(), peerId) == Peers.end())
+    {
+        Peers.push_back(peerId);
+    }
+    if(!bStream)
+    {
+        Unstreamed.insert(peerId);
+    }
+}
+
+void NetReplicator::RemoveClient(u32 peerId)
+{
+    DetachClient(peerId);
+    Inputs.erase(peerId);
+}
+
+void NetReplicator::DetachClient(u32 peerId)
+{
+    Peers.erase(std::remove(Peers.begin(), Peers.end(), peerId), Peers.end());
+    Interest.RemoveClient(peerId);
+    Snapshots.RemoveClient(peerId);
+    Priorities.erase(peerId);
+    Streams.erase(peerId);
+    Unstreamed.erase(peerId);
+}
+
+void NetReplicator::SetView(u32 peerId, const v3& position)
+{
+    Interest.SetCamera(peerId, {position.x, position.z});
+}
+
+void NetReplicator::Acknowledge(u32 peerId, u32 sequence)
+{
+    Snapshots.Acknowledge(peerId, sequence);
+}
+
+void NetReplicator::ReceiveInput(u32 peerId, const NetInputMessage& message)
+{
+    NetInputBuffer& buffer = Inputs[peerId];
+    for(u32 i = 0; i < message.Count; i++)
+    {
+        buffer.Receive(message.Commands[i]);
+    }
+}
+
+void NetReplicator::Tick(entt::registry& registry, u32 serverTimeMs, NetBatcher& batcher)
+{
+    const NetQuantization& quantization = GetNetQuantization();
+
+    Grid.Sync(registry);
+    Snapshots.Capture(registry, serverTimeMs, World);
+
+    // Owned units see for their client wherever its camera is, so they never leave its relevant set
+    for(u32 peerId : Peers)
+    {
+        Interest.ClearViewers(peerId);
+    }
+    Owners.clear();
+    auto owned = registry.view<CNetwork, CNetOwner>();
+    for(entt::entity e : owned)
+    {
+        const u32 netId = owned.get<CNetwork>(e).Id;
+        const u32 owner = owned.get<CNetOwner>(e).PeerId;
+        Owners[netId] = owner;
+        if(v2 position; Grid.GetPosition(netId, position))
+        {
+            Interest.AddViewer(owner, position);
+        }
+    }
+    CollectDirty(registry);
+
+    for(u32 peerId : Peers)
+    {
+        Interest.Update(peerId, Grid, Entered, Exited);
+        NetJoinStream& stream = Streams[peerId];
+
+        for(u32 netId : Exited)
+        {
+            // Still waiting in the stream means the client never heard of it
+            if(!stream.Remove(netId))
+            {
+                batcher.Add(peerId, (u8)ENetChannelId::Reliable, ENET_PACKET_FLAG_RELIABLE, NetKillMessage{netId});
+            }
+        }
+        const bool bCanStream = Unstreamed.erase(peerId) == 0;
+        if(stream.IsActive() || (bCanStream && Entered.size() >= StreamConfig.MinEntities))
+        {
+            BeginStream(peerId, stream);
+        }
+        for(u32 netId : Entered)
+        {
+            if(const NetEntityState* state = World.Find(netId))
+            {
+                CTransform3d transform{};
+                state->ToTransform(transform, quantization);
+                auto owner = Owners.find(netId);
+                const bool bOwned = owner != Owners.end() && owner->second == peerId;
+                batcher.Add(peerId, (u8)ENetChannelId::Reliable, ENET_PACKET_FLAG_RELIABLE, NetSpawnMessage{netId, transform, bOwned});
+            }
+        }
+
+        const std::vector<u32>* relevant = &Interest.GetRelevant(peerId);
+        if(stream.IsActive())
+        {
+            Streamed.clear();
+            for(u32 netId : *relevant)
+            {
+                if(!stream.IsPending(netId))
+                {
+                    Streamed.push_back(netId);
+                }
+            }
+            relevant = &Streamed;
+        }
+        SendComponents(registry, peerId, *relevant, batcher);
+        SendSnapshot(peerId, *relevant, batcher);
+        // Last, so that a chunk's entities are only in the snapshots after it
+        SendStream(registry, peerId, stream, batcher);
+    }
+
+    registry.clear<CNetDirty>();
+}
+
+void NetReplicator::CollectDirty(entt::registry& registry)
+{
+    NetEntities.clear();
+    auto replicated = registry.view<CNetwork>();
+    for(entt::entity e : replicated)
+    {
+        NetEntities[replicated.get<CNetwork>(e).Id] = e;
+    }
+
+    Dirty.clear();
+    auto dirty = registry.view<CNetwork, CNetDirty>();
+    for(entt::entity e : dirty)
+    {
+        Dirty.push_back(NetComponentChange{dirty.get<CNetwork>(e).Id, e, dirty.get<CNetDirty>(e).Mask});
+    }
+    std::sort(Dirty.begin(), Dirty.end(), [](const NetComponentChange& a, const NetComponentChange& b) { return a.NetId < b.NetId; });
+}
+
+void NetReplicator::BeginStream(u32 peerId, NetJoinStream& stream)
+{
+    const std::vector<v2>& viewers = Interest.GetViewers(peerId);
+    for(u32 netId : Entered)
+    {
+        auto owner = Owners.find(netId);
+        const bool bOwned = owner != Owners.end() && owner->second == peerId;
+        stream.Add(netId, bOwned ? -1.f : GetViewDistance(viewers, netId, std::numeric_limits<f32>::max()));
+    }
+    stream.Sort();
+    Entered.clear();
+}
+
+void NetReplicator::SendStream(const entt::registry& registry, u32 peerId, NetJoinStream& stream, NetBatcher& batcher)
+{
+    if(!stream.Refill(StreamConfig))
+    {
+        return;
+    }
+
+    const NetComponentRegistry& components = GetNetComponents();
+    while(stream.IsActive() && stream.HasBudget())
+    {
+        stream.Next(StreamConfig.ChunkEntities, Chunk);
+        Chunk.erase(std::remove_if(Chunk.begin(), Chunk.end(), [this](u32 netId) { return !World.Find(netId); }), Chunk.end());
+
+        ChunkChanges.clear();
+        for(u32 netId : Chunk)
+        {
+            auto it = NetEntities.find(netId);
+            if(it == NetEntities.end())
+            {
+                continue;
+            }
+            if(const u32 mask = components.GetMask(registry, it->second))
+            {
+                ChunkChanges.push_back(NetComponentChange{netId, it->second, mask});
+            }
+        }
+
+        // Reliable on the spawn channel like everything else that creates entities on the client
+        u32 bytes = 0;
+        const u32 remaining = stream.GetRemaining();
+        batcher.Write(peerId, (u8)ENetChannelId::Reliable, ENET_PACKET_FLAG_RELIABLE, ENetMsg::WorldChunk, [&](BitWriter& writer)
+        {
+            static const NetEntityState zero{};
+            NetJoinStreamCodec::WriteHeader(writer, remaining, (u32)Chunk.size());
+            const NetEntityState* previous = &zero;
+            for(u32 netId : Chunk)
+            {
+                const NetEntityState* state = World.Find(netId);
+                auto owner = Owners.find(netId);
+                NetJoinStreamCodec::WriteEntity(writer, *state, owner != Owners.end() && owner->second == peerId, *previous);
+                previous = state;
+            }
+            components.WriteChanges(writer, registry, ChunkChanges.data(), (u32)ChunkChanges.size());
+            bytes = (writer.GetBitsWritten() + 7) / 8;
+        });
+        stream.Spend(bytes);
+    }
+}
+
+void NetReplicator::SendComponents(const entt::registry& registry, u32 peerId, const std::vector<u32>& relevant, NetBatcher& batcher)
+{
+    const NetComponentRegistry& components = GetNetComponents();
+
+    // Relevant, Entered and Dirty are all sorted, so one pass over the relevant set finds what to send
+    Changes.clear();
+    size_t d = 0;
+    for(u32 netId : relevant)
+    {
+        while(d < Dirty.size() && Dirty[d].NetId < netId)
+        {
+            d++;
+        }
+
+        if(std::binary_search(Entered.begin(), Entered.end(), netId))
+        {
+            auto it = NetEntities.find(netId);
+            if(it == NetEntities.end())
+            {
+                continue;
+            }
+            if(const u32 mask = components.GetMask(registry, it->second))
+            {
+                Changes.push_back(NetComponentChange{netId, it->second, mask});
+            }
+        }
+        else if(d < Dirty.size() && Dirty[d].NetId == netId)
+        {
+            Changes.push_back(Dirty[d]);
+        }
+    }
+
+    // Reliable and on the spawn channel, so components never arrive before their entity
+    for(size_t i = 0; i < Changes.size(); i += NetComponentChangesPerMessage)
+    {
+        const u32 count = (u32)std::min<size_t>(NetComponentChangesPerMessage, Changes.size() - i);
+        batcher.Write(peerId, (u8)ENetChannelId::Reliable, ENET_PACKET_FLAG_RELIABLE, ENetMsg::AddComponent, [&](BitWriter& writer)
+        {
+            components.WriteChanges(writer, registry, Changes.data() + i, count);
+        });
+    }
+}
+
+void NetReplicator::SendSnapshot(u32 peerId, const std::vector<u32>& relevant, NetBatcher& batcher)
+{
+    NetSnapshotSender::Select(World, relevant, Visible);
+    Visible.AckedInput = Inputs[peerId].GetLastProcessed();
+
+    // Closer to a viewer means more important, owned units above everything
+    const std::vector<v2>& viewers = Interest.GetViewers(peerId);
+    const f32 range = PriorityConfig.NearPriority - PriorityConfig.FarPriority;
+    Weights.resize(Visible.Entities.size());
+    for(size_t i = 0; i < Visible.Entities.size(); i++)
+    {
+        const u32 netId = Visible.Entities[i].NetId;
+        if(auto owner = Owners.find(netId); owner != Owners.end() && owner->second == peerId)
+        {
+            Weights[i] = PriorityConfig.OwnedPriority;
+            continue;
+        }
+
+        const f32 distance = GetViewDistance(viewers, netId, PriorityConfig.FarDistance);
+        Weights[i] = PriorityConfig.FarPriority + range * (1.f - distance / PriorityConfig.FarDistance);
+    }
+
+    Priorities[peerId].Select(Visible, Weights, Snapshots.GetLastSent(peerId), Snapshots.GetBaseline(peerId, Visible.Sequence),
+                              PriorityConfig.SnapshotBytesPerTick, Budgeted);
+    batcher.Write(peerId, (u8)ENetChannelId::Unreliable, 0, ENetMsg::Snapshot, [this, peerId](BitWriter& writer)
+    {
+        Snapshots.Encode(peerId, Budgeted, writer);
+    });
+}
+
+f32 NetReplicator::GetViewDistance(const std::vector<v2>& viewers, u32 netId, f32 maxDistance) const
+{
+    f32 distance = maxDistance;
+    v2 position;
+    if(Grid.GetPosition(netId, position))
+    {
+        for(const v2& viewer : viewers)
+        {
+            distance = std::min(distance, glm::distance(position, viewer));
+        }
+    }
+    return distance;
+}
+
+u32 NetReplicator::GetDeferredCount(u32 peerId) const
+{
+    auto it = Priorities.find(peerId);
+    return it != Priorities.end() ? it->second.GetDeferredCount() : 0;
+}
+
+u32 NetReplicator::GetStreamRemaining(u32 peerId) const
+{
+    auto it = Streams.find(peerId);
+    return it != Streams.end() ? it->second.GetRemaining() : 0;
+}
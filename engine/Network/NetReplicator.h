@@ -0,0 +1,99 @@
+#ifndef X_NET_REPLICATOR_H
+#define X_NET_REPLICATOR_H
+
+#include "../Core/defines.h"
+#include <entt.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "NetComponents.h"
+#include "NetInput.h"
+#include "NetInterest.h"
+#include "NetJoinStream.h"
+#include "NetPriority.h"
+#include "NetSnapshot.h"
+
+class NetBatcher;
+struct NetInputMessage;
+
+// Server side replication: keeps the spatial grid of replicated entities, works out what each
+// client can see, sends spawns and kills as entities enter and leave that set and a delta
+// snapshot of the rest every tick. Registered components follow the same relevance: entering
+// entities get all of them, relevant ones only those marked dirty since the last tick. Snapshots are
+// held to a per-client byte budget, filled by priority. A burst of entering entities, such as the world
+// a client sees on joining, is streamed in chunks under a budget of its own instead, see NetJoinStream.
+class NetReplicator
+{
+    NetSpatialGrid Grid;
+    NetInterestManager Interest;
+    NetSnapshotSender Snapshots;
+    NetPriorityConfig PriorityConfig;
+    std::unordered_map<u32, NetPriorityAccumulator> Priorities;
+    NetJoinStreamConfig StreamConfig;
+    std::unordered_map<u32, NetJoinStream> Streams;
+    // Clients whose next burst of entering entities is spawned in one go, see AddClient
+    std::unordered_set<u32> Unstreamed;
+
+    std::vector<u32> Peers;
+    std::unordered_map<u32, NetInputBuffer> Inputs;
+    // Network id to owning peer and to entity, rebuilt every tick
+    std::unordered_map<u32, u32> Owners;
+    std::unordered_map<u32, entt::entity> NetEntities;
+    // Sorted by NetId
+    std::vector<NetComponentChange> Dirty;
+    std::vector<NetComponentChange> Changes;
+    NetSnapshot World;
+    NetSnapshot Visible;
+    NetSnapshot Budgeted;
+    std::vector<f32> Weights;
+    std::vector<u32> Entered;
+    std::vector<u32> Exited;
+    // Relevant minus what is still waiting in the client's stream
+    std::vector<u32> Streamed;
+    std::vector<u32> Chunk;
+    std::vector<NetComponentChange> ChunkChanges;
+
+public:
+    explicit NetReplicator(const NetInterestConfig& config = NetInterestConfig(), const NetPriorityConfig& priority = NetPriorityConfig(),
+                           const NetJoinStreamConfig& stream = NetJoinStreamConfig())
+        : Interest(config), PriorityConfig(priority), StreamConfig(stream) {}
+
+    // Starts and stops dirty tracking of the registered components on the simulated registry.
+    void Bind(entt::registry& registry);
+    void Unbind(entt::registry& registry);
+
+    // Without bStream the first relevant set is spawned at once rather than streamed, for a client that
+    // already has most of it from another server.
+    void AddClient(u32 peerId, bool bStream = true);
+    void RemoveClient(u32 peerId);
+    // Stops replicating to a client but keeps consuming its input.
+    void DetachClient(u32 peerId);
+    void SetView(u32 peerId, const v3& position);
+    void Acknowledge(u32 peerId, u32 sequence);
+    void ReceiveInput(u32 peerId, const NetInputMessage& message);
+
+    // Input commands of one client, consumed by the simulation each tick.
+    [[nodiscard]] NetInputBuffer& GetInput(u32 peerId) { return Inputs[peerId]; }
+
+    void Tick(entt::registry& registry, u32 serverTimeMs, NetBatcher& batcher);
+
+private:
+    void CollectDirty(entt::registry& registry);
+    // Moves a burst of entering entities into the client's stream, nearest first.
+    void BeginStream(u32 peerId, NetJoinStream& stream);
+    void SendStream(const entt::registry& registry, u32 peerId, NetJoinStream& stream, NetBatcher& batcher);
+    void SendComponents(const entt::registry& registry, u32 peerId, const std::vector<u32>& relevant, NetBatcher& batcher);
+    void SendSnapshot(u32 peerId, const std::vector<u32>& relevant, NetBatcher& batcher);
+    [[nodiscard]] f32 GetViewDistance(const std::vector<v2>& viewers, u32 netId, f32 maxDistance) const;
+
+public:
+    [[nodiscard]] inline const NetSpatialGrid& GetGrid() const { return Grid; }
+    [[nodiscard]] inline NetInterestManager& GetInterest() { return Interest; }
+    [[nodiscard]] inline const std::vector<u32>& GetPeers() const { return Peers; }
+    // Changed entities left out of the last snapshot sent to a client for lack of budget.
+    [[nodiscard]] u32 GetDeferredCount(u32 peerId) const;
+    // Entities still waiting in a client's stream.
+    [[nodiscard]] u32 GetStreamRemaining(u32 peerId) const;
+};
+
+#endif //X_NET_REPLICATOR_H
@@ -0,0 +1,37 @@
+#include "NetRpc.h"
+
+const char* GetNetRpcName(ENetRpc id)
+{
+    switch(id)
+    {
+        case ENetRpc::SnapshotAck: return "SnapshotAck";
+        case ENetRpc::ZoneTransfer: return "ZoneTransfer";
+        default: return "Unknown";
+    }
+}
+
+void NetRpcTable::RecordSent(ENetRpc id, u32 bytes)
+{
+    if((u32)id < NetRpcCount)
+    {
+        Stats[(u32)id].Sent++;
+        Stats[(u32)id].SentBytes += bytes;
+    }
+}
+
+bool NetRpcTable::Dispatch(BitReader& reader, u32 peerId)
+{
+    const u32 start = reader.GetBitsRead();
+    const u32 id = reader.ReadVarU32();
+    if(reader.HasOverflowed() || id >= NetRpcCount || !Entries[id].Invoke)
+    {
+        return false;
+    }
+    if(!Entries[id].Invoke(Entries[id].pInstance, reader, peerId))
+    {
+        return false;
+    }
+    Stats[id].Received++;
+    Stats[id].ReceivedBytes += (reader.GetBitsRead() - start + 7) / 8;
+    return true;
+}
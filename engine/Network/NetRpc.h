@@ -0,0 +1,230 @@
+#ifndef X_NET_RPC_H
+#define X_NET_RPC_H
+
+#include "../Core/defines.h"
+#include <tuple>
+#include <type_traits>
+#include "BitStream.h"
+#include "NetBatch.h"
+#include "NetMessage.h"
+
+// Dense, every id is a slot in NetRpcTable. Both ends must declare the same ids.
+enum class ENetRpc : u32
+{
+    SnapshotAck = 0,
+    ZoneTransfer,
+    Count,
+};
+
+constexpr u32 NetRpcCount = (u32)ENetRpc::Count;
+
+const char* GetNetRpcName(ENetRpc id);
+
+enum class ENetRpcMode : u8
+{
+    // Reliable channel, ordered with spawns and kills
+    Reliable = 0,
+    // Unreliable channel, the newest call makes up for a lost one
+    Unreliable,
+};
+
+// Wire format of one argument type. Specialize it for anything that is not covered below.
+template<typename T, typename = void>
+struct NetRpcArg;
+
+template<>
+struct NetRpcArg<bool>
+{
+    static void Write(BitWriter& writer, bool value) { writer.WriteBool(value); }
+    static void Read(BitReader& reader, bool& value) { value = reader.ReadBool(); }
+};
+
+template<typename T>
+struct NetRpcArg<T, std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T> && sizeof(T) <= 4 && !std::is_same_v<T, bool>>>
+{
+    static void Write(BitWriter& writer, T value) { writer.WriteVarU32(value); }
+    static void Read(BitReader& reader, T& value) { value = (T)reader.ReadVarU32(); }
+};
+
+// Zigzag, so small negative numbers stay small
+template<typename T>
+struct NetRpcArg<T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T> && sizeof(T) <= 4>>
+{
+    static void Write(BitWriter& writer, T value) { writer.WriteVarU32(((u32)value << 1) ^ (u32)((i32)value >> 31)); }
+    static void Read(BitReader& reader, T& value)
+    {
+        const u32 zigzag = reader.ReadVarU32();
+        value = (T)(i32)((zigzag >> 1) ^ (0u - (zigzag & 1)));
+    }
+};
+
+template<typename T>
+struct NetRpcArg<T, std::enable_if_t<std::is_enum_v<T>>>
+{
+    using Underlying = std::underlying_type_t<T>;
+    static void Write(BitWriter& writer, T value) { NetRpcArg<Underlying>::Write(writer, (Underlying)value); }
+    static void Read(BitReader& reader, T& value)
+    {
+        Underlying raw{};
+        NetRpcArg<Underlying>::Read(reader, raw);
+        value = (T)raw;
+    }
+};
+
+template<>
+struct NetRpcArg<f32>
+{
+    static void Write(BitWriter& writer, f32 value) { writer.WriteF32(value); }
+    static void Read(BitReader& reader, f32& value) { value = reader.ReadF32(); }
+};
+
+template<>
+struct NetRpcArg<v2>
+{
+    static void Write(BitWriter& writer, const v2& value) { writer.WriteF32(value.x); writer.WriteF32(value.y); }
+    static void Read(BitReader& reader, v2& value) { value.x = reader.ReadF32(); value.y = reader.ReadF32(); }
+};
+
+template<>
+struct NetRpcArg<v3>
+{
+    static void Write(BitWriter& writer, const v3& value) { writer.WriteF32(value.x); writer.WriteF32(value.y); writer.WriteF32(value.z); }
+    static void Read(BitReader& reader, v3& value) { value.x = reader.ReadF32(); value.y = reader.ReadF32(); value.z = reader.ReadF32(); }
+};
+
+// The signature of one RPC, declared once and shared by caller and receiver. The handler bound to it
+// takes the sending peer followed by Args.
+template<ENetRpc RpcId, ENetRpcMode RpcMode, typename... Args>
+struct NetRpcDecl
+{
+    static constexpr ENetRpc Id = RpcId;
+    static constexpr ENetRpcMode Mode = RpcMode;
+    static constexpr u8 Channel = Mode == ENetRpcMode::Reliable ? (u8)ENetChannelId::Reliable : (u8)ENetChannelId::Unreliable;
+    static constexpr u32 Flags = Mode == ENetRpcMode::Reliable ? ENET_PACKET_FLAG_RELIABLE : 0;
+    using Arguments = std::tuple<std::decay_t<Args>...>;
+
+    // Rpc frame body: the id, then every argument in declaration order
+    static void Write(BitWriter& writer, const Arguments& arguments)
+    {
+        writer.WriteVarU32((u32)Id);
+        std::apply([&writer](const auto&... argument)
+        {
+            (NetRpcArg<std::decay_t<decltype(argument)>>::Write(writer, argument), ...);
+        }, arguments);
+    }
+
+    static bool Read(BitReader& reader, Arguments& arguments)
+    {
+        std::apply([&reader](auto&... argument)
+        {
+            (NetRpcArg<std::decay_t<decltype(argument)>>::Read(reader, argument), ...);
+        }, arguments);
+        return !reader.HasOverflowed();
+    }
+};
+
+// One call of Rpc as a message, so it goes through WriteNetMessage, the batcher and SendTo like any other.
+template<typename Rpc>
+struct NetRpcCall : public NetMessage
+{
+    typename Rpc::Arguments Arguments;
+
+    template<typename... T>
+    explicit NetRpcCall(T&&... arguments) : NetMessage(ENetMsg::Rpc), Arguments(std::forward<T>(arguments)...) {}
+
+    void Serialize(BitWriter& writer) const
+    {
+        Rpc::Write(writer, Arguments);
+    }
+};
+
+template<typename Method, typename C, typename Arguments>
+struct NetRpcIsHandler;
+
+template<typename Method, typename C, typename... Args>
+struct NetRpcIsHandler<Method, C, std::tuple<Args...>> : std::is_invocable<Method, C&, u32, Args&...> {};
+
+// Bytes are the id and arguments, without the batch frame or packet header around them
+struct NetRpcStats
+{
+    u64 Sent = 0;
+    u64 SentBytes = 0;
+    u64 Received = 0;
+    u64 ReceivedBytes = 0;
+};
+
+// The handlers of one endpoint, one slot per ENetRpc. Dispatch reads the id and jumps straight to the
+// handler, which decodes the arguments onto the stack and calls it. Nothing is allocated on either side.
+class NetRpcTable
+{
+    struct Entry
+    {
+        bool (*Invoke)(void* instance, BitReader& reader, u32 peerId) = nullptr;
+        void* pInstance = nullptr;
+    };
+
+    Entry Entries[NetRpcCount];
+    NetRpcStats Stats[NetRpcCount];
+
+    template<typename Rpc, auto Method, typename C>
+    static bool InvokeThunk(void* instance, BitReader& reader, u32 peerId)
+    {
+        typename Rpc::Arguments arguments;
+        if(!Rpc::Read(reader, arguments))
+        {
+            return false;
+        }
+        std::apply([instance, peerId](auto&... argument) { (static_cast<C*>(instance)->*Method)(peerId, argument...); }, arguments);
+        return true;
+    }
+
+public:
+    NetRpcTable() = default;
+    NetRpcTable(const NetRpcTable&) = delete;
+    NetRpcTable& operator=(const NetRpcTable&) = delete;
+
+    // Calls of Rpc received from now on go to (instance.*Method)(peerId, arguments...).
+    template<typename Rpc, auto Method, typename C>
+    void Bind(C& instance)
+    {
+        static_assert(NetRpcIsHandler<decltype(Method), C, typename Rpc::Arguments>::value,
+                      "The handler must take the peer id and then the arguments of the RPC");
+        Entries[(u32)Rpc::Id] = {&InvokeThunk<Rpc, Method, C>, &instance};
+    }
+
+    // Queues a call with everything else batched for peerId this tick, on the channel its mode asks for.
+    template<typename Rpc, typename... T>
+    bool Call(NetBatcher& batcher, u32 peerId, T&&... arguments)
+    {
+        const typename Rpc::Arguments values(std::forward<T>(arguments)...);
+        u32 size = 0;
+        const bool bWritten = batcher.Write(peerId, Rpc::Channel, Rpc::Flags, ENetMsg::Rpc, [&values, &size](BitWriter& writer)
+        {
+            Rpc::Write(writer, values);
+            size = writer.GetBytesWritten();
+        });
+        if(bWritten)
+        {
+            NetRpcStats& stats = Stats[(u32)Rpc::Id];
+            stats.Sent++;
+            stats.SentBytes += size;
+        }
+        return bWritten;
+    }
+
+    // Counts a call sent some other way, for instance as a NetRpcCall through WriteNetMessage.
+    void RecordSent(ENetRpc id, u32 bytes);
+
+    // Runs the handler of the Rpc frame in reader. Returns false for an unknown or unbound id or malformed arguments.
+    bool Dispatch(BitReader& reader, u32 peerId);
+
+    [[nodiscard]] inline const NetRpcStats& GetStats(ENetRpc id) const { return Stats[(u32)id]; }
+};
+
+// The RPCs of the game.
+// Client to server: the newest snapshot the client has, the server deltas against it.
+using NetRpcSnapshotAck = NetRpcDecl<ENetRpc::SnapshotAck, ENetRpcMode::Unreliable, u32>;
+// Gateway to client: replication comes from another zone from now on, with its own snapshot sequence and clock.
+using NetRpcZoneTransfer = NetRpcDecl<ENetRpc::ZoneTransfer, ENetRpcMode::Reliable, u32>;
+
+#endif //X_NET_RPC_H
@@ -0,0 +1,498 @@
+#include "NetSnapshot.h"
+#include "../Components/NetworkComponent.h"
+#include "../Components/TransformComponent.h"
+#include <algorithm>
+
+NetEntityState NetEntityState::FromTransform(u32 netId, const CTransform3d& transform, const NetQuantization& quantization)
+{
+    NetEntityState state;
+    state.NetId = netId;
+    for(u32 axis = 0; axis < 3; axis++)
+    {
+        state.Position[axis] = NetQuantize::QuantizeFloat(transform.WorldPosition[axis], quantization.WorldMin[axis],
+                                                          quantization.WorldMax[axis], quantization.GetPositionBits(axis));
+        state.Rotation[axis] = NetQuantize::QuantizeAngle(transform.WorldRotation[axis], quantization.AngleBits);
+        state.Scale[axis] = NetQuantize::QuantizeFloat(transform.WorldScale[axis], 0.f, quantization.ScaleMax, quantization.ScaleBits);
+    }
+    return state;
+}
+
+void NetEntityState::ToTransform(CTransform3d& transform, const NetQuantization& quantization) const
+{
+    for(u32 axis = 0; axis < 3; axis++)
+    {
+        transform.WorldPosition[axis] = NetQuantize::DequantizeFloat(Position[axis], quantization.WorldMin[axis],
+                                                                     quantization.WorldMax[axis], quantization.GetPositionBits(axis));
+        transform.WorldRotation[axis] = NetQuantize::DequantizeAngle(Rotation[axis], quantization.AngleBits);
+        transform.WorldScale[axis] = NetQuantize::DequantizeFloat(Scale[axis], 0.f, quantization.ScaleMax, quantization.ScaleBits);
+    }
+}
+
+bool NetEntityState::operator==(const NetEntityState& other) const
+{
+    return NetId == other.NetId && std::equal(Position, Position + 3, other.Position) &&
+           std::equal(Rotation, Rotation + 3, other.Rotation) && std::equal(Scale, Scale + 3, other.Scale);
+}
+
+const NetEntityState* NetSnapshot::Find(u32 netId) const
+{
+    auto it = std::lower_bound(Entities.begin(), Entities.end(), netId,
+                               [](const NetEntityState& state, u32 id) { return state.NetId < id; });
+    return it != Entities.end() && it->NetId == netId ? &*it : nullptr;
+}
+
+namespace NetSnapshotCodec
+{
+enum EField : u32
+{
+    Position = 1 << 0,
+    Rotation = 1 << 1,
+    Scale = 1 << 2,
+};
+
+static constexpr u32 SmallDeltaBits = 8;
+
+static u32 ZigZag(i32 value)
+{
+    return ((u32)value << 1) ^ (u32)(value >> 31);
+}
+
+static i32 UnZigZag(u32 value)
+{
+    return (i32)(value >> 1) ^ -(i32)(value & 1);
+}
+
+// Small changes are sent as a zigzag delta, anything else as the full quantized value.
+static void WriteComponent(BitWriter& writer, u32 baseline, u32 value, u32 bits)
+{
+    u32 delta = ZigZag((i32)(value - baseline));
+    bool bSmall = delta < (1u << SmallDeltaBits);
+    writer.WriteBool(bSmall);
+    writer.WriteBits(bSmall ? delta : value, bSmall ? SmallDeltaBits : bits);
+}
+
+static u32 ReadComponent(BitReader& reader, u32 baseline, u32 bits)
+{
+    if(reader.ReadBool())
+    {
+        return baseline + (u32)UnZigZag(reader.ReadBits(SmallDeltaBits));
+    }
+    return reader.ReadBits(bits);
+}
+
+static void WriteField(BitWriter& writer, const u32* baseline, const u32* value, const u32* bits)
+{
+    for(u32 i = 0; i < 3; i++)
+    {
+        writer.WriteBool(baseline[i] != value[i]);
+        if(baseline[i] != value[i])
+        {
+            WriteComponent(writer, baseline[i], value[i], bits[i]);
+        }
+    }
+}
+
+static void ReadField(BitReader& reader, const u32* baseline, u32* value, const u32* bits)
+{
+    for(u32 i = 0; i < 3; i++)
+    {
+        value[i] = reader.ReadBool() ? ReadComponent(reader, baseline[i], bits[i]) : baseline[i];
+    }
+}
+
+static void GetFieldBits(const NetQuantization& quantization, u32* positionBits, u32* rotationBits, u32* scaleBits)
+{
+    for(u32 axis = 0; axis < 3; axis++)
+    {
+        positionBits[axis] = quantization.GetPositionBits(axis);
+        rotationBits[axis] = quantization.AngleBits;
+        scaleBits[axis] = quantization.ScaleBits;
+    }
+}
+
+static u32 GetChangedFields(const NetEntityState& a, const NetEntityState& b)
+{
+    u32 fields = 0;
+    if(!std::equal(a.Position, a.Position + 3, b.Position)) fields |= Position;
+    if(!std::equal(a.Rotation, a.Rotation + 3, b.Rotation)) fields |= Rotation;
+    if(!std::equal(a.Scale, a.Scale + 3, b.Scale)) fields |= Scale;
+    return fields;
+}
+
+static void WriteEntity(BitWriter& writer, const NetEntityState& state, const NetEntityState& old, bool bNew, u32 fields, u32 idDelta,
+                        const u32* positionBits, const u32* rotationBits, const u32* scaleBits)
+{
+    writer.WriteBool(true);
+    writer.WriteVarU32(idDelta);
+
+    writer.WriteBool(bNew);
+    if(!bNew)
+    {
+        writer.WriteBits(fields, 3);
+    }
+    if(fields & Position) WriteField(writer, old.Position, state.Position, positionBits);
+    if(fields & Rotation) WriteField(writer, old.Rotation, state.Rotation, rotationBits);
+    if(fields & Scale) WriteField(writer, old.Scale, state.Scale, scaleBits);
+}
+
+void Write(BitWriter& writer, const NetSnapshot& current, const NetSnapshot* baseline)
+{
+    static const NetSnapshot empty{};
+    const NetSnapshot& base = baseline ? *baseline : empty;
+
+    writer.WriteVarU32(current.Sequence);
+    writer.WriteVarU32(current.ServerTimeMs);
+    writer.WriteVarU32(current.AckedInput);
+    writer.WriteBool(baseline != nullptr);
+    if(baseline)
+    {
+        writer.WriteVarU32(current.Sequence - baseline->Sequence);
+    }
+
+    // Entities that left since the baseline
+    u32 lastId = 0;
+    size_t c = 0;
+    for(const NetEntityState& old : base.Entities)
+    {
+        while(c < current.Entities.size() && current.Entities[c].NetId < old.NetId)
+        {
+            c++;
+        }
+        if(c == current.Entities.size() || current.Entities[c].NetId != old.NetId)
+        {
+            writer.WriteBool(true);
+            writer.WriteVarU32(old.NetId - lastId);
+            lastId = old.NetId;
+        }
+    }
+    writer.WriteBool(false);
+
+    u32 positionBits[3], rotationBits[3], scaleBits[3];
+    GetFieldBits(GetNetQuantization(), positionBits, rotationBits, scaleBits);
+
+    // New and changed entities, unchanged ones cost nothing
+    static const NetEntityState zero{};
+    lastId = 0;
+    size_t b = 0;
+    for(const NetEntityState& state : current.Entities)
+    {
+        while(b < base.Entities.size() && base.Entities[b].NetId < state.NetId)
+        {
+            b++;
+        }
+        const bool bNew = b == base.Entities.size() || base.Entities[b].NetId != state.NetId;
+        const NetEntityState& old = bNew ? zero : base.Entities[b];
+        const u32 fields = bNew ? (Position | Rotation | Scale) : GetChangedFields(old, state);
+        if(fields == 0)
+        {
+            continue;
+        }
+
+        WriteEntity(writer, state, old, bNew, fields, state.NetId - lastId, positionBits, rotationBits, scaleBits);
+        lastId = state.NetId;
+    }
+    writer.WriteBool(false);
+}
+
+static u32 MeasureVarU32(u32 value)
+{
+    u32 bits = 8;
+    for(; value >= 0x80; value >>= 7)
+    {
+        bits += 8;
+    }
+    return bits;
+}
+
+u32 MeasureFrame(const NetSnapshot& current, const NetSnapshot* baseline)
+{
+    u32 bits = MeasureVarU32(current.Sequence) + MeasureVarU32(current.ServerTimeMs) + MeasureVarU32(current.AckedInput) + 1;
+    if(baseline)
+    {
+        bits += MeasureVarU32(current.Sequence - baseline->Sequence);
+        for(const NetEntityState& old : baseline->Entities)
+        {
+            if(!current.Find(old.NetId))
+            {
+                // The real id delta is never larger than the id itself
+                bits += 1 + MeasureVarU32(old.NetId);
+            }
+        }
+    }
+    // Both list terminators
+    return bits + 2;
+}
+
+u32 MeasureEntity(const NetEntityState& state, const NetEntityState* old)
+{
+    static const NetEntityState zero{};
+    const u32 fields = old ? GetChangedFields(*old, state) : (Position | Rotation | Scale);
+    if(fields == 0)
+    {
+        return 0;
+    }
+
+    u32 positionBits[3], rotationBits[3], scaleBits[3];
+    GetFieldBits(GetNetQuantization(), positionBits, rotationBits, scaleBits);
+
+    // Large enough for a new entity with every component sent in full
+    u8 scratch[64];
+    BitWriter writer(scratch, sizeof(scratch));
+    // The real id delta is never larger than the id itself
+    WriteEntity(writer, state, old ? *old : zero, old == nullptr, fields, state.NetId, positionBits, rotationBits, scaleBits);
+    return writer.GetBitsWritten();
+}
+
+void WriteState(BitWriter& writer, const NetEntityState& state, const NetEntityState& reference)
+{
+    u32 positionBits[3], rotationBits[3], scaleBits[3];
+    GetFieldBits(GetNetQuantization(), positionBits, rotationBits, scaleBits);
+
+    const u32 fields = GetChangedFields(reference, state);
+    writer.WriteBits(fields, 3);
+    if(fields & Position) WriteField(writer, reference.Position, state.Position, positionBits);
+    if(fields & Rotation) WriteField(writer, reference.Rotation, state.Rotation, rotationBits);
+    if(fields & Scale) WriteField(writer, reference.Scale, state.Scale, scaleBits);
+}
+
+bool ReadState(BitReader& reader, const NetEntityState& reference, NetEntityState& outState)
+{
+    u32 positionBits[3], rotationBits[3], scaleBits[3];
+    GetFieldBits(GetNetQuantization(), positionBits, rotationBits, scaleBits);
+
+    const u32 fields = reader.ReadBits(3);
+    const u32 netId = outState.NetId;
+    outState = reference;
+    outState.NetId = netId;
+    if(fields & Position) ReadField(reader, reference.Position, outState.Position, positionBits);
+    if(fields & Rotation) ReadField(reader, reference.Rotation, outState.Rotation, rotationBits);
+    if(fields & Scale) ReadField(reader, reference.Scale, outState.Scale, scaleBits);
+    return !reader.HasOverflowed();
+}
+
+bool ReadHeader(BitReader& reader, u32& outSequence, u32& outServerTimeMs, u32& outAckedInput, bool& outHasBaseline,
+                u32& outBaselineSequence)
+{
+    outSequence = reader.ReadVarU32();
+    outServerTimeMs = reader.ReadVarU32();
+    outAckedInput = reader.ReadVarU32();
+    outHasBaseline = reader.ReadBool();
+    outBaselineSequence = outHasBaseline ? outSequence - reader.ReadVarU32() : 0;
+    return !reader.HasOverflowed();
+}
+
+bool ReadBody(BitReader& reader, const NetSnapshot* baseline, NetSnapshot& outSnapshot)
+{
+    static const NetSnapshot empty{};
+    const NetSnapshot& base = baseline ? *baseline : empty;
+
+    std::vector<u32> removed;
+    u32 lastId = 0;
+    while(reader.ReadBool() && !reader.HasOverflowed())
+    {
+        lastId += reader.ReadVarU32();
+        removed.push_back(lastId);
+    }
+
+    // Start from the baseline minus everything that was removed
+    outSnapshot.Entities.clear();
+    outSnapshot.Entities.reserve(base.Entities.size());
+    size_t r = 0;
+    for(const NetEntityState& state : base.Entities)
+    {
+        while(r < removed.size() && removed[r] < state.NetId)
+        {
+            r++;
+        }
+        if(r == removed.size() || removed[r] != state.NetId)
+        {
+            outSnapshot.Entities.push_back(state);
+        }
+    }
+
+    u32 positionBits[3], rotationBits[3], scaleBits[3];
+    GetFieldBits(GetNetQuantization(), positionBits, rotationBits, scaleBits);
+
+    static const NetEntityState zero{};
+    lastId = 0;
+    while(reader.ReadBool() && !reader.HasOverflowed())
+    {
+        lastId += reader.ReadVarU32();
+        const bool bNew = reader.ReadBool();
+        const u32 fields = bNew ? (Position | Rotation | Scale) : reader.ReadBits(3);
+
+        auto it = std::lower_bound(outSnapshot.Entities.begin(), outSnapshot.Entities.end(), lastId,
+                                   [](const NetEntityState& state, u32 id) { return state.NetId < id; });
+        if(it == outSnapshot.Entities.end() || it->NetId != lastId)
+        {
+            if(!bNew)
+            {
+                return false;
+            }
+            it = outSnapshot.Entities.insert(it, zero);
+            it->NetId = lastId;
+        }
+
+        NetEntityState& state = *it;
+        const NetEntityState old = bNew ? zero : state;
+        if(fields & Position) ReadField(reader, old.Position, state.Position, positionBits);
+        if(fields & Rotation) ReadField(reader, old.Rotation, state.Rotation, rotationBits);
+        if(fields & Scale) ReadField(reader, old.Scale, state.Scale, scaleBits);
+    }
+
+    return !reader.HasOverflowed();
+}
+}
+
+void NetSnapshotSender::Capture(entt::registry& registry, u32 serverTimeMs, NetSnapshot& outSnapshot)
+{
+    const NetQuantization& quantization = GetNetQuantization();
+
+    outSnapshot.Sequence = ++Sequence;
+    outSnapshot.ServerTimeMs = serverTimeMs;
+    outSnapshot.Entities.clear();
+
+    auto view = registry.view<CNetwork, CTransform3d>();
+    for(entt::entity e : view)
+    {
+        outSnapshot.Entities.push_back(NetEntityState::FromTransform(view.get<CNetwork>(e).Id, view.get<CTransform3d>(e), quantization));
+    }
+    std::sort(outSnapshot.Entities.begin(), outSnapshot.Entities.end(),
+              [](const NetEntityState& a, const NetEntityState& b) { return a.NetId < b.NetId; });
+}
+
+void NetSnapshotSender::Select(const NetSnapshot& world, const std::vector<u32>& relevant, NetSnapshot& outSnapshot)
+{
+    outSnapshot.Sequence = world.Sequence;
+    outSnapshot.ServerTimeMs = world.ServerTimeMs;
+    outSnapshot.Entities.clear();
+
+    size_t r = 0;
+    for(const NetEntityState& state : world.Entities)
+    {
+        while(r < relevant.size() && relevant[r] < state.NetId)
+        {
+            r++;
+        }
+        if(r == relevant.size())
+        {
+            break;
+        }
+        if(relevant[r] == state.NetId)
+        {
+            outSnapshot.Entities.push_back(state);
+        }
+    }
+}
+
+const NetSnapshot* NetSnapshotSender::GetBaseline(u32 peerId, u32 sequence) const
+{
+    auto it = Clients.find(peerId);
+    if(it == Clients.end())
+    {
+        return nullptr;
+    }
+
+    // Only baselines the client has acknowledged and we still remember are usable, anything else falls back to full state
+    const ClientHistory& client = it->second;
+    if(client.bHasAck && sequence - client.LastAcked < NetSnapshotHistorySize)
+    {
+        return client.Sent.Find(client.LastAcked);
+    }
+    return nullptr;
+}
+
+const NetSnapshot* NetSnapshotSender::GetLastSent(u32 peerId) const
+{
+    auto it = Clients.find(peerId);
+    return it != Clients.end() && it->second.bHasSent ? it->second.Sent.Find(it->second.LastSent) : nullptr;
+}
+
+bool NetSnapshotSender::Encode(u32 peerId, const NetSnapshot& snapshot, BitWriter& writer)
+{
+    NetSnapshotCodec::Write(writer, snapshot, GetBaseline(peerId, snapshot.Sequence));
+    if(writer.HasOverflowed())
+    {
+        return false;
+    }
+
+    ClientHistory& client = Clients[peerId];
+    NetSnapshot& sent = client.Sent.Insert(snapshot.Sequence);
+    sent.ServerTimeMs = snapshot.ServerTimeMs;
+    sent.Entities = snapshot.Entities;
+    client.LastSent = snapshot.Sequence;
+    client.bHasSent = true;
+    return true;
+}
+
+void NetSnapshotSender::Acknowledge(u32 peerId, u32 sequence)
+{
+    auto it = Clients.find(peerId);
+    if(it == Clients.end())
+    {
+        return;
+    }
+
+    ClientHistory& client = it->second;
+    if(!client.bHasAck || (i32)(sequence - client.LastAcked) > 0)
+    {
+        client.LastAcked = sequence;
+        client.bHasAck = true;
+    }
+}
+
+void NetSnapshotSender::RemoveClient(u32 peerId)
+{
+    Clients.erase(peerId);
+}
+
+bool NetSnapshotReceiver::Receive(BitReader& reader)
+{
+    u32 sequence, serverTimeMs, ackedInput, baselineSequence;
+    bool bHasBaseline;
+    if(!NetSnapshotCodec::ReadHeader(reader, sequence, serverTimeMs, ackedInput, bHasBaseline, baselineSequence))
+    {
+        return false;
+    }
+
+    if(bHasLatest && (i32)(sequence - Latest.Sequence) <= 0)
+    {
+        return false;
+    }
+
+    const NetSnapshot* baseline = nullptr;
+    if(bHasBaseline && !(baseline = Received.Find(baselineSequence)))
+    {
+        return false;
+    }
+
+    Scratch.Sequence = sequence;
+    Scratch.ServerTimeMs = serverTimeMs;
+    Scratch.AckedInput = ackedInput;
+    if(!NetSnapshotCodec::ReadBody(reader, baseline, Scratch))
+    {
+        return false;
+    }
+
+    std::swap(Previous, Latest);
+    Latest = Scratch;
+    NetSnapshot& received = Received.Insert(sequence);
+    received.ServerTimeMs = serverTimeMs;
+    received.Entities = Scratch.Entities;
+    bHasLatest = true;
+    return true;
+}
+
+void NetSnapshotReceiver::Clear()
+{
+    Received.Clear();
+    Latest = NetSnapshot{};
+    Previous = NetSnapshot{};
+    bHasLatest = false;
+}
+
+void NetSnapshotReceiver::Restart()
+{
+    Received.Clear();
+    bHasLatest = false;
+}
@@ -0,0 +1,157 @@
+#ifndef X_NET_SNAPSHOT_H
+#define X_NET_SNAPSHOT_H
+
+#include "../Core/defines.h"
+#include "BitStream.h"
+#include "NetQuantize.h"
+#include <entt.hpp>
+#include <unordered_map>
+#include <vector>
+
+struct CTransform3d;
+
+// Replicated state of one entity, kept in quantized form so that deltas are exact.
+struct NetEntityState
+{
+    u32 NetId = 0;
+    u32 Position[3] = {};
+    u32 Rotation[3] = {};
+    u32 Scale[3] = {};
+
+    static NetEntityState FromTransform(u32 netId, const CTransform3d& transform, const NetQuantization& quantization);
+    void ToTransform(CTransform3d& transform, const NetQuantization& quantization) const;
+
+    [[nodiscard]] bool operator==(const NetEntityState& other) const;
+    [[nodiscard]] bool operator!=(const NetEntityState& other) const { return !(*this == other); }
+};
+
+struct NetSnapshot
+{
+    u32 Sequence = 0;
+    u32 ServerTimeMs = 0;
+    // Newest input command of the receiving client the server had simulated when this was taken
+    u32 AckedInput = 0;
+    // Sorted by NetId
+    std::vector<NetEntityState> Entities;
+
+    [[nodiscard]] const NetEntityState* Find(u32 netId) const;
+};
+
+template<u32 Size>
+class NetSnapshotBuffer
+{
+    static_assert((Size & (Size - 1)) == 0, "NetSnapshotBuffer size must be a power of two");
+
+    NetSnapshot Snapshots[Size];
+    bool bValid[Size] = {};
+
+public:
+    NetSnapshot& Insert(u32 sequence)
+    {
+        NetSnapshot& snapshot = Snapshots[sequence & (Size - 1)];
+        bValid[sequence & (Size - 1)] = true;
+        snapshot.Sequence = sequence;
+        snapshot.Entities.clear();
+        return snapshot;
+    }
+
+    [[nodiscard]] const NetSnapshot* Find(u32 sequence) const
+    {
+        const u32 slot = sequence & (Size - 1);
+        return bValid[slot] && Snapshots[slot].Sequence == sequence ? &Snapshots[slot] : nullptr;
+    }
+
+    void Clear()
+    {
+        for(bool& valid : bValid)
+        {
+            valid = false;
+        }
+    }
+};
+
+constexpr u32 NetSnapshotHistorySize = 32;
+
+namespace NetSnapshotCodec
+{
+// Encodes current against baseline, or as full state when baseline is null.
+void Write(BitWriter& writer, const NetSnapshot& current, const NetSnapshot* baseline);
+
+// Reads the snapshot header. Returns false if the stream is malformed.
+bool ReadHeader(BitReader& reader, u32& outSequence, u32& outServerTimeMs, u32& outAckedInput, bool& outHasBaseline,
+                u32& outBaselineSequence);
+
+// Reconstructs the full snapshot from the remaining stream and its baseline.
+bool ReadBody(BitReader& reader, const NetSnapshot* baseline, NetSnapshot& outSnapshot);
+
+// Upper bound of the bits a snapshot takes besides its entities: the header, the entities of baseline
+// that current no longer has and the list terminators.
+u32 MeasureFrame(const NetSnapshot& current, const NetSnapshot* baseline);
+
+// Upper bound of the bits one entity adds to a snapshot, against old or as a new entity when old is null.
+// Zero when it equals old, Write skips it.
+u32 MeasureEntity(const NetEntityState& state, const NetEntityState* old);
+
+// Transform of one entity against reference, which may be a different entity. Ids are left to the caller.
+void WriteState(BitWriter& writer, const NetEntityState& state, const NetEntityState& reference);
+bool ReadState(BitReader& reader, const NetEntityState& reference, NetEntityState& outState);
+}
+
+// Server side: per-client history of sent snapshots and the latest acknowledged one.
+class NetSnapshotSender
+{
+    struct ClientHistory
+    {
+        NetSnapshotBuffer<NetSnapshotHistorySize> Sent;
+        u32 LastAcked = 0;
+        u32 LastSent = 0;
+        bool bHasAck = false;
+        bool bHasSent = false;
+    };
+
+    std::unordered_map<u32, ClientHistory> Clients;
+    u32 Sequence = 0;
+
+public:
+    // Builds the next snapshot from every CNetwork entity with a transform.
+    void Capture(entt::registry& registry, u32 serverTimeMs, NetSnapshot& outSnapshot);
+
+    // Restricts a captured snapshot to the sorted ids relevant to one client.
+    static void Select(const NetSnapshot& world, const std::vector<u32>& relevant, NetSnapshot& outSnapshot);
+
+    // Writes the snapshot message body for one client and records it as sent. Returns false on overflow.
+    bool Encode(u32 peerId, const NetSnapshot& snapshot, BitWriter& writer);
+
+    // The snapshot the next one will be delta encoded against, or null if it will be sent as full state.
+    [[nodiscard]] const NetSnapshot* GetBaseline(u32 peerId, u32 sequence) const;
+    // The newest snapshot sent to a client, acknowledged or not.
+    [[nodiscard]] const NetSnapshot* GetLastSent(u32 peerId) const;
+
+    void Acknowledge(u32 peerId, u32 sequence);
+    void RemoveClient(u32 peerId);
+};
+
+// Client side: reconstructs full snapshots from deltas.
+class NetSnapshotReceiver
+{
+    NetSnapshotBuffer<NetSnapshotHistorySize> Received;
+    NetSnapshot Scratch;
+    NetSnapshot Latest;
+    NetSnapshot Previous;
+    bool bHasLatest = false;
+
+public:
+    // Decodes a snapshot message body. Stale snapshots and deltas against an unknown baseline return false.
+    bool Receive(BitReader& reader);
+
+    // The newest reconstructed snapshot and the one it replaced, which is empty after the first snapshot.
+    [[nodiscard]] inline const NetSnapshot& GetLatest() const { return Latest; }
+    [[nodiscard]] inline const NetSnapshot& GetPrevious() const { return Previous; }
+
+    void Clear();
+    // For a switch to another server: forgets the history and sequence but keeps the latest snapshot, so
+    // the first full snapshot of the new server still removes whatever that server does not have.
+    void Restart();
+};
+
+#endif //X_NET_SNAPSHOT_H
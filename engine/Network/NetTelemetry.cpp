@@ -0,0 +1,240 @@
+#include "NetTelemetry.h"
+
+const char* GetNetMsgName(ENetMsg type)
+{
+    switch(type)
+    {
+        case ENetMsg::None: return "None";
+        case ENetMsg::SpawnEntity: return "SpawnEntity";
+        case ENetMsg::KillEntity: return "KillEntity";
+        case ENetMsg::UpdateEntity: return "UpdateEntity";
+        case ENetMsg::AddComponent: return "AddComponent";
+        case ENetMsg::Snapshot: return "Snapshot";
+        case ENetMsg::Batch: return "Batch";
+        case ENetMsg::ViewUpdate: return "ViewUpdate";
+        case ENetMsg::Input: return "Input";
+        case ENetMsg::Rpc: return "Rpc";
+        case ENetMsg::Compressed: return "Compressed";
+        case ENetMsg::LockstepStart: return "LockstepStart";
+        case ENetMsg::LockstepInput: return "LockstepInput";
+        case ENetMsg::LockstepTurn: return "LockstepTurn";
+        case ENetMsg::LockstepDesync: return "LockstepDesync";
+        case ENetMsg::WorldChunk: return "WorldChunk";
+        case ENetMsg::ZoneAttach: return "ZoneAttach";
+        case ENetMsg::ZoneGhosts: return "ZoneGhosts";
+        case ENetMsg::ZoneHandoff: return "ZoneHandoff";
+        default: return "Unknown";
+    }
+}
+
+void NetTelemetry::RecordReceive(u32 peerId, u32 bytes)
+{
+    if(peerId < NetTelemetryMaxPeers)
+    {
+        Peers[peerId].BytesIn.fetch_add(bytes, std::memory_order_relaxed);
+        Peers[peerId].PacketsIn.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void NetTelemetry::RecordSend(u32 peerId, u32 bytes)
+{
+    if(peerId < NetTelemetryMaxPeers)
+    {
+        Peers[peerId].BytesOut.fetch_add(bytes, std::memory_order_relaxed);
+        Peers[peerId].PacketsOut.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void NetTelemetry::UpdatePeer(u32 peerId, const ENetPeer& peer)
+{
+    if(peerId >= NetTelemetryMaxPeers)
+    {
+        return;
+    }
+
+    PeerCounters& counters = Peers[peerId];
+    counters.bConnected.store(peer.state == ENET_PEER_STATE_CONNECTED, std::memory_order_relaxed);
+    counters.RoundTripMs.store(peer.roundTripTime, std::memory_order_relaxed);
+    counters.RoundTripVarianceMs.store(peer.roundTripTimeVariance, std::memory_order_relaxed);
+    counters.PacketLoss.store(peer.packetLoss, std::memory_order_relaxed);
+}
+
+void NetTelemetry::RecordEncoded(ENetMsg type, u32 bytes, f64 seconds)
+{
+    if((u32)type < NetMsgTypeCount)
+    {
+        TypeCounters& counters = Types[(u32)type];
+        counters.MessagesOut.fetch_add(1, std::memory_order_relaxed);
+        counters.BytesOut.fetch_add(bytes, std::memory_order_relaxed);
+        counters.EncodeNs.fetch_add((u64)(seconds * 1e9), std::memory_order_relaxed);
+    }
+}
+
+void NetTelemetry::RecordDecoded(ENetMsg type, u32 bytes, f64 seconds)
+{
+    if((u32)type < NetMsgTypeCount)
+    {
+        TypeCounters& counters = Types[(u32)type];
+        counters.MessagesIn.fetch_add(1, std::memory_order_relaxed);
+        counters.BytesIn.fetch_add(bytes, std::memory_order_relaxed);
+        counters.DecodeNs.fetch_add((u64)(seconds * 1e9), std::memory_order_relaxed);
+    }
+}
+
+void NetTelemetry::SetQueueDepths(u32 inbound, u32 outbound)
+{
+    InboundDepth.store(inbound, std::memory_order_relaxed);
+    OutboundDepth.store(outbound, std::memory_order_relaxed);
+}
+
+void NetTelemetry::Sample(f64 time, NetTelemetrySample& outSample) const
+{
+    outSample.Time = time;
+    outSample.InboundDepth = InboundDepth.load(std::memory_order_relaxed);
+    outSample.OutboundDepth = OutboundDepth.load(std::memory_order_relaxed);
+    for(u32 i = 0; i < NetTelemetryMaxPeers; i++)
+    {
+        const PeerCounters& counters = Peers[i];
+        NetPeerSample& peer = outSample.Peers[i];
+        peer.bConnected = counters.bConnected.load(std::memory_order_relaxed);
+        peer.BytesIn = counters.BytesIn.load(std::memory_order_relaxed);
+        peer.BytesOut = counters.BytesOut.load(std::memory_order_relaxed);
+        peer.PacketsIn = counters.PacketsIn.load(std::memory_order_relaxed);
+        peer.PacketsOut = counters.PacketsOut.load(std::memory_order_relaxed);
+        peer.RoundTripMs = counters.RoundTripMs.load(std::memory_order_relaxed);
+        peer.RoundTripVarianceMs = counters.RoundTripVarianceMs.load(std::memory_order_relaxed);
+        peer.PacketLoss = (f32)counters.PacketLoss.load(std::memory_order_relaxed) / (f32)ENET_PEER_PACKET_LOSS_SCALE;
+    }
+    for(u32 i = 0; i < NetMsgTypeCount; i++)
+    {
+        const TypeCounters& counters = Types[i];
+        NetTypeSample& type = outSample.Types[i];
+        type.MessagesIn = counters.MessagesIn.load(std::memory_order_relaxed);
+        type.MessagesOut = counters.MessagesOut.load(std::memory_order_relaxed);
+        type.BytesIn = counters.BytesIn.load(std::memory_order_relaxed);
+        type.BytesOut = counters.BytesOut.load(std::memory_order_relaxed);
+        type.EncodeNs = counters.EncodeNs.load(std::memory_order_relaxed);
+        type.DecodeNs = counters.DecodeNs.load(std::memory_order_relaxed);
+    }
+}
+
+NetTelemetryWriter::~NetTelemetryWriter()
+{
+    Close();
+}
+
+bool NetTelemetryWriter::Open(const std::string& path)
+{
+    Close();
+    if(pFile = fopen(path.c_str(), "w"); !pFile)
+    {
+        return false;
+    }
+
+    bJson = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    if(!bJson)
+    {
+        fputs("time,kind,id,bytes_in_per_s,bytes_out_per_s,packets_in_per_s,packets_out_per_s,rtt_ms,rtt_variance_ms,"
+              "packet_loss,encode_us,decode_us,inbound_queue,outbound_queue\n", pFile);
+    }
+    return true;
+}
+
+void NetTelemetryWriter::Write(const NetTelemetrySample& current, const NetTelemetrySample& previous)
+{
+    if(!pFile)
+    {
+        return;
+    }
+
+    const f64 seconds = current.Time - previous.Time;
+    if(seconds <= 0.0)
+    {
+        return;
+    }
+    auto rate = [seconds](u64 now, u64 before) { return (f64)(now - before) / seconds; };
+    auto mean = [](u64 ns, u64 count) { return count > 0 ? (f64)ns / (f64)count / 1e3 : 0.0; };
+
+    if(bJson)
+    {
+        fprintf(pFile, "{\"time\":%.3f,\"inbound_queue\":%u,\"outbound_queue\":%u,\"peers\":[", current.Time,
+                current.InboundDepth, current.OutboundDepth);
+    }
+
+    bool bFirst = true;
+    for(u32 i = 0; i < NetTelemetryMaxPeers; i++)
+    {
+        const NetPeerSample& now = current.Peers[i];
+        const NetPeerSample& before = previous.Peers[i];
+        if(!now.bConnected)
+        {
+            continue;
+        }
+        if(bJson)
+        {
+            fprintf(pFile, "%s{\"id\":%u,\"bytes_in_per_s\":%.1f,\"bytes_out_per_s\":%.1f,\"packets_in_per_s\":%.1f,"
+                    "\"packets_out_per_s\":%.1f,\"rtt_ms\":%u,\"rtt_variance_ms\":%u,\"packet_loss\":%.4f}",
+                    bFirst ? "" : ",", i, rate(now.BytesIn, before.BytesIn), rate(now.BytesOut, before.BytesOut),
+                    rate(now.PacketsIn, before.PacketsIn), rate(now.PacketsOut, before.PacketsOut), now.RoundTripMs,
+                    now.RoundTripVarianceMs, now.PacketLoss);
+        }
+        else
+        {
+            fprintf(pFile, "%.3f,peer,%u,%.1f,%.1f,%.1f,%.1f,%u,%u,%.4f,,,%u,%u\n", current.Time, i,
+                    rate(now.BytesIn, before.BytesIn), rate(now.BytesOut, before.BytesOut), rate(now.PacketsIn, before.PacketsIn),
+                    rate(now.PacketsOut, before.PacketsOut), now.RoundTripMs, now.RoundTripVarianceMs, now.PacketLoss,
+                    current.InboundDepth, current.OutboundDepth);
+        }
+        bFirst = false;
+    }
+
+    if(bJson)
+    {
+        fputs("],\"types\":[", pFile);
+    }
+
+    bFirst = true;
+    for(u32 i = 0; i < NetMsgTypeCount; i++)
+    {
+        const NetTypeSample& now = current.Types[i];
+        const NetTypeSample& before = previous.Types[i];
+        if(now.MessagesIn == 0 && now.MessagesOut == 0)
+        {
+            continue;
+        }
+        const u64 messagesIn = now.MessagesIn - before.MessagesIn, messagesOut = now.MessagesOut - before.MessagesOut;
+        const f64 encodeUs = mean(now.EncodeNs - before.EncodeNs, messagesOut);
+        const f64 decodeUs = mean(now.DecodeNs - before.DecodeNs, messagesIn);
+        if(bJson)
+        {
+            fprintf(pFile, "%s{\"type\":\"%s\",\"bytes_in_per_s\":%.1f,\"bytes_out_per_s\":%.1f,\"messages_in_per_s\":%.1f,"
+                    "\"messages_out_per_s\":%.1f,\"encode_us\":%.3f,\"decode_us\":%.3f}",
+                    bFirst ? "" : ",", GetNetMsgName((ENetMsg)i), rate(now.BytesIn, before.BytesIn),
+                    rate(now.BytesOut, before.BytesOut), rate(now.MessagesIn, before.MessagesIn),
+                    rate(now.MessagesOut, before.MessagesOut), encodeUs, decodeUs);
+        }
+        else
+        {
+            // Messages take the place of packets for message types
+            fprintf(pFile, "%.3f,type,%s,%.1f,%.1f,%.1f,%.1f,,,,%.3f,%.3f,%u,%u\n", current.Time, GetNetMsgName((ENetMsg)i),
+                    rate(now.BytesIn, before.BytesIn), rate(now.BytesOut, before.BytesOut), rate(now.MessagesIn, before.MessagesIn),
+                    rate(now.MessagesOut, before.MessagesOut), encodeUs, decodeUs, current.InboundDepth, current.OutboundDepth);
+        }
+        bFirst = false;
+    }
+
+    if(bJson)
+    {
+        fputs("]}\n", pFile);
+    }
+    fflush(pFile);
+}
+
+void NetTelemetryWriter::Close()
+{
+    if(pFile)
+    {
+        fclose(pFile);
+        pFile = nullptr;
+    }
+}
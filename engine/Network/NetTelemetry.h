@@ -0,0 +1,118 @@
+#ifndef X_NET_TELEMETRY_H
+#define X_NET_TELEMETRY_H
+
+#include "../Core/defines.h"
+#include <../../vendor/enet/include/enet/enet.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include "NetMessage.h"
+
+constexpr u32 NetTelemetryMaxPeers = 64;
+constexpr u32 NetMsgTypeCount = (u32)ENetMsg::Count;
+
+const char* GetNetMsgName(ENetMsg type);
+
+struct NetPeerSample
+{
+    bool bConnected = false;
+    u64 BytesIn = 0;
+    u64 BytesOut = 0;
+    u64 PacketsIn = 0;
+    u64 PacketsOut = 0;
+    u32 RoundTripMs = 0;
+    u32 RoundTripVarianceMs = 0;
+    // Reliable packet loss as a fraction, ENet's running mean
+    f32 PacketLoss = 0.f;
+};
+
+struct NetTypeSample
+{
+    u64 MessagesIn = 0;
+    u64 MessagesOut = 0;
+    u64 BytesIn = 0;
+    u64 BytesOut = 0;
+    u64 EncodeNs = 0;
+    u64 DecodeNs = 0;
+};
+
+// Copy of every counter at one point in time. Totals since start, rates come from two samples.
+struct NetTelemetrySample
+{
+    f64 Time = 0.0;
+    u32 InboundDepth = 0;
+    u32 OutboundDepth = 0;
+    NetPeerSample Peers[NetTelemetryMaxPeers];
+    NetTypeSample Types[NetMsgTypeCount];
+};
+
+// Per-peer and per-message-type counters. Each counter is a relaxed atomic so the network thread
+// and the game thread can both record without locks, and any thread can take a sample.
+class NetTelemetry
+{
+    struct PeerCounters
+    {
+        std::atomic<bool> bConnected{false};
+        std::atomic<u64> BytesIn{0};
+        std::atomic<u64> BytesOut{0};
+        std::atomic<u64> PacketsIn{0};
+        std::atomic<u64> PacketsOut{0};
+        std::atomic<u32> RoundTripMs{0};
+        std::atomic<u32> RoundTripVarianceMs{0};
+        std::atomic<u32> PacketLoss{0};
+    };
+
+    struct TypeCounters
+    {
+        std::atomic<u64> MessagesIn{0};
+        std::atomic<u64> MessagesOut{0};
+        std::atomic<u64> BytesIn{0};
+        std::atomic<u64> BytesOut{0};
+        std::atomic<u64> EncodeNs{0};
+        std::atomic<u64> DecodeNs{0};
+    };
+
+    PeerCounters Peers[NetTelemetryMaxPeers];
+    TypeCounters Types[NetMsgTypeCount];
+    std::atomic<u32> InboundDepth{0};
+    std::atomic<u32> OutboundDepth{0};
+
+public:
+    // Whole packets as handed to or received from ENet.
+    void RecordReceive(u32 peerId, u32 bytes);
+    void RecordSend(u32 peerId, u32 bytes);
+
+    // Copies ENet's RTT, RTT variance and packet loss estimates of a peer.
+    void UpdatePeer(u32 peerId, const ENetPeer& peer);
+
+    // Single messages, including their frame header when batched.
+    void RecordEncoded(ENetMsg type, u32 bytes, f64 seconds);
+    void RecordDecoded(ENetMsg type, u32 bytes, f64 seconds);
+
+    void SetQueueDepths(u32 inbound, u32 outbound);
+
+    void Sample(f64 time, NetTelemetrySample& outSample) const;
+};
+
+// Writes one record per sample interval: CSV with a row per connected peer and per message type seen,
+// or JSON lines with one object per interval when the path ends in .json. Rates are per second over
+// the interval, encode and decode times are the mean per message.
+class NetTelemetryWriter
+{
+    FILE* pFile = nullptr;
+    bool bJson = false;
+
+public:
+    NetTelemetryWriter() = default;
+    NetTelemetryWriter(const NetTelemetryWriter&) = delete;
+    NetTelemetryWriter& operator=(const NetTelemetryWriter&) = delete;
+    ~NetTelemetryWriter();
+
+    bool Open(const std::string& path);
+    void Write(const NetTelemetrySample& current, const NetTelemetrySample& previous);
+    void Close();
+
+    [[nodiscard]] inline bool IsOpen() const { return pFile != nullptr; }
+};
+
+#endif //X_NET_TELEMETRY_H
@@ -0,0 +1,219 @@
+#include "NetTransport.h"
+#include <cstring>
+
+#ifdef __linux__
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+// ENet's own socket calls behind the interface, so both kinds report the same statistics.
+class NetSocketTransport final : public NetTransport
+{
+public:
+    i32 Send(ENetSocket socket, const ENetAddress& address, const ENetBuffer* buffers, size_t bufferCount) override
+    {
+        Stats.SendCalls++;
+        const i32 sent = enet_socket_send(socket, &address, buffers, bufferCount);
+        Stats.Sent += sent > 0;
+        return sent;
+    }
+
+    i32 Receive(ENetSocket socket, ENetAddress& outAddress, ENetBuffer& buffer) override
+    {
+        Stats.ReceiveCalls++;
+        const i32 received = enet_socket_receive(socket, &outAddress, &buffer, 1);
+        Stats.Received += received > 0;
+        return received;
+    }
+
+    [[nodiscard]] ENetTransportKind GetKind() const override { return ENetTransportKind::Socket; }
+};
+
+#ifdef __linux__
+// Servers with many peers spend most of their network time entering the kernel once per datagram.
+// Sends are copied into a batch that goes out in one sendmmsg when ENet is done with a pass over
+// its peers, receives are read a batch at a time with recvmmsg and handed to ENet one by one.
+class NetBatchedTransport final : public NetTransport
+{
+    static constexpr u32 BatchSize = 64;
+
+    struct Batch
+    {
+        mmsghdr Headers[BatchSize] = {};
+        iovec Vectors[BatchSize] = {};
+        sockaddr_in Addresses[BatchSize] = {};
+        u8 Data[BatchSize][ENET_PROTOCOL_MAXIMUM_MTU];
+        u32 Count = 0;
+
+        Batch()
+        {
+            for(u32 i = 0; i < BatchSize; i++)
+            {
+                Vectors[i].iov_base = Data[i];
+                Vectors[i].iov_len = sizeof(Data[i]);
+                Headers[i].msg_hdr.msg_iov = &Vectors[i];
+                Headers[i].msg_hdr.msg_iovlen = 1;
+                Headers[i].msg_hdr.msg_name = &Addresses[i];
+                Headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            }
+        }
+    };
+
+    // Large enough to keep off the stack and out of the object that owns the transport
+    std::unique_ptr<Batch> Outgoing = std::make_unique<Batch>();
+    std::unique_ptr<Batch> Incoming = std::make_unique<Batch>();
+    u32 NextIncoming = 0;
+
+public:
+    i32 Send(ENetSocket socket, const ENetAddress& address, const ENetBuffer* buffers, size_t bufferCount) override
+    {
+        if(Outgoing->Count == BatchSize)
+        {
+            Flush(socket);
+        }
+
+        const u32 slot = Outgoing->Count;
+        size_t size = 0;
+        for(size_t i = 0; i < bufferCount; i++)
+        {
+            if(size + buffers[i].dataLength > sizeof(Outgoing->Data[slot]))
+            {
+                return -1;
+            }
+            memcpy(Outgoing->Data[slot] + size, buffers[i].data, buffers[i].dataLength);
+            size += buffers[i].dataLength;
+        }
+
+        sockaddr_in& to = Outgoing->Addresses[slot];
+        to = {};
+        to.sin_family = AF_INET;
+        to.sin_port = ENET_HOST_TO_NET_16(address.port);
+        to.sin_addr.s_addr = address.host;
+        Outgoing->Vectors[slot].iov_len = size;
+        Outgoing->Count++;
+        return (i32)size;
+    }
+
+    void Flush(ENetSocket socket) override
+    {
+        for(u32 first = 0; first < Outgoing->Count;)
+        {
+            Stats.SendCalls++;
+            const i32 sent = sendmmsg(socket, Outgoing->Headers + first, Outgoing->Count - first, MSG_NOSIGNAL);
+            if(sent <= 0)
+            {
+                // Full socket buffer or an error, the rest is lost like any other datagram and ENet resends what was reliable
+                break;
+            }
+            Stats.Sent += (u64)sent;
+            first += (u32)sent;
+        }
+        Outgoing->Count = 0;
+    }
+
+    i32 Receive(ENetSocket socket, ENetAddress& outAddress, ENetBuffer& buffer) override
+    {
+        if(NextIncoming == Incoming->Count)
+        {
+            NextIncoming = 0;
+            Incoming->Count = 0;
+            for(u32 i = 0; i < BatchSize; i++)
+            {
+                Incoming->Headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+                Incoming->Headers[i].msg_hdr.msg_flags = 0;
+            }
+            Stats.ReceiveCalls++;
+            const i32 received = recvmmsg(socket, Incoming->Headers, BatchSize, MSG_DONTWAIT, nullptr);
+            if(received < 0)
+            {
+                return errno == EWOULDBLOCK || errno == EAGAIN ? 0 : -1;
+            }
+            Incoming->Count = (u32)received;
+            Stats.Received += (u64)received;
+            if(received == 0)
+            {
+                return 0;
+            }
+        }
+
+        const u32 slot = NextIncoming++;
+        const mmsghdr& header = Incoming->Headers[slot];
+        if((header.msg_hdr.msg_flags & MSG_TRUNC) || header.msg_len > buffer.dataLength)
+        {
+            return -1;
+        }
+        outAddress.host = (enet_uint32)Incoming->Addresses[slot].sin_addr.s_addr;
+        outAddress.port = ENET_NET_TO_HOST_16(Incoming->Addresses[slot].sin_port);
+        memcpy(buffer.data, Incoming->Data[slot], header.msg_len);
+        return (i32)header.msg_len;
+    }
+
+    [[nodiscard]] ENetTransportKind GetKind() const override { return ENetTransportKind::Batched; }
+};
+#endif
+
+NetTransport::~NetTransport()
+{
+    // Too late to flush, the derived transport is already gone
+    if(pHost)
+    {
+        enet_host_transport(pHost, nullptr);
+    }
+}
+
+std::unique_ptr<NetTransport> NetTransport::Create(ENetTransportKind kind)
+{
+    switch(kind)
+    {
+        case ENetTransportKind::Socket:
+            return std::make_unique<NetSocketTransport>();
+        case ENetTransportKind::Batched:
+#ifdef __linux__
+            return std::make_unique<NetBatchedTransport>();
+#else
+            return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+void NetTransport::Attach(ENetHost* host)
+{
+    Detach();
+    pHost = host;
+    ENetTransport transport{};
+    transport.context = this;
+    transport.send = &NetTransport::SendCallback;
+    transport.receive = &NetTransport::ReceiveCallback;
+    transport.flush = &NetTransport::FlushCallback;
+    enet_host_transport(host, &transport);
+}
+
+void NetTransport::Detach()
+{
+    if(!pHost)
+    {
+        return;
+    }
+    // Nothing queued may outlive the transport
+    Flush(pHost->socket);
+    enet_host_transport(pHost, nullptr);
+    pHost = nullptr;
+}
+
+int ENET_CALLBACK NetTransport::SendCallback(void* context, ENetSocket socket, const ENetAddress* address,
+                                             const ENetBuffer* buffers, size_t bufferCount)
+{
+    return static_cast<NetTransport*>(context)->Send(socket, *address, buffers, bufferCount);
+}
+
+int ENET_CALLBACK NetTransport::ReceiveCallback(void* context, ENetSocket socket, ENetAddress* address, ENetBuffer* buffer)
+{
+    return static_cast<NetTransport*>(context)->Receive(socket, *address, *buffer);
+}
+
+void ENET_CALLBACK NetTransport::FlushCallback(void* context, ENetSocket socket)
+{
+    static_cast<NetTransport*>(context)->Flush(socket);
+}
@@ -0,0 +1,62 @@
+#ifndef X_NET_TRANSPORT_H
+#define X_NET_TRANSPORT_H
+
+#include "../Core/defines.h"
+#include <../../vendor/enet/include/enet/enet.h>
+#include <memory>
+
+enum class ENetTransportKind : u8
+{
+    // One system call per datagram, what ENet does on its own
+    Socket,
+    // Linux only: queues datagrams and moves up to a batch per sendmmsg and recvmmsg
+    Batched,
+};
+
+struct NetTransportStats
+{
+    u64 SendCalls = 0;
+    u64 Sent = 0;
+    u64 ReceiveCalls = 0;
+    u64 Received = 0;
+};
+
+// Datagram I/O under an ENet host. ENet keeps doing connections, reliability, ordering and
+// fragmentation on top, a transport only decides how datagrams get into and out of the kernel.
+class NetTransport
+{
+    ENetHost* pHost = nullptr;
+
+    static int ENET_CALLBACK SendCallback(void* context, ENetSocket socket, const ENetAddress* address,
+                                          const ENetBuffer* buffers, size_t bufferCount);
+    static int ENET_CALLBACK ReceiveCallback(void* context, ENetSocket socket, ENetAddress* address, ENetBuffer* buffer);
+    static void ENET_CALLBACK FlushCallback(void* context, ENetSocket socket);
+
+protected:
+    NetTransportStats Stats;
+
+public:
+    NetTransport() = default;
+    NetTransport(const NetTransport&) = delete;
+    NetTransport& operator=(const NetTransport&) = delete;
+    virtual ~NetTransport();
+
+    // Null if the kind is not available on this platform.
+    static std::unique_ptr<NetTransport> Create(ENetTransportKind kind);
+
+    // Routes the socket calls of host through this transport until Detach. Detach before destroying the host.
+    void Attach(ENetHost* host);
+    void Detach();
+
+    // Same contract as enet_socket_send: bytes taken, 0 if it would block, -1 on error.
+    virtual i32 Send(ENetSocket socket, const ENetAddress& address, const ENetBuffer* buffers, size_t bufferCount) = 0;
+    // Same contract as enet_socket_receive with one buffer.
+    virtual i32 Receive(ENetSocket socket, ENetAddress& outAddress, ENetBuffer& buffer) = 0;
+    // Hands everything queued by Send to the kernel.
+    virtual void Flush(ENetSocket) {}
+
+    [[nodiscard]] virtual ENetTransportKind GetKind() const = 0;
+    [[nodiscard]] inline const NetTransportStats& GetStats() const { return Stats; }
+};
+
+#endif //X_NET_TRANSPORT_H
@@ -0,0 +1,32 @@
+#include "NetZone.h"
+#include <algorithm>
+#include <cmath>
+
+NetZoneLayout::NetZoneLayout(f32 minX, f32 maxX, u32 count) : MinX(minX), Count(std::max(count, 1u))
+{
+    Width = std::max(maxX - minX, 1.f) / (f32)Count;
+}
+
+u32 NetZoneLayout::GetZone(f32 x) const
+{
+    const f32 zone = std::floor((x - MinX) / Width);
+    return zone <= 0.f ? 0 : std::min((u32)zone, Count - 1);
+}
+
+u32 NetZoneLayout::GetZone(f32 x, u32 current, f32 margin) const
+{
+    if(current > 0 && x < GetBorder(current - 1) - margin)
+    {
+        return GetZone(x);
+    }
+    if(current + 1 < Count && x > GetBorder(current) + margin)
+    {
+        return GetZone(x);
+    }
+    return std::min(current, Count - 1);
+}
+
+f32 NetZoneLayout::GetBorder(u32 zone) const
+{
+    return MinX + (f32)(zone + 1) * Width;
+}
@@ -0,0 +1,49 @@
+#ifndef X_NET_ZONE_H
+#define X_NET_ZONE_H
+
+#include "../Core/defines.h"
+
+// Sharded worlds: the navigation mesh is cut into strips along x, each simulated by its own server
+// process. Zones mirror entities near their borders to each other as ghosts and hand authority over
+// an entity to the neighbour it walks into. Clients only talk to the gateway, which keeps a connection
+// to every zone per client and forwards the replication of the zone the client is looking at.
+struct NetZoneConfig
+{
+    // A single zone is an ordinary match
+    u32 Count = 1;
+    u32 Index = 0;
+    // Zone i takes gateway connections on BasePort + i and links to its neighbours on BasePort + Count + i
+    u16 BasePort = 7800;
+    // Authoritative entities this close to a border are mirrored across it. At least the interest exit
+    // radius, so a client attached to a zone sees everything around it.
+    f32 GhostMargin = 360.f;
+    // How far past a border an entity, or a client's view, goes before it belongs to the next zone
+    f32 HandoffMargin = 8.f;
+
+    [[nodiscard]] inline bool IsSharded() const { return Count > 1; }
+    [[nodiscard]] inline u16 GetClientPort(u32 zone) const { return (u16)(BasePort + zone); }
+    [[nodiscard]] inline u16 GetLinkPort(u32 zone) const { return (u16)(BasePort + Count + zone); }
+};
+
+// Every zone hands out network ids from its own range, so an id stays unique wherever its entity moves.
+constexpr u32 NetZoneIdBits = 24;
+
+class NetZoneLayout
+{
+    f32 MinX = 0.f;
+    f32 Width = 1.f;
+    u32 Count = 1;
+
+public:
+    NetZoneLayout() = default;
+    NetZoneLayout(f32 minX, f32 maxX, u32 count);
+
+    [[nodiscard]] u32 GetZone(f32 x) const;
+    // Like GetZone, but stays with current until x is margin past its border.
+    [[nodiscard]] u32 GetZone(f32 x, u32 current, f32 margin) const;
+    // x of the border between zone and zone + 1
+    [[nodiscard]] f32 GetBorder(u32 zone) const;
+    [[nodiscard]] inline u32 GetCount() const { return Count; }
+};
+
+#endif //X_NET_ZONE_H
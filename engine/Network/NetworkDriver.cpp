@@ -5,109 +5,836 @@
 #include "NetMsgType.h"
 
 #include <../../vendor/entt/entt.hpp>
+#include <algorithm>
 #include <cstdio>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 
 #include "../Core/Game.h"
 #include "../Components/MeshComponent.h"
+#include "../Components/NetInterpolationComponent.h"
+#include "../Components/NetPredictedComponent.h"
+#include "NetComponents.h"
+#include "NetInterpolation.h"
+#include "NetAnimation.h"
 
 i32 NetworkDriver::Init()
 {
-    if (enet_initialize() != 0)
+    if (NetPacketPool::Initialize() != 0)
     {
         fprintf(stderr, "An error occurred while initializing ENet.\n");
         return EXIT_FAILURE;
     }
     std::atexit(enet_deinitialize);
 
-    if (pClient = enet_host_create(nullptr, 1, 1, 0, 0); !pClient)
+    if (pClient = enet_host_create(nullptr, 1, NetChannelCount, 0, 0); !pClient)
     {
         fprintf(stderr, "An error occurred while trying to create an ENet client host.\n");
         return EXIT_FAILURE;
     }
+    if(Transport = NetTransport::Create(TransportKind); Transport)
+    {
+        Transport->Attach(pClient);
+    }
+
+    if(!CapturePath.empty() && !Capture.Open(CapturePath, NetClock::Now()))
+    {
+        fprintf(stderr, "Could not open capture file %s.\n", CapturePath.c_str());
+    }
+
+    // Connecting happens in Loop, startup never waits for the server
+    BackoffRandom.seed((u32)(NetClock::Now() * 1e6));
+    ConnectAttempts.store(0, std::memory_order_relaxed);
+    bReconnectRequested.store(false, std::memory_order_relaxed);
+    BeginConnect(NetClock::Now());
+    return EXIT_SUCCESS;
+}
+
+void NetworkDriver::UpdateConnection(f64 now)
+{
+    const ENetConnectionState state = ConnectionState.load(std::memory_order_relaxed);
+    if(bReconnectRequested.exchange(false, std::memory_order_acq_rel) &&
+       (state == ENetConnectionState::Failed || state == ENetConnectionState::Retrying))
+    {
+        ConnectAttempts.store(0, std::memory_order_relaxed);
+        BeginConnect(now);
+        return;
+    }
 
-    enet_address_set_host(&Address, "localhost");
-    Address.port = 7777;
+    if(state == ENetConnectionState::Connecting && now >= AttemptDeadline)
+    {
+        printf("Connection attempt %u to %s:%u timed out.\n", ConnectAttempts.load(std::memory_order_relaxed),
+               ConnectConfig.Host.c_str(), ConnectConfig.Port);
+        enet_peer_reset(pPeer);
+        pPeer = nullptr;
+        ScheduleRetry(now);
+    }
+    else if(state == ENetConnectionState::Retrying && now >= NextAttemptTime)
+    {
+        BeginConnect(now);
+    }
+}
 
-    if (pPeer = enet_host_connect(pClient, &Address, 1, 0); !pPeer)
+void NetworkDriver::BeginConnect(f64 now)
+{
+    ConnectAttempts.fetch_add(1, std::memory_order_relaxed);
+    // Resolved on every attempt, the name may only become resolvable later
+    if(enet_address_set_host(&Address, ConnectConfig.Host.c_str()) != 0)
+    {
+        fprintf(stderr, "Could not resolve %s.\n", ConnectConfig.Host.c_str());
+        ScheduleRetry(now);
+        return;
+    }
+    Address.port = ConnectConfig.Port;
+
+    // The connect data names the compression model, 0 for none
+    if(pPeer = enet_host_connect(pClient, &Address, NetChannelCount, Compression.GetId()); !pPeer)
     {
         fprintf(stderr, "No available peers for initiating an ENet connection.\n");
-        return EXIT_FAILURE;
+        ScheduleRetry(now);
+        return;
     }
+    AttemptDeadline = now + ConnectConfig.AttemptTimeout;
+    ConnectionState.store(ENetConnectionState::Connecting, std::memory_order_release);
+}
 
-    if(enet_host_service(pClient, &Event, 5000) > 0 &&
-        Event.type == ENET_EVENT_TYPE_CONNECT)
+void NetworkDriver::ScheduleRetry(f64 now)
+{
+    const u32 attempts = ConnectAttempts.load(std::memory_order_relaxed);
+    if(ConnectConfig.MaxAttempts > 0 && attempts >= ConnectConfig.MaxAttempts)
     {
-        puts("Connection to localhost:7777 succeeded.");
+        printf("Giving up on %s:%u after %u attempts.\n", ConnectConfig.Host.c_str(), ConnectConfig.Port, attempts);
+        ConnectionState.store(ENetConnectionState::Failed, std::memory_order_release);
+        return;
     }
-    else
+
+    // Randomized so that clients dropped together do not all come back in the same instant
+    f64 delay = ConnectConfig.RetryDelay;
+    for(u32 i = 1; i < attempts && delay < ConnectConfig.MaxRetryDelay; i++)
+    {
+        delay *= 2.0;
+    }
+    delay = std::min(delay, ConnectConfig.MaxRetryDelay) * std::uniform_real_distribution<f64>(0.75, 1.25)(BackoffRandom);
+    NextAttemptTime = now + delay;
+    ConnectionState.store(ENetConnectionState::Retrying, std::memory_order_release);
+}
+
+void NetworkDriver::Loop()
+{
+    UpdateConnection(NetClock::Now());
+    FlushOutbound();
+
+    // Block for at most one timeout, then drain everything ENet has pending
+    // so a single iteration never leaves received events behind.
+    ENetEvent event;
+    i32 result = enet_host_service(pClient, &event, ServiceTimeoutMs);
+    while(result > 0)
+    {
+        HandleEvent(event);
+        result = enet_host_service(pClient, &event, 0);
+    }
+    if(result < 0)
+    {
+        fprintf(stderr, "An error occurred while servicing the ENet host.\n");
+    }
+
+    FlushOutbound();
+    enet_host_flush(pClient);
+
+    if(pPeer)
+    {
+        Telemetry.UpdatePeer((u32)(pPeer - pClient->peers), *pPeer);
+    }
+    Telemetry.SetQueueDepths(Inbound.Size(), Outbound.Size());
+}
+
+void NetworkDriver::HandleEvent(const ENetEvent& event)
+{
+    NetInbound inbound{};
+    inbound.PeerId = (u32)(event.peer - pClient->peers);
+    inbound.Time = NetClock::Now();
+
+    switch(event.type)
+    {
+        case ENET_EVENT_TYPE_CONNECT:
+            printf("Connection to %s:%u succeeded.\n", ConnectConfig.Host.c_str(), ConnectConfig.Port);
+            ConnectAttempts.store(0, std::memory_order_relaxed);
+            ConnectionState.store(ENetConnectionState::Connected, std::memory_order_release);
+            inbound.Kind = ENetEventKind::Connect;
+            Capture.Record(ENetCaptureKind::Connect, inbound.PeerId, 0, nullptr, 0, inbound.Time);
+            break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+        {
+            event.peer->data = nullptr;
+            pPeer = nullptr;
+            // Refused or timed out by ENet before it ever connected, the game has nothing to clean up
+            const bool bWasConnected = ConnectionState.load(std::memory_order_relaxed) == ENetConnectionState::Connected;
+            printf("%s %s:%u.\n", bWasConnected ? "Lost connection to" : "Could not connect to", ConnectConfig.Host.c_str(),
+                   ConnectConfig.Port);
+            ScheduleRetry(inbound.Time);
+            if(!bWasConnected)
+            {
+                return;
+            }
+            inbound.Kind = ENetEventKind::Disconnect;
+            Capture.Record(ENetCaptureKind::Disconnect, inbound.PeerId, 0, nullptr, 0, inbound.Time);
+            break;
+        }
+        case ENET_EVENT_TYPE_RECEIVE:
+        {
+            Telemetry.RecordReceive(inbound.PeerId, (u32)event.packet->dataLength);
+            Capture.Record(ENetCaptureKind::Receive, inbound.PeerId, event.channelID, event.packet->data,
+                           (u32)event.packet->dataLength, inbound.Time);
+            ENetPacket* packet = Decompress(event.packet);
+            if(!packet)
+            {
+                fprintf(stderr, "Dropping compressed message that does not decode with the loaded model.\n");
+                return;
+            }
+            BitReader reader(packet->data, (u32)packet->dataLength);
+            if(!ReadNetHeader(reader, inbound.Type))
+            {
+                fprintf(stderr, "Dropping message with unknown type or protocol version.\n");
+                enet_packet_destroy(packet);
+                return;
+            }
+            inbound.Kind = ENetEventKind::Receive;
+            inbound.pPacket = packet;
+            break;
+        }
+        default:
+            return;
+    }
+
+    if(!Inbound.Push(inbound))
+    {
+        fprintf(stderr, "Inbound network queue is full, dropping message.\n");
+        if(inbound.pPacket)
+        {
+            enet_packet_destroy(inbound.pPacket);
+        }
+    }
+}
+
+ENetPacket* NetworkDriver::Decompress(ENetPacket* packet)
+{
+    const u32 size = (u32)packet->dataLength;
+    const f64 start = NetClock::Now();
+    ENetPacket* raw = NetCompression::Decompress(Compression, packet);
+    if(raw != packet)
+    {
+        Telemetry.RecordDecoded(ENetMsg::Compressed, size, NetClock::Now() - start);
+    }
+    return raw;
+}
+
+void NetworkDriver::FlushOutbound()
+{
+    NetOutbound outbound;
+    while(Outbound.Pop(outbound))
+    {
+        if(Capture.IsOpen())
+        {
+            Capture.Record(ENetCaptureKind::Send, outbound.PeerId, outbound.Channel, outbound.pPacket->data,
+                           (u32)outbound.pPacket->dataLength, NetClock::Now());
+        }
+        ENetPeer* peer = outbound.PeerId < pClient->peerCount ? &pClient->peers[outbound.PeerId] : nullptr;
+        const u32 size = (u32)outbound.pPacket->dataLength;
+        if(!peer || peer->state != ENET_PEER_STATE_CONNECTED || enet_peer_send(peer, outbound.Channel, outbound.pPacket) != 0)
+        {
+            enet_packet_destroy(outbound.pPacket);
+            continue;
+        }
+        Telemetry.RecordSend(outbound.PeerId, size);
+    }
+}
+
+i32 NetworkDriver::Start()
+{
+    if(bRunning.exchange(true))
     {
-        enet_peer_reset(pPeer);
-        puts("Connection to localhost:7777 failed.");
         return EXIT_SUCCESS;
     }
 
+    Batcher.SetTelemetry(&Telemetry);
+    Rpcs.Bind<NetRpcZoneTransfer, &NetworkDriver::OnZoneTransfer>(*this);
+    NextTelemetryTime = NetClock::Now() + TelemetryInterval;
+    if(!TelemetryPath.empty() && !TelemetryWriter.Open(TelemetryPath))
+    {
+        fprintf(stderr, "Could not open telemetry file %s.\n", TelemetryPath.c_str());
+    }
+
+    if(!CompressionModelPath.empty() && !Compression.Load(CompressionModelPath))
+    {
+        fprintf(stderr, "Could not load compression model %s, connecting without compression.\n", CompressionModelPath.c_str());
+    }
+
+    bReplaying = !ReplayPath.empty();
+    bReplayDone.store(false, std::memory_order_release);
+    bReplayReported = false;
+    if(bReplaying && !Replay.Open(ReplayPath))
+    {
+        fprintf(stderr, "Could not open capture %s for replay.\n", ReplayPath.c_str());
+        bReplaying = false;
+        bRunning.store(false, std::memory_order_release);
+        return EXIT_FAILURE;
+    }
+
+    NetworkThread = std::thread([this]()
+    {
+        if(bReplaying)
+        {
+            ReplayLoop();
+            Replay.Close();
+            return;
+        }
+
+        if(Init() != EXIT_SUCCESS)
+        {
+            bRunning.store(false, std::memory_order_release);
+            return;
+        }
+
+        while(bRunning.load(std::memory_order_acquire))
+        {
+            Loop();
+        }
+
+        if(pPeer && pPeer->state == ENET_PEER_STATE_CONNECTED)
+        {
+            enet_peer_disconnect_now(pPeer, 0);
+        }
+        FlushOutbound();
+        Capture.Close();
+        if(Transport)
+        {
+            Transport->Detach();
+        }
+        enet_host_destroy(pClient);
+        pClient = nullptr;
+        pPeer = nullptr;
+        ConnectionState.store(ENetConnectionState::Disconnected, std::memory_order_release);
+    });
+
     return EXIT_SUCCESS;
 }
 
-void NetworkDriver::Loop()
+void NetworkDriver::Stop()
+{
+    bRunning.store(false, std::memory_order_release);
+    if(NetworkThread.joinable())
+    {
+        NetworkThread.join();
+    }
+
+    if(Unfinished.pPacket)
+    {
+        enet_packet_destroy(Unfinished.pPacket);
+        Unfinished = {};
+    }
+    NetInbound inbound;
+    while(Inbound.Pop(inbound))
+    {
+        if(inbound.pPacket)
+        {
+            enet_packet_destroy(inbound.pPacket);
+        }
+    }
+    // Queued after the network thread flushed for the last time
+    NetOutbound outbound;
+    while(Outbound.Pop(outbound))
+    {
+        enet_packet_destroy(outbound.pPacket);
+    }
+
+    TelemetryWriter.Close();
+}
+
+void NetworkDriver::ReplayLoop()
+{
+    const f64 start = NetClock::Now();
+    NetCaptureRecord record;
+    while(bRunning.load(std::memory_order_acquire) && Replay.Next(record))
+    {
+        // What the client sent is kept for inspection, replay only drives the receive path
+        if(record.Kind == ENetCaptureKind::Send)
+        {
+            continue;
+        }
+
+        NetInbound inbound{};
+        inbound.PeerId = record.PeerId;
+        // Times are taken from the capture in both modes so that runs are comparable
+        inbound.Time = start + record.Time;
+        if(bReplayRealTime)
+        {
+            std::this_thread::sleep_for(std::chrono::duration<f64>(inbound.Time - NetClock::Now()));
+        }
+
+        switch(record.Kind)
+        {
+            case ENetCaptureKind::Connect:
+                inbound.Kind = ENetEventKind::Connect;
+                break;
+            case ENetCaptureKind::Disconnect:
+                inbound.Kind = ENetEventKind::Disconnect;
+                break;
+            default:
+            {
+                ENetPacket* packet = enet_packet_create(record.Data.data(), record.Data.size(), 0);
+                packet = packet ? Decompress(packet) : nullptr;
+                if(!packet)
+                {
+                    continue;
+                }
+                BitReader reader(packet->data, (u32)packet->dataLength);
+                if(!ReadNetHeader(reader, inbound.Type))
+                {
+                    enet_packet_destroy(packet);
+                    continue;
+                }
+                inbound.Kind = ENetEventKind::Receive;
+                inbound.pPacket = packet;
+                break;
+            }
+        }
+
+        // Never drop while replaying, wait for the game thread instead
+        while(!Inbound.Push(inbound))
+        {
+            if(!bRunning.load(std::memory_order_acquire))
+            {
+                if(inbound.pPacket)
+                {
+                    enet_packet_destroy(inbound.pPacket);
+                }
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    bReplayDone.store(true, std::memory_order_release);
+}
+
+void NetworkDriver::ReportReplay() const
+{
+    printf("Replay of %s finished: %llu messages, %.1f KB over %u polls.\n", ReplayPath.c_str(),
+           (unsigned long long)Stats.Messages, Stats.Bytes / 1024.0, Stats.Polls);
+    printf("  decode and apply  %9.3f ms  %7.3f us per message\n", Stats.ApplySeconds * 1e3,
+           Stats.Messages ? Stats.ApplySeconds * 1e6 / (f64)Stats.Messages : 0.0);
+    printf("  interpolation     %9.3f ms  %7.3f us per poll\n", Stats.InterpolationSeconds * 1e3,
+           Stats.Polls ? Stats.InterpolationSeconds * 1e6 / Stats.Polls : 0.0);
+    printf("  prediction        %9.3f ms  %7.3f us per poll\n", Stats.PredictionSeconds * 1e3,
+           Stats.Polls ? Stats.PredictionSeconds * 1e6 / Stats.Polls : 0.0);
+}
+
+bool NetworkDriver::Send(const void* data, size_t size, u32 flags, u8 channel)
+{
+    if(bReplaying)
+    {
+        return false;
+    }
+
+    ENetPacket* packet = NetPacketPool::Create((u32)size, flags);
+    if(!packet)
+    {
+        return false;
+    }
+    memcpy(packet->data, data, size);
+    return SendPacket(packet, channel);
+}
+
+bool NetworkDriver::SendPacket(ENetPacket* packet, u8 channel)
+{
+    // Nobody is listening during a replay
+    if(bReplaying || !Outbound.Push(NetOutbound{0, channel, packet}))
+    {
+        enet_packet_destroy(packet);
+        return false;
+    }
+    return true;
+}
+
+void NetworkDriver::UpdateView(const v3& position)
 {
-    if(enet_host_service(pClient, &Event, 0) > 0)
+    if(bViewSent && glm::distance(position, LastSentView) < ViewUpdateDistance)
+    {
+        return;
+    }
+    if(QueueMessage(NetViewMessage{position}, 0, (u8)ENetChannelId::Unreliable))
     {
-        switch(Event.type)
+        LastSentView = position;
+        bViewSent = true;
+    }
+}
+
+void NetworkDriver::Flush()
+{
+    Batcher.Flush();
+    for(NetOutbound& outbound : Batcher.GetReady())
+    {
+        // Nobody is listening during a replay
+        if(bReplaying || !Outbound.Push(outbound))
+        {
+            enet_packet_destroy(outbound.pPacket);
+        }
+    }
+    Batcher.GetReady().clear();
+}
+
+void NetworkDriver::Poll()
+{
+    const f64 pollStart = NetClock::Now();
+    NetInbound inbound;
+    PollChunks = 0;
+    while(PollChunks < ChunksPerPoll)
+    {
+        // A batch cut short goes on before anything that arrived after it
+        if(Unfinished.pPacket)
+        {
+            inbound = Unfinished;
+            Unfinished = {};
+        }
+        else if(!Inbound.Pop(inbound))
         {
-            case ENET_EVENT_TYPE_RECEIVE:
+            break;
+        }
+
+        MessageTime = inbound.Time;
+        if(!HandleMessage(inbound))
+        {
+            Unfinished = inbound;
+            break;
+        }
+        if(inbound.pPacket)
+        {
+            Stats.Bytes += inbound.pPacket->dataLength;
+            enet_packet_destroy(inbound.pPacket);
+        }
+        Stats.Messages++;
+    }
+    const f64 applied = NetClock::Now();
+    Stats.ApplySeconds += applied - pollStart;
+
+    // A fast replay runs on the capture's clock, otherwise interpolation would see hours pass between snapshots
+    entt::registry& registry = Game::GetInstance().GetScene()->GetRegistry();
+    const f64 now = bReplaying && !bReplayRealTime ? MessageTime : applied;
+    const f64 deltaTime = now - LastPollTime;
+    Clock.Update(deltaTime);
+    LastPollTime = now;
+    if(Clock.IsSynced())
+    {
+        NetInterpolation::Update(registry, Clock.GetRenderTime(now));
+        NetAnimation::Update(registry, Clock.GetServerTime(now), Clock.GetRenderTime(now), (f32)deltaTime);
+    }
+    const f64 interpolated = NetClock::Now();
+    Stats.InterpolationSeconds += interpolated - applied;
+
+    Input.ViewTimeMs = Clock.IsSynced() ? (u32)std::max(0.0, Clock.GetRenderTime(now) * 1000.0) : 0;
+    if(Prediction.Update(registry, (f32)deltaTime, Input))
+    {
+        QueueMessage(Input, 0, (u8)ENetChannelId::Unreliable);
+    }
+    Stats.PredictionSeconds += NetClock::Now() - interpolated;
+    Stats.Polls++;
+
+    if(applied >= NextTelemetryTime)
+    {
+        std::swap(TelemetryPrevious, TelemetryCurrent);
+        Telemetry.Sample(applied, TelemetryCurrent);
+        TelemetryWriter.Write(TelemetryCurrent, TelemetryPrevious);
+        NextTelemetryTime = applied + TelemetryInterval;
+    }
+
+    if(bReplaying && !bReplayReported && bReplayDone.load(std::memory_order_acquire) && Inbound.Size() == 0)
+    {
+        ReportReplay();
+        bReplayReported = true;
+    }
+}
+
+bool NetworkDriver::HandleMessage(const NetInbound& message)
+{
+    switch(message.Kind)
+    {
+        case ENetEventKind::Connect:
+            printf("Peer %u connected.\n", message.PeerId);
+            return true;
+        case ENetEventKind::Disconnect:
+        {
+            printf("Peer %u disconnected.\n", message.PeerId);
+            entt::registry& registry = Game::GetInstance().GetScene()->GetRegistry();
+            auto view = registry.view<CNetwork>();
+            registry.destroy(view.begin(), view.end());
+            Entities.Clear();
+            Snapshots.Clear();
+            Clock.Reset();
+            Prediction.Reset();
+            bViewSent = false;
+            StreamRemaining = 0;
+            return true;
+        }
+        default:
+            break;
+    }
+
+    BitReader reader(message.pPacket->data, (u32)message.pPacket->dataLength);
+    ENetMsg type;
+    ReadNetHeader(reader, type);
+
+    if(type == ENetMsg::Batch)
+    {
+        // Chunks batched together still count one by one against ChunksPerPoll
+        const u32 headerSize = reader.GetBitsRead() / 8;
+        const u32 size = (u32)message.pPacket->dataLength - headerSize;
+        bool bValid = NetUnbatch::ForEachFrom(message.pPacket->data + headerSize, size, UnfinishedOffset,
+            [this, &message](ENetMsg frameType, BitReader& frame)
             {
-                ENetMsg type = *(ENetMsg *) Event.packet->data;
-                switch (type)
+                if(frameType == ENetMsg::WorldChunk && PollChunks >= ChunksPerPoll)
                 {
-                    case ENetMsg::SpawnEntity:
-                    {
-                        NetSpawnMessage message = *(NetSpawnMessage*) Event.packet->data;
-                        printf("Entity spawned Id: %d\n", message.EntityId);
-                        auto s = Game::GetInstance().GetScene();
-                        entt::entity e = s->CreateEntity();
-                        s->AddComponent(e, CNetwork{message.EntityId});
-                        s->AddComponent(e, message.Transform);
-                        s->AddComponent(e, CLineMesh{0});
-                        break;
-                    }
-                    case ENetMsg::KillEntity:
-                    {
-                        printf("Kill Entity\n");
-                        break;
-                    }
-                    case ENetMsg::UpdateEntity:
-                    {
-                        NetUpdateMessage message = *(NetUpdateMessage*) Event.packet->data;
-                        auto s = Game::GetInstance().GetScene();
-                        auto view = s->GetRegistry().view<CNetwork, CTransform3d>();
-                        for(auto e : view)
-                        {
-                            if(view.get<CNetwork>(e).Id == message.EntityId)
-                            {
-                                view.get<CTransform3d>(e) = message.Transform;
-                                break;
-                            }
-                        }
-                        break;
-                    }
-                    case ENetMsg::AddComponent:
-                    {
-                        printf("AddComponent\n");
-                        break;
-                    }
-                    default:
-                        break;
+                    return false;
                 }
-                enet_packet_destroy(Event.packet);
+                const u32 frameSize = NetBatchFrameHeaderSize + frame.GetBitsRemaining() / 8;
+                const f64 start = NetClock::Now();
+                Dispatch(frameType, frame, message.PeerId);
+                Telemetry.RecordDecoded(frameType, frameSize, NetClock::Now() - start);
+                return true;
+            });
+        if(!bValid)
+        {
+            fprintf(stderr, "Dropping the rest of a malformed batch from peer %u.\n", message.PeerId);
+        }
+        else if(UnfinishedOffset < size)
+        {
+            return false;
+        }
+        UnfinishedOffset = 0;
+        return true;
+    }
+
+    const f64 start = NetClock::Now();
+    Dispatch(type, reader, message.PeerId);
+    Telemetry.RecordDecoded(type, (u32)message.pPacket->dataLength, NetClock::Now() - start);
+    return true;
+}
+
+void NetworkDriver::Dispatch(ENetMsg type, BitReader& reader, u32 peerId)
+{
+    switch (type)
+    {
+        case ENetMsg::SpawnEntity:
+        {
+            NetSpawnMessage spawn;
+            if(!spawn.Deserialize(reader))
+            {
                 break;
             }
-            case ENET_EVENT_TYPE_DISCONNECT:
-                printf("%s disconnected.\n", (char *) Event.peer->data);
-                Event.peer->data = nullptr;
+            auto s = Game::GetInstance().GetScene();
+            if(entt::entity e = Entities.Find(spawn.EntityId); e != entt::null && s->GetRegistry().valid(e))
+            {
+                s->GetRegistry().emplace_or_replace<CTransform3d>(e, spawn.Transform);
+                Prediction.SetOwned(s->GetRegistry(), e, spawn.bOwned);
                 break;
-            default:
+            }
+            SpawnReplicated(spawn.EntityId, spawn.Transform, spawn.bOwned);
+            break;
+        }
+        case ENetMsg::KillEntity:
+        {
+            NetKillMessage kill;
+            if(!kill.Deserialize(reader))
+            {
                 break;
+            }
+            if(entt::entity e = Entities.Remove(kill.EntityId); e != entt::null)
+            {
+                Game::GetInstance().GetScene()->RemoveEntity(e);
+            }
+            break;
+        }
+        case ENetMsg::UpdateEntity:
+        {
+            NetUpdateMessage update;
+            if(!update.Deserialize(reader))
+            {
+                break;
+            }
+            entt::registry& registry = Game::GetInstance().GetScene()->GetRegistry();
+            if(entt::entity e = Entities.Find(update.EntityId); e != entt::null && registry.all_of<CTransform3d>(e))
+            {
+                CTransform3d& transform = registry.get<CTransform3d>(e);
+                transform.WorldPosition = update.Transform.WorldPosition;
+                transform.WorldRotation = update.Transform.WorldRotation;
+                if(update.bScaleChanged)
+                {
+                    transform.WorldScale = update.Transform.WorldScale;
+                }
+                // Untimed updates win over anything still buffered for interpolation or predicted
+                if(CNetInterpolation* buffer = registry.try_get<CNetInterpolation>(e))
+                {
+                    buffer->Count = 0;
+                }
+                if(CNetPredicted* unit = registry.try_get<CNetPredicted>(e))
+                {
+                    Prediction.Begin(*unit, transform.WorldPosition);
+                }
+            }
+            break;
+        }
+        case ENetMsg::AddComponent:
+        {
+            entt::registry& registry = Game::GetInstance().GetScene()->GetRegistry();
+            if(!GetNetComponents().ReadChanges(reader, registry, [this](u32 netId) { return Entities.Find(netId); }))
+            {
+                fprintf(stderr, "Dropping malformed component update from peer %u.\n", peerId);
+            }
+            break;
+        }
+        case ENetMsg::WorldChunk:
+            ApplyWorldChunk(reader, peerId);
+            break;
+        case ENetMsg::Snapshot:
+        {
+            if(Snapshots.Receive(reader))
+            {
+                Clock.OnSnapshot(Snapshots.GetLatest().ServerTimeMs / 1000.0, MessageTime);
+                ApplySnapshot(Snapshots.GetLatest(), Snapshots.GetPrevious());
+                Rpcs.Call<NetRpcSnapshotAck>(Batcher, 0, Snapshots.GetLatest().Sequence);
+            }
+            break;
+        }
+        case ENetMsg::Rpc:
+            if(!Rpcs.Dispatch(reader, peerId))
+            {
+                fprintf(stderr, "Dropping unknown or malformed RPC from peer %u.\n", peerId);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void NetworkDriver::OnZoneTransfer(u32, u32 zone)
+{
+    // The new zone counts snapshots and time from its own start, keep the entities but not the history
+    printf("Transferred to zone %u.\n", zone);
+    Snapshots.Restart();
+    Clock.Reset();
+    entt::registry& registry = Game::GetInstance().GetScene()->GetRegistry();
+    for(auto [e, buffer] : registry.view<CNetInterpolation>().each())
+    {
+        buffer.Count = 0;
+    }
+}
+
+entt::entity NetworkDriver::SpawnReplicated(u32 netId, const CTransform3d& transform, bool bOwned)
+{
+    printf("Entity spawned Id: %d\n", netId);
+    auto s = Game::GetInstance().GetScene();
+    entt::entity e = s->CreateEntity();
+    s->AddComponent(e, CNetwork{netId});
+    s->AddComponent(e, transform);
+    s->AddComponent(e, CLineMesh{0});
+    Prediction.SetOwned(s->GetRegistry(), e, bOwned);
+    Entities.Add(netId, e);
+    return e;
+}
+
+void NetworkDriver::ApplyWorldChunk(BitReader& reader, u32 peerId)
+{
+    u32 remaining, count;
+    if(!NetJoinStreamCodec::ReadHeader(reader, remaining, count))
+    {
+        return;
+    }
+    PollChunks++;
+    StreamRemaining = remaining;
+
+    const NetQuantization& quantization = GetNetQuantization();
+    entt::registry& registry = Game::GetInstance().GetScene()->GetRegistry();
+    NetEntityState previous{};
+    for(u32 i = 0; i < count; i++)
+    {
+        NetEntityState state;
+        bool bOwned;
+        if(!NetJoinStreamCodec::ReadEntity(reader, previous, state, bOwned))
+        {
+            fprintf(stderr, "Dropping malformed world chunk from peer %u.\n", peerId);
+            return;
+        }
+        previous = state;
+
+        CTransform3d transform{};
+        state.ToTransform(transform, quantization);
+        // A snapshot that overtook the chunk may have spawned it already
+        if(entt::entity e = Entities.Find(state.NetId); e != entt::null && registry.valid(e))
+        {
+            registry.emplace_or_replace<CTransform3d>(e, transform);
+            Prediction.SetOwned(registry, e, bOwned);
+            continue;
+        }
+        SpawnReplicated(state.NetId, transform, bOwned);
+    }
+
+    if(!GetNetComponents().ReadChanges(reader, registry, [this](u32 netId) { return Entities.Find(netId); }))
+    {
+        fprintf(stderr, "Dropping malformed world chunk from peer %u.\n", peerId);
+    }
+}
+
+void NetworkDriver::ApplySnapshot(const NetSnapshot& latest, const NetSnapshot& previous)
+{
+    const NetQuantization& quantization = GetNetQuantization();
+    entt::registry& registry = Game::GetInstance().GetScene()->GetRegistry();
+    const f64 time = latest.ServerTimeMs / 1000.0;
+
+    // Both lists are sorted by id, so one merge pass finds removed entities and feeds the rest to interpolation
+    size_t p = 0;
+    for(const NetEntityState& state : latest.Entities)
+    {
+        while(p < previous.Entities.size() && previous.Entities[p].NetId < state.NetId)
+        {
+            if(entt::entity e = Entities.Remove(previous.Entities[p].NetId); e != entt::null)
+            {
+                Game::GetInstance().GetScene()->RemoveEntity(e);
+            }
+            p++;
+        }
+
+        if(p < previous.Entities.size() && previous.Entities[p].NetId == state.NetId)
+        {
+            p++;
+        }
+
+        // Every entity gets a sample, including unchanged ones, so interpolation knows it stood still
+        CTransform3d transform{};
+        state.ToTransform(transform, quantization);
+
+        entt::entity e = Entities.Find(state.NetId);
+        if(e == entt::null || !registry.valid(e))
+        {
+            e = SpawnReplicated(state.NetId, transform, false);
+        }
+        if(CNetInterpolation* buffer = registry.try_get<CNetInterpolation>(e))
+        {
+            NetInterpolation::Push(*buffer, time, transform);
+        }
+        else if(CNetPredicted* unit = registry.try_get<CNetPredicted>(e))
+        {
+            // Owned units run ahead of the server, the snapshot only confirms or corrects them
+            Prediction.Reconcile(*unit, state.NetId, latest.AckedInput, transform.WorldPosition);
+            CTransform3d& current = registry.get<CTransform3d>(e);
+            current.WorldRotation = transform.WorldRotation;
+            current.WorldScale = transform.WorldScale;
+        }
+    }
+
+    for(; p < previous.Entities.size(); p++)
+    {
+        if(entt::entity e = Entities.Remove(previous.Entities[p].NetId); e != entt::null)
+        {
+            Game::GetInstance().GetScene()->RemoveEntity(e);
         }
     }
 }
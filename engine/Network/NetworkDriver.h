@@ -3,15 +3,188 @@
 
 #include "../Core/defines.h"
 #include <../../vendor/enet/include/enet/enet.h>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include "NetMessage.h"
+#include "SPSCQueue.h"
+#include "NetEntityMap.h"
+#include "NetSnapshot.h"
+#include "NetBatch.h"
+#include "NetClock.h"
+#include "NetPrediction.h"
+#include "NetMsgType.h"
+#include "NetCapture.h"
+#include "NetCompression.h"
+#include "NetPacketPool.h"
+#include "NetTelemetry.h"
+#include "NetJoinStream.h"
+#include "NetTransport.h"
+#include "NetRpc.h"
 
 class Engine;
 
+enum class ENetEventKind : u8
+{
+    Receive = 0,
+    Connect,
+    Disconnect,
+};
+
+// Driven by the network thread, never waited on. A connection that fails or drops is retried with
+// exponential backoff until the attempts run out.
+enum class ENetConnectionState : u8
+{
+    Disconnected = 0,
+    Connecting,
+    Connected,
+    // Waiting out the backoff before the next attempt
+    Retrying,
+    // Every attempt failed, see NetworkDriver::Reconnect
+    Failed,
+};
+
+inline const char* GetNetConnectionStateName(ENetConnectionState state)
+{
+    switch(state)
+    {
+        case ENetConnectionState::Disconnected: return "Disconnected";
+        case ENetConnectionState::Connecting: return "Connecting";
+        case ENetConnectionState::Connected: return "Connected";
+        case ENetConnectionState::Retrying: return "Retrying";
+        case ENetConnectionState::Failed: return "Failed";
+    }
+    return "Unknown";
+}
+
+struct NetConnectConfig
+{
+    std::string Host = "localhost";
+    u16 Port = 7777;
+    // An attempt that has not connected after this long is abandoned
+    f64 AttemptTimeout = 3.0;
+    // Backoff before the second attempt, doubling up to MaxRetryDelay, each randomized by +-25%
+    f64 RetryDelay = 0.5;
+    f64 MaxRetryDelay = 8.0;
+    // Attempts in a row before giving up, 0 retries forever
+    u32 MaxAttempts = 10;
+};
+
+// Handed from the network thread to the game thread. The packet is owned by
+// whoever pops it and must be destroyed after it has been applied.
+struct NetInbound
+{
+    ENetEventKind Kind = ENetEventKind::Receive;
+    ENetMsg Type = ENetMsg::None;
+    u32 PeerId = 0;
+    ENetPacket* pPacket = nullptr;
+    // Local time the network thread received it
+    f64 Time = 0.0;
+};
+
+// Where Poll spends its time, accumulated since Start. Replaying a capture as fast as
+// possible turns these into repeatable decode, apply and interpolation benchmarks.
+struct NetPollStats
+{
+    u64 Messages = 0;
+    u64 Bytes = 0;
+    u32 Polls = 0;
+    f64 ApplySeconds = 0.0;
+    f64 InterpolationSeconds = 0.0;
+    f64 PredictionSeconds = 0.0;
+};
+
 class NetworkDriver
 {
-    ENetHost* pClient;
-    ENetPeer* pPeer;
-    ENetAddress Address;
-    ENetEvent Event;
+    static constexpr u32 QueueSize = 4096;
+    static constexpr u32 ServiceTimeoutMs = 1;
+    static constexpr f32 ViewUpdateDistance = 16.f;
+    // World chunks applied per Poll. Whatever arrived after them waits for the next one, so a large world
+    // fills in over a few frames instead of stalling one.
+    static constexpr u32 ChunksPerPoll = 2;
+
+    ENetHost* pClient = nullptr;
+    ENetPeer* pPeer = nullptr;
+    ENetAddress Address = {};
+    ENetTransportKind TransportKind = ENetTransportKind::Socket;
+    std::unique_ptr<NetTransport> Transport;
+
+    NetConnectConfig ConnectConfig;
+    std::atomic<ENetConnectionState> ConnectionState = ENetConnectionState::Disconnected;
+    std::atomic<u32> ConnectAttempts = 0;
+    std::atomic<bool> bReconnectRequested = false;
+    // Network thread
+    f64 AttemptDeadline = 0.0;
+    f64 NextAttemptTime = 0.0;
+    std::minstd_rand BackoffRandom;
+
+    std::thread NetworkThread;
+    std::atomic<bool> bRunning = false;
+
+    SPSCQueue<NetInbound, QueueSize> Inbound;
+    SPSCQueue<NetOutbound, QueueSize> Outbound;
+
+    NetEntityMap Entities;
+    NetSnapshotReceiver Snapshots;
+    NetBatcher Batcher;
+    NetRpcTable Rpcs;
+    NetClock Clock;
+    NetPrediction Prediction;
+    NetInputMessage Input;
+    f64 LastPollTime = 0.0;
+    f64 MessageTime = 0.0;
+    NetPollStats Stats;
+    u32 PollChunks = 0;
+    // A batch that reached ChunksPerPoll part way through, and where its next frame starts
+    NetInbound Unfinished;
+    u32 UnfinishedOffset = 0;
+    // Entities the server still has to stream, as of the newest chunk
+    u32 StreamRemaining = 0;
+
+    NetTelemetry Telemetry;
+    NetTelemetrySample TelemetryCurrent;
+    NetTelemetrySample TelemetryPrevious;
+    NetTelemetryWriter TelemetryWriter;
+    std::string TelemetryPath;
+    f64 TelemetryInterval = 1.0;
+    f64 NextTelemetryTime = 0.0;
+
+    std::string CompressionModelPath;
+    NetCompressionModel Compression;
+
+    std::string CapturePath;
+    std::string ReplayPath;
+    NetCaptureWriter Capture;
+    NetCaptureReader Replay;
+    bool bReplaying = false;
+    bool bReplayRealTime = true;
+    bool bReplayReported = false;
+    std::atomic<bool> bReplayDone = false;
+
+    v3 LastSentView = v3(0.f);
+    bool bViewSent = false;
+
+    // Network thread. Starts the next attempt, gives up on one that timed out and waits out the backoff.
+    void UpdateConnection(f64 now);
+    void BeginConnect(f64 now);
+    void ScheduleRetry(f64 now);
+    void HandleEvent(const ENetEvent& event);
+    // Network thread. Unwraps a Compressed packet, see NetCompression::Decompress.
+    ENetPacket* Decompress(ENetPacket* packet);
+    void FlushOutbound();
+    // Hands a packet to the network thread, which sends and releases it. Takes ownership either way.
+    bool SendPacket(ENetPacket* packet, u8 channel);
+    void ReplayLoop();
+    void ReportReplay() const;
+    // Returns false if a batch stopped at ChunksPerPoll, the rest is handled by the next call with it.
+    bool HandleMessage(const NetInbound& message);
+    void Dispatch(ENetMsg type, BitReader& reader, u32 peerId);
+    void OnZoneTransfer(u32 peerId, u32 zone);
+
+    entt::entity SpawnReplicated(u32 netId, const CTransform3d& transform, bool bOwned);
+    void ApplyWorldChunk(BitReader& reader, u32 peerId);
+    void ApplySnapshot(const NetSnapshot& latest, const NetSnapshot& previous);
 
 public:
     v3 PlayerPosition;
@@ -26,8 +199,82 @@ public:
     }
 
     friend class Engine;
+
+    // Network thread
     i32 Init();
     void Loop();
+
+    // Game thread. Capture and replay have to be set up before Start.
+    // Records every packet sent and received to path.
+    void SetCapture(const std::string& path) { CapturePath = path; }
+    // Feeds a capture through the receive path instead of connecting, at the recorded pace or as fast as possible.
+    void SetReplay(const std::string& path, bool bRealTime) { ReplayPath = path; bReplayRealTime = bRealTime; }
+    // Offers the model to the server, which compresses what it sends if it has the same one.
+    void SetCompressionModel(const std::string& path) { CompressionModelPath = path; }
+    // Server to connect to and how hard to try.
+    void SetConnectConfig(const NetConnectConfig& config) { ConnectConfig = config; }
+    // Writes a telemetry record every interval, CSV or JSON lines depending on the extension.
+    void SetTelemetryExport(const std::string& path, f64 interval) { TelemetryPath = path; TelemetryInterval = interval; }
+    // Takes effect on the next Init.
+    void SetTransport(ENetTransportKind kind) { TransportKind = kind; }
+
+    i32 Start();
+    void Stop();
+    void Poll();
+    bool Send(const void* data, size_t size, u32 flags = ENET_PACKET_FLAG_RELIABLE, u8 channel = (u8)ENetChannelId::Reliable);
+
+    // Serializes straight into a pooled packet, bypassing the batcher.
+    template<typename T>
+    bool SendMessage(const T& message, u32 flags = ENET_PACKET_FLAG_RELIABLE, u8 channel = (u8)ENetChannelId::Reliable)
+    {
+        ENetPacket* packet = NetPacketPool::Create(NetMaxMessageSize, flags);
+        if(!packet)
+        {
+            return false;
+        }
+        const f64 start = NetClock::Now();
+        const u32 size = WriteNetMessage(message, packet->data, NetMaxMessageSize);
+        if(size == 0)
+        {
+            enet_packet_destroy(packet);
+            return false;
+        }
+        Telemetry.RecordEncoded(message.Type, size, NetClock::Now() - start);
+        enet_packet_resize(packet, size);
+        return SendPacket(packet, channel);
+    }
+
+    // Batched with everything else queued this tick, sent on the next Flush.
+    template<typename T>
+    bool QueueMessage(const T& message, u32 flags = ENET_PACKET_FLAG_RELIABLE, u8 channel = (u8)ENetChannelId::Reliable)
+    {
+        return Batcher.Add(0, channel, flags, message);
+    }
+
+    void Flush();
+
+    // Starts over with a fresh set of attempts if the driver gave up or is waiting to retry.
+    void Reconnect() { bReconnectRequested.store(true, std::memory_order_release); }
+
+    // Reports the camera position to the server once it has moved far enough to matter for relevance.
+    void UpdateView(const v3& position);
+
+    [[nodiscard]] inline const NetEntityMap& GetEntityMap() const { return Entities; }
+    [[nodiscard]] inline const NetClock& GetClock() const { return Clock; }
+    [[nodiscard]] inline NetPrediction& GetPrediction() { return Prediction; }
+    [[nodiscard]] inline const NetPollStats& GetPollStats() const { return Stats; }
+    // Calls and bytes per RPC, both directions
+    [[nodiscard]] inline const NetRpcTable& GetRpcs() const { return Rpcs; }
+    // The two newest telemetry samples, one interval apart, for rates.
+    [[nodiscard]] inline const NetTelemetrySample& GetTelemetry() const { return TelemetryCurrent; }
+    [[nodiscard]] inline const NetTelemetrySample& GetPreviousTelemetry() const { return TelemetryPrevious; }
+    [[nodiscard]] inline bool IsReplaying() const { return bReplaying; }
+    [[nodiscard]] inline u32 GetStreamRemaining() const { return StreamRemaining; }
+    [[nodiscard]] inline ENetConnectionState GetConnectionState() const { return ConnectionState.load(std::memory_order_acquire); }
+    // Attempts since the last successful connect
+    [[nodiscard]] inline u32 GetConnectAttempts() const { return ConnectAttempts.load(std::memory_order_relaxed); }
+    [[nodiscard]] inline const NetConnectConfig& GetConnectConfig() const { return ConnectConfig; }
+    [[nodiscard]] inline bool IsRunning() const { return bRunning.load(std::memory_order_acquire); }
 };
 
 
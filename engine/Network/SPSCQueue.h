@@ -0,0 +1,70 @@
+#ifndef X_SPSC_QUEUE_H
+#define X_SPSC_QUEUE_H
+
+#include "../Core/defines.h"
+#include <atomic>
+
+// Bounded single-producer/single-consumer ring buffer. Push never blocks and
+// fails when the queue is full, Pop fails when it is empty.
+template<typename T, u32 Capacity>
+class SPSCQueue
+{
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+    static constexpr u32 Mask = Capacity - 1;
+
+    alignas(64) std::atomic<u32> Head = 0;
+    u32 CachedTail = 0;
+
+    alignas(64) std::atomic<u32> Tail = 0;
+    u32 CachedHead = 0;
+
+    alignas(64) T Buffer[Capacity] = {};
+
+public:
+    SPSCQueue() = default;
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    // Producer side
+    bool Push(const T& item)
+    {
+        const u32 tail = Tail.load(std::memory_order_relaxed);
+        if(tail - CachedHead == Capacity)
+        {
+            CachedHead = Head.load(std::memory_order_acquire);
+            if(tail - CachedHead == Capacity)
+            {
+                return false;
+            }
+        }
+        Buffer[tail & Mask] = item;
+        Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool Pop(T& item)
+    {
+        const u32 head = Head.load(std::memory_order_relaxed);
+        if(head == CachedTail)
+        {
+            CachedTail = Tail.load(std::memory_order_acquire);
+            if(head == CachedTail)
+            {
+                return false;
+            }
+        }
+        item = Buffer[head & Mask];
+        Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] inline u32 Size() const
+    {
+        return Tail.load(std::memory_order_acquire) - Head.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] static constexpr u32 GetCapacity() { return Capacity; }
+};
+
+#endif //X_SPSC_QUEUE_H
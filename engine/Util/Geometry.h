@@ -0,0 +1,40 @@
+#ifndef X_GEOMETRY_H
+#define X_GEOMETRY_H
+
+#include "../Core/defines.h"
+
+    struct Edge {
+        v2 vertices[2]{};
+        struct Triangle* triangle;
+    };
+
+    struct Triangle {
+
+        v2 vertices[3]{};
+        Edge edges[3]{}; // edges[i] = {vertices[i], vertices[(i + 1) % 3]}
+
+        Triangle(v2 A, v2 B, v2 C) {
+            vertices[0] = A;
+            vertices[1] = B;
+            vertices[2] = C;
+
+            edges[0].vertices[0] = A;
+            edges[0].vertices[1] = B;
+            edges[1].vertices[0] = B;
+            edges[1].vertices[1] = C;
+            edges[2].vertices[0] = C;
+            edges[2].vertices[1] = A;
+        }
+
+        bool operator==(const Triangle& other) const {
+            return vertices[0] == other.vertices[0] && vertices[1] == other.vertices[1] && vertices[2] == other.vertices[2];
+        }
+        bool operator!=(const Triangle& other) const {
+            return !(*this == other);
+        }
+    };
+
+typedef Triangle Triangle2D;
+typedef Edge Edge2D;
+
+#endif //X_GEOMETRY_H
@@ -4,6 +4,7 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include "../Util/Color.h"
+#include "../Util/Geometry.h"
 #include "../Renderer/RendererUtil.h"
 
     struct Square
@@ -27,37 +28,6 @@
         return vertices;
     }
 
-    struct Edge {
-        v2 vertices[2]{};
-        struct Triangle* triangle;
-    };
-
-    struct Triangle {
-
-        v2 vertices[3]{};
-        Edge edges[3]{}; // edges[i] = {vertices[i], vertices[(i + 1) % 3]}
-
-        Triangle(v2 A, v2 B, v2 C) {
-            vertices[0] = A;
-            vertices[1] = B;
-            vertices[2] = C;
-
-            edges[0].vertices[0] = A;
-            edges[0].vertices[1] = B;
-            edges[1].vertices[0] = B;
-            edges[1].vertices[1] = C;
-            edges[2].vertices[0] = C;
-            edges[2].vertices[1] = A;
-        }
-
-        bool operator==(const Triangle& other) const {
-            return vertices[0] == other.vertices[0] && vertices[1] == other.vertices[1] && vertices[2] == other.vertices[2];
-        }
-        bool operator!=(const Triangle& other) const {
-            return !(*this == other);
-        }
-    };
-
     struct Circle
     {
         static v2 Center() { return {0.0f, 0.0f}; }
@@ -109,8 +79,6 @@
 
 typedef Square Square2D;
 typedef Circle Circle2D;
-typedef Triangle Triangle2D;
-typedef Edge Edge2D;
 
 
 #endif //X_PRIMITIVES_H
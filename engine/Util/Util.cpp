@@ -1,5 +1,4 @@
 #include "Util.h"
-#include "../Util/Primitives.h"
 
 v3 Util::Intersect(v3 planeP, v3 planeN, v3 rayP, v3 rayD)
 {
@@ -2,7 +2,7 @@
 #define X_UTIL_H
 
 #include "../Core/defines.h"
-#include "../Util/Primitives.h"
+#include "../Util/Geometry.h"
 
 namespace Util {
 v3 Intersect(v3 planeP, v3 planeN, v3 rayP, v3 rayD);
@@ -5,7 +5,6 @@
 #include <random>
 #include "backends/imgui_impl_sdl2.h"
 #include "Network/NetworkDriver.h"
-#include <thread>
 
 namespace x
 {
@@ -24,22 +23,15 @@ Engine::~Engine() = default;
 
 i32 Engine::Run(Scene * startingScene)
 {
-    // NetworkDriver::Get().Init();
-
     if(x::Window::Get().Init() != EXIT_SUCCESS || x::Renderer::Get().Init() != EXIT_SUCCESS)
     {
         return EXIT_FAILURE;
     }
 
-    Init(startingScene);
+    // Connects in the background while the scene loads, nothing here waits for the server
+    NetworkDriver::Get().Start();
 
-    // std::thread networkThread([]()
-    // {
-    //     while(1)
-    //     {
-    //         NetworkDriver::Get().Loop();
-    //     }
-    // });
+    Init(startingScene);
 
     LastTime = std::chrono::high_resolution_clock::now();
     SDL_Event event;
@@ -73,7 +65,10 @@ i32 Engine::Run(Scene * startingScene)
 
 void Engine::Update(f32 deltaTime)
 {
+    NetworkDriver::Get().Poll();
     Game::GetInstance().Update(deltaTime);
+    NetworkDriver::Get().UpdateView(CameraSystem::Get().GetMainCameraPosition());
+    NetworkDriver::Get().Flush();
 }
 
 void Engine::Draw()
@@ -90,6 +85,7 @@ void Engine::Init(Scene* startingScene)
 
 void Engine::Clean()
 {
+    NetworkDriver::Get().Stop();
     Game::GetInstance().Clean();
     Renderer::Get().Clean();
     Window::Get().Clean();
@@ -0,0 +1,147 @@
+#include "LockstepClient.h"
+#include <Network/NetClock.h>
+#include <Network/NetMsgType.h>
+
+LockstepClient::~LockstepClient()
+{
+    if(!pHost)
+    {
+        return;
+    }
+    if(pPeer && pPeer->state == ENET_PEER_STATE_CONNECTED)
+    {
+        enet_peer_disconnect_now(pPeer, 0);
+    }
+    enet_host_destroy(pHost);
+}
+
+bool LockstepClient::Connect(const ENetAddress& address, u32 seed, std::vector<Navigation::TriangleNode>* triangles)
+{
+    pTriangles = triangles;
+    if(pHost = enet_host_create(nullptr, 1, NetChannelCount, 0, 0); !pHost)
+    {
+        return false;
+    }
+    if(pPeer = enet_host_connect(pHost, &address, NetChannelCount, 0); !pPeer)
+    {
+        return false;
+    }
+    Random.seed(seed);
+    return true;
+}
+
+void LockstepClient::Update(f64 now, LockstepClientStats& stats)
+{
+    ENetEvent event;
+    while(enet_host_service(pHost, &event, 0) > 0)
+    {
+        switch(event.type)
+        {
+            case ENET_EVENT_TYPE_CONNECT:
+                bConnected = true;
+                break;
+            case ENET_EVENT_TYPE_DISCONNECT:
+                bConnected = false;
+                Session.Stop();
+                break;
+            case ENET_EVENT_TYPE_RECEIVE:
+                HandlePacket(event.packet);
+                enet_packet_destroy(event.packet);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if(Session.IsStarted() && now >= NextOrderTime)
+    {
+        const FixedVec2& home = Session.GetSim().GetSpawnCenter(Session.GetPlayerIndex());
+        std::uniform_real_distribution<f32> offset(-150.f, 150.f);
+        Session.Order(FixedVec2::FromFloat({home.x.ToFloat() + offset(Random), home.y.ToFloat() + offset(Random)}));
+        NextOrderTime = now + std::uniform_real_distribution<f64>(2.0, 5.0)(Random);
+    }
+
+    // Catch up on every turn that arrived, each one answers with the next input
+    NetLockstepInputMessage input;
+    const f64 simStart = NetClock::Now();
+    while(Session.Advance(input))
+    {
+        Batcher.Add(0, (u8)ENetChannelId::Reliable, ENET_PACKET_FLAG_RELIABLE, input);
+        stats.Turns++;
+    }
+    stats.SimSeconds += NetClock::Now() - simStart;
+
+    Batcher.Flush();
+    for(NetOutbound& outbound : Batcher.GetReady())
+    {
+        if(!bConnected || enet_peer_send(pPeer, outbound.Channel, outbound.pPacket) != 0)
+        {
+            enet_packet_destroy(outbound.pPacket);
+        }
+    }
+    Batcher.GetReady().clear();
+    enet_host_flush(pHost);
+
+    stats.BytesSent += pHost->totalSentData;
+    stats.BytesReceived += pHost->totalReceivedData;
+    pHost->totalSentData = 0;
+    pHost->totalReceivedData = 0;
+}
+
+void LockstepClient::HandlePacket(const ENetPacket* packet)
+{
+    BitReader reader(packet->data, (u32)packet->dataLength);
+    ENetMsg type;
+    if(!ReadNetHeader(reader, type))
+    {
+        return;
+    }
+
+    if(type == ENetMsg::Batch)
+    {
+        const u32 headerSize = reader.GetBitsRead() / 8;
+        NetUnbatch::ForEach(packet->data + headerSize, (u32)packet->dataLength - headerSize,
+            [this](ENetMsg frameType, BitReader& frame)
+            {
+                Dispatch(frameType, frame);
+            });
+        return;
+    }
+    Dispatch(type, reader);
+}
+
+void LockstepClient::Dispatch(ENetMsg type, BitReader& reader)
+{
+    switch(type)
+    {
+        case ENetMsg::LockstepStart:
+        {
+            NetLockstepStartMessage start;
+            if(start.Deserialize(reader))
+            {
+                Session.Start(start.Seed, start.PlayerCount, start.PlayerIndex, start.UnitsPerPlayer, pTriangles);
+            }
+            break;
+        }
+        case ENetMsg::LockstepTurn:
+        {
+            NetLockstepTurnMessage turn;
+            if(turn.Deserialize(reader))
+            {
+                Session.ReceiveTurn(turn.Turn, turn.Commands, turn.Count);
+            }
+            break;
+        }
+        case ENetMsg::LockstepDesync:
+        {
+            NetLockstepDesyncMessage desync;
+            if(desync.Deserialize(reader))
+            {
+                Session.ReceiveDesync(desync.Turn);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef X_LOCKSTEP_CLIENT_H
+#define X_LOCKSTEP_CLIENT_H
+
+#include <Core/defines.h>
+#include <Network/NetBatch.h>
+#include <Network/NetLockstep.h>
+#include <random>
+#include <vector>
+
+struct LockstepClientStats
+{
+    u64 BytesSent = 0;
+    u64 BytesReceived = 0;
+    u64 Turns = 0;
+    f64 SimSeconds = 0.0;
+};
+
+// A headless lockstep player: runs the full simulation on the turns the server relays, reports its
+// hashes and orders its units somewhere new every few seconds.
+class LockstepClient
+{
+    ENetHost* pHost = nullptr;
+    ENetPeer* pPeer = nullptr;
+    bool bConnected = false;
+    std::vector<Navigation::TriangleNode>* pTriangles = nullptr;
+
+    NetLockstepSession Session;
+    NetBatcher Batcher;
+    f64 NextOrderTime = 0.0;
+    std::mt19937 Random;
+
+    void HandlePacket(const ENetPacket* packet);
+    void Dispatch(ENetMsg type, BitReader& reader);
+
+public:
+    LockstepClient() = default;
+    LockstepClient(const LockstepClient&) = delete;
+    LockstepClient& operator=(const LockstepClient&) = delete;
+    ~LockstepClient();
+
+    // Clients in one thread may share the navigation mesh
+    bool Connect(const ENetAddress& address, u32 seed, std::vector<Navigation::TriangleNode>* triangles);
+    void Update(f64 now, LockstepClientStats& stats);
+
+    [[nodiscard]] inline bool IsConnected() const { return bConnected; }
+    [[nodiscard]] inline const NetLockstepSession& GetSession() const { return Session; }
+};
+
+#endif //X_LOCKSTEP_CLIENT_H
@@ -0,0 +1,276 @@
+#include "SimClient.h"
+#include <Network/NetMsgType.h>
+#include <algorithm>
+
+SimClient::~SimClient()
+{
+    if(!pHost)
+    {
+        return;
+    }
+    if(pPeer && pPeer->state == ENET_PEER_STATE_CONNECTED)
+    {
+        enet_peer_disconnect_now(pPeer, 0);
+    }
+    enet_host_destroy(pHost);
+}
+
+bool SimClient::Connect(const ENetAddress& address, u32 seed, const NetCompressionModel* compression)
+{
+    pCompression = compression;
+    Rpcs.Bind<NetRpcZoneTransfer, &SimClient::OnZoneTransfer>(*this);
+    if(pHost = enet_host_create(nullptr, 1, NetChannelCount, 0, 0); !pHost)
+    {
+        return false;
+    }
+    if(pPeer = enet_host_connect(pHost, &address, NetChannelCount, pCompression ? pCompression->GetId() : 0); !pPeer)
+    {
+        return false;
+    }
+    Random.seed(seed);
+    return true;
+}
+
+void SimClient::Update(f64 now, SimClientStats& stats)
+{
+    ENetEvent event;
+    while(enet_host_service(pHost, &event, 0) > 0)
+    {
+        switch(event.type)
+        {
+            case ENET_EVENT_TYPE_CONNECT:
+                bConnected = true;
+                ConnectTime = now;
+                NextInputTime = now;
+                break;
+            case ENET_EVENT_TYPE_DISCONNECT:
+                bConnected = false;
+                break;
+            case ENET_EVENT_TYPE_RECEIVE:
+            {
+                ENetPacket* packet = pCompression ? NetCompression::Decompress(*pCompression, event.packet) : event.packet;
+                if(packet)
+                {
+                    HandlePacket(packet, now, stats);
+                    enet_packet_destroy(packet);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    stats.Transfers += Transfers;
+    Transfers = 0;
+
+    Clock.Update(LastUpdateTime > 0.0 ? now - LastUpdateTime : 0.0);
+    LastUpdateTime = now;
+
+    if(bConnected && now >= NextInputTime)
+    {
+        SendInput(now);
+        // Skip ahead instead of bursting if this thread fell behind
+        NextInputTime = std::max(NextInputTime + NetInputTickDelta, now - NetInputTickDelta);
+    }
+
+    Batcher.Flush();
+    for(NetOutbound& outbound : Batcher.GetReady())
+    {
+        if(!bConnected || enet_peer_send(pPeer, outbound.Channel, outbound.pPacket) != 0)
+        {
+            enet_packet_destroy(outbound.pPacket);
+        }
+    }
+    Batcher.GetReady().clear();
+    enet_host_flush(pHost);
+
+    stats.BytesSent += pHost->totalSentData;
+    stats.BytesReceived += pHost->totalReceivedData;
+    pHost->totalSentData = 0;
+    pHost->totalReceivedData = 0;
+}
+
+void SimClient::HandlePacket(const ENetPacket* packet, f64 now, SimClientStats& stats)
+{
+    BitReader reader(packet->data, (u32)packet->dataLength);
+    ENetMsg type;
+    if(!ReadNetHeader(reader, type))
+    {
+        return;
+    }
+
+    if(type == ENetMsg::Batch)
+    {
+        const u32 headerSize = reader.GetBitsRead() / 8;
+        NetUnbatch::ForEach(packet->data + headerSize, (u32)packet->dataLength - headerSize,
+            [this, now, &stats](ENetMsg frameType, BitReader& frame)
+            {
+                Dispatch(frameType, frame, now, stats);
+            });
+        return;
+    }
+    Dispatch(type, reader, now, stats);
+}
+
+void SimClient::Dispatch(ENetMsg type, BitReader& reader, f64 now, SimClientStats& stats)
+{
+    switch(type)
+    {
+        case ENetMsg::SpawnEntity:
+        {
+            NetSpawnMessage spawn;
+            if(spawn.Deserialize(reader) && spawn.bOwned)
+            {
+                AddOwned(spawn.EntityId);
+                Home = spawn.Transform.WorldPosition;
+                bHasHome = true;
+                Batcher.Add(0, (u8)ENetChannelId::Unreliable, 0, NetViewMessage{Home});
+                // A world too small to be streamed is spawned in one go
+                if(!bJoined)
+                {
+                    stats.JoinMs.push_back((f32)((now - ConnectTime) * 1000.0));
+                    bJoined = true;
+                }
+            }
+            break;
+        }
+        case ENetMsg::WorldChunk:
+        {
+            u32 remaining, count;
+            if(!NetJoinStreamCodec::ReadHeader(reader, remaining, count))
+            {
+                break;
+            }
+            // Components are left unread, only the position of an owned unit matters here
+            NetEntityState previous{};
+            for(u32 i = 0; i < count; i++)
+            {
+                NetEntityState state;
+                bool bOwned;
+                if(!NetJoinStreamCodec::ReadEntity(reader, previous, state, bOwned))
+                {
+                    break;
+                }
+                previous = state;
+                if(bOwned)
+                {
+                    AddOwned(state.NetId);
+                }
+                if(bOwned && !bHasHome)
+                {
+                    CTransform3d transform{};
+                    state.ToTransform(transform, GetNetQuantization());
+                    Home = transform.WorldPosition;
+                    bHasHome = true;
+                    Batcher.Add(0, (u8)ENetChannelId::Unreliable, 0, NetViewMessage{Home});
+                }
+            }
+            if(remaining == 0 && !bJoined)
+            {
+                stats.JoinMs.push_back((f32)((now - ConnectTime) * 1000.0));
+                bJoined = true;
+            }
+            break;
+        }
+        case ENetMsg::Snapshot:
+        {
+            if(!Snapshots.Receive(reader))
+            {
+                break;
+            }
+            stats.Snapshots++;
+            const NetSnapshot& latest = Snapshots.GetLatest();
+            Clock.OnSnapshot(latest.ServerTimeMs / 1000.0, now);
+            Rpcs.Call<NetRpcSnapshotAck>(Batcher, 0, latest.Sequence);
+
+            for(u32 sequence = LastAcked + 1; (i32)(sequence - latest.AckedInput) <= 0; sequence++)
+            {
+                if(Sequence - sequence < HistorySize)
+                {
+                    stats.LatencyMs.push_back((f32)((now - SendTimes[sequence & (HistorySize - 1)]) * 1e3));
+                }
+            }
+            if((i32)(latest.AckedInput - LastAcked) > 0)
+            {
+                LastAcked = latest.AckedInput;
+            }
+            break;
+        }
+        case ENetMsg::Rpc:
+            Rpcs.Dispatch(reader, 0);
+            break;
+        default:
+            break;
+    }
+}
+
+void SimClient::OnZoneTransfer(u32, u32)
+{
+    // Input sequences carry over, every zone saw the same commands
+    Snapshots.Restart();
+    Clock.Reset();
+    Transfers++;
+}
+
+void SimClient::SendInput(f64 now)
+{
+    NetInputCommand& command = Commands[++Sequence & (HistorySize - 1)];
+    command.Sequence = Sequence;
+    command.bMove = bHasHome && now >= NextOrderTime;
+    if(command.bMove)
+    {
+        std::uniform_real_distribution<f32> offset(-150.f, 150.f);
+        command.Target = NetInput::QuantizeTarget({Home.x + offset(Random), Home.z + offset(Random)});
+        command.Units.clear();
+        for(u32 netId : Owned)
+        {
+            if(command.Units.size() < NetInputMaxOrderUnits && std::bernoulli_distribution(0.5)(Random))
+            {
+                command.Units.push_back(netId);
+            }
+        }
+        command.Origin = NetInput::QuantizeTarget(GetGroupOrigin(command.Units));
+        NextOrderTime = now + std::uniform_real_distribution<f64>(2.0, 5.0)(Random);
+        if(bFollowOrders)
+        {
+            Batcher.Add(0, (u8)ENetChannelId::Unreliable, 0, NetViewMessage{v3(command.Target.x, Home.y, command.Target.y)});
+        }
+    }
+    SendTimes[Sequence & (HistorySize - 1)] = now;
+
+    NetInputMessage message;
+    message.ViewTimeMs = Clock.IsSynced() ? (u32)std::max(0.0, Clock.GetRenderTime(now) * 1000.0) : 0;
+    for(u32 sequence = Sequence; (i32)(sequence - LastAcked) > 0 && message.Count < NetInputRedundancy; sequence--)
+    {
+        message.Commands[message.Count++] = Commands[sequence & (HistorySize - 1)];
+    }
+    Batcher.Add(0, (u8)ENetChannelId::Unreliable, 0, message);
+}
+
+void SimClient::AddOwned(u32 netId)
+{
+    const auto it = std::lower_bound(Owned.begin(), Owned.end(), netId);
+    if(it == Owned.end() || *it != netId)
+    {
+        Owned.insert(it, netId);
+    }
+}
+
+v2 SimClient::GetGroupOrigin(const std::vector<u32>& units) const
+{
+    const std::vector<u32>& group = units.empty() ? Owned : units;
+    v2 sum(0.f);
+    u32 count = 0;
+    for(const NetEntityState& state : Snapshots.GetLatest().Entities)
+    {
+        if(std::binary_search(group.begin(), group.end(), state.NetId))
+        {
+            CTransform3d transform{};
+            state.ToTransform(transform, GetNetQuantization());
+            sum += v2(transform.WorldPosition.x, transform.WorldPosition.z);
+            count++;
+        }
+    }
+    return count > 0 ? sum / (f32)count : v2(Home.x, Home.z);
+}
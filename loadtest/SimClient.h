@@ -0,0 +1,88 @@
+#ifndef X_SIM_CLIENT_H
+#define X_SIM_CLIENT_H
+
+#include <Core/defines.h>
+#include <Network/NetBatch.h>
+#include <Network/NetClock.h>
+#include <Network/NetCompression.h>
+#include <Network/NetInput.h>
+#include <Network/NetJoinStream.h>
+#include <Network/NetRpc.h>
+#include <Network/NetSnapshot.h>
+#include <random>
+#include <vector>
+
+// What every simulated client adds to the current measurement window.
+struct SimClientStats
+{
+    u64 Snapshots = 0;
+    u64 BytesSent = 0;
+    u64 BytesReceived = 0;
+    // Time from sending an input command until a snapshot acknowledged it
+    std::vector<f32> LatencyMs;
+    // Time from connecting until the client had every entity it can see
+    std::vector<f32> JoinMs;
+    // Times the gateway moved a client to another zone
+    u64 Transfers = 0;
+};
+
+// A headless client that behaves like a player: it acknowledges snapshots, sends an input
+// command every tick and orders a group of its units somewhere new every few seconds.
+class SimClient
+{
+    static constexpr u32 HistorySize = 64;
+
+    ENetHost* pHost = nullptr;
+    ENetPeer* pPeer = nullptr;
+    bool bConnected = false;
+    f64 ConnectTime = 0.0;
+    bool bJoined = false;
+    const NetCompressionModel* pCompression = nullptr;
+
+    NetSnapshotReceiver Snapshots;
+    // Tracks the render time a real client would interpolate at, reported with every input
+    NetClock Clock;
+    f64 LastUpdateTime = 0.0;
+    NetBatcher Batcher;
+    NetRpcTable Rpcs;
+    // Zone transfers since the last Update handed them to the stats
+    u64 Transfers = 0;
+
+    NetInputCommand Commands[HistorySize];
+    f64 SendTimes[HistorySize] = {};
+    u32 Sequence = 0;
+    u32 LastAcked = 0;
+
+    bool bHasHome = false;
+    v3 Home = v3(0.f);
+    // Network ids of the owned units, sorted. Every order picks a random group of them.
+    std::vector<u32> Owned;
+    // Look wherever the units are sent, which walks the view across zone borders
+    bool bFollowOrders = false;
+    f64 NextInputTime = 0.0;
+    f64 NextOrderTime = 0.0;
+    std::mt19937 Random;
+
+    void HandlePacket(const ENetPacket* packet, f64 now, SimClientStats& stats);
+    void Dispatch(ENetMsg type, BitReader& reader, f64 now, SimClientStats& stats);
+    void OnZoneTransfer(u32 peerId, u32 zone);
+    void SendInput(f64 now);
+    void AddOwned(u32 netId);
+    // Centre of the ordered units in the latest snapshot, where the group's path starts
+    v2 GetGroupOrigin(const std::vector<u32>& units) const;
+
+public:
+    SimClient() = default;
+    SimClient(const SimClient&) = delete;
+    SimClient& operator=(const SimClient&) = delete;
+    ~SimClient();
+
+    // With a model the client asks the server to compress what it sends
+    bool Connect(const ENetAddress& address, u32 seed, const NetCompressionModel* compression = nullptr);
+    void Update(f64 now, SimClientStats& stats);
+    void SetFollowOrders(bool bFollow) { bFollowOrders = bFollow; }
+
+    [[nodiscard]] inline bool IsConnected() const { return bConnected; }
+};
+
+#endif //X_SIM_CLIENT_H
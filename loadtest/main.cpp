@@ -0,0 +1,436 @@
+#include <Navigation/Navigation.h>
+#include <Network/NetClock.h>
+#include <Network/NetConditioner.h>
+#include <Network/NetPacketPool.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "LockstepClient.h"
+#include "LockstepMatch.h"
+#include "ServerMatch.h"
+#include "SimClient.h"
+
+// Runs a match, a network conditioner and a growing number of simulated clients in one
+// process on loopback, and reports how the server and the wire cope at every step.
+struct LoadTestConfig
+{
+    ServerConfig Server;
+    NetConditionerConfig Conditioner;
+    u32 ClientsStart = 4;
+    u32 ClientsStep = 4;
+    u32 ClientsMax = 32;
+    f64 StepSeconds = 5.0;
+    f64 WarmupSeconds = 2.0;
+    // Lockstep mode steps through unit counts instead of client counts, Server.LockstepPlayers play
+    bool bLockstep = false;
+    // Clients go through the conditioner to a gateway or server that is already running on Server.Port
+    bool bExternal = false;
+    u32 UnitsStart = 250;
+    u32 UnitsMax = 8000;
+};
+
+struct SharedStats
+{
+    std::mutex Mutex;
+    SimClientStats Clients;
+    std::vector<f32> TickMs;
+    // Changed entities held back by the snapshot budget, summed over clients and ticks
+    u64 Deferred = 0;
+    // Joins finished since the last report, kept across the warmup that most of them happen in
+    std::vector<f32> JoinMs;
+    // Running totals of the server's transport
+    NetTransportStats Transport;
+    u32 Connected = 0;
+};
+
+static std::atomic<bool> bRunning = true;
+static std::atomic<u32> TargetClients = 0;
+
+static f32 Percentile(std::vector<f32>& values, f32 percentile)
+{
+    if(values.empty())
+    {
+        return 0.f;
+    }
+    const size_t index = std::min(values.size() - 1, (size_t)(percentile * 0.01f * (f32)values.size()));
+    std::nth_element(values.begin(), values.begin() + (std::ptrdiff_t)index, values.end());
+    return values[index];
+}
+
+static void RunServer(const LoadTestConfig& config, SharedStats& shared)
+{
+    ServerMatch match(config.Server);
+    if(!match.Start())
+    {
+        bRunning.store(false);
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<f64>(1.0 / NetInputTickRate));
+    auto nextTick = Clock::now();
+    while(bRunning.load())
+    {
+        const f64 start = NetClock::Now();
+        match.Service();
+        match.Tick();
+        const f32 tickMs = (f32)((NetClock::Now() - start) * 1e3);
+        u64 deferred = 0;
+        for(u32 peerId : match.GetReplicator().GetPeers())
+        {
+            deferred += match.GetReplicator().GetDeferredCount(peerId);
+        }
+        {
+            std::lock_guard<std::mutex> lock(shared.Mutex);
+            shared.TickMs.push_back(tickMs);
+            shared.Deferred += deferred;
+            shared.Transport = match.GetTransportStats();
+        }
+
+        nextTick += tickDuration;
+        if(Clock::now() - nextTick > tickDuration * 4)
+        {
+            nextTick = Clock::now();
+        }
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+static void RunConditioner(const LoadTestConfig& config)
+{
+    ENetAddress target{};
+    enet_address_set_host(&target, "127.0.0.1");
+    target.port = config.Server.Port;
+
+    NetConditioner conditioner;
+    if(!conditioner.Start((u16)(config.Server.Port + 1), target, config.Conditioner))
+    {
+        fprintf(stderr, "Could not start the network conditioner on port %u.\n", config.Server.Port + 1);
+        bRunning.store(false);
+        return;
+    }
+    while(bRunning.load())
+    {
+        conditioner.Update(NetClock::Now());
+        std::this_thread::sleep_for(std::chrono::microseconds(250));
+    }
+}
+
+static void RunClients(const LoadTestConfig& config, SharedStats& shared)
+{
+    ENetAddress address{};
+    enet_address_set_host(&address, "127.0.0.1");
+    address.port = (u16)(config.Server.Port + 1);
+
+    // Clients offer the server's model so that every connection is compressed
+    NetCompressionModel compression;
+    if(!config.Server.CompressionModelPath.empty())
+    {
+        compression.Load(config.Server.CompressionModelPath);
+    }
+
+    std::vector<std::unique_ptr<SimClient>> clients;
+    SimClientStats local;
+    while(bRunning.load())
+    {
+        // Ramp up a few connections per iteration so the handshakes do not all land in one tick
+        for(u32 added = 0; clients.size() < TargetClients.load() && added < 8; added++)
+        {
+            auto client = std::make_unique<SimClient>();
+            if(!client->Connect(address, (u32)clients.size() + 1, compression.IsValid() ? &compression : nullptr))
+            {
+                fprintf(stderr, "Could not create simulated client %zu.\n", clients.size());
+                break;
+            }
+            client->SetFollowOrders(config.bExternal);
+            clients.push_back(std::move(client));
+        }
+
+        const f64 now = NetClock::Now();
+        u32 connected = 0;
+        for(auto& client : clients)
+        {
+            client->Update(now, local);
+            connected += client->IsConnected();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(shared.Mutex);
+            shared.Clients.Snapshots += local.Snapshots;
+            shared.Clients.BytesSent += local.BytesSent;
+            shared.Clients.BytesReceived += local.BytesReceived;
+            shared.Clients.LatencyMs.insert(shared.Clients.LatencyMs.end(), local.LatencyMs.begin(), local.LatencyMs.end());
+            shared.JoinMs.insert(shared.JoinMs.end(), local.JoinMs.begin(), local.JoinMs.end());
+            shared.Clients.Transfers += local.Transfers;
+            shared.Connected = connected;
+        }
+        local = SimClientStats{};
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// One lockstep match per unit count with the same players, all in this thread. What a client sends
+// and receives should not depend on the unit count, only the simulation cost should.
+static void RunLockstep(const LoadTestConfig& config)
+{
+    std::vector<v2> points;
+    std::vector<Navigation::TriangleNode> triangles;
+    if(!Navigation::LoadNavMesh(config.Server.NavMeshPath, points, triangles))
+    {
+        fprintf(stderr, "Could not load navigation mesh %s, units will not move.\n", config.Server.NavMeshPath.c_str());
+    }
+
+    ENetAddress address{};
+    enet_address_set_host(&address, "127.0.0.1");
+    address.port = (u16)(config.Server.Port + 1);
+
+    printf("%8s %8s %11s %12s %12s %12s %9s %8s\n", "units", "players", "turns/s/cl", "down B/s/cl", "up B/s/cl",
+           "sim ms/turn", "late cmds", "desyncs");
+    for(u32 units = config.UnitsStart; units <= config.UnitsMax && bRunning.load(); units *= 2)
+    {
+        ServerConfig server = config.Server;
+        server.LockstepUnitsPerPlayer = units;
+        LockstepMatch match(server);
+        if(!match.Start())
+        {
+            break;
+        }
+
+        std::vector<std::unique_ptr<LockstepClient>> clients;
+        for(u32 i = 0; i < server.LockstepPlayers; i++)
+        {
+            clients.push_back(std::make_unique<LockstepClient>());
+            if(!clients.back()->Connect(address, i + 1, &triangles))
+            {
+                fprintf(stderr, "Could not create lockstep client %u.\n", i);
+                return;
+            }
+        }
+
+        LockstepClientStats stats;
+        u64 lateStart = 0;
+        f64 windowStart = 0.0;
+        const f64 start = NetClock::Now();
+        f64 nextTick = start;
+        while(bRunning.load())
+        {
+            const f64 now = NetClock::Now();
+            match.Service();
+            if(now >= nextTick)
+            {
+                match.Tick();
+                nextTick = std::max(nextTick + NetInputTickDelta, now - NetInputTickDelta);
+            }
+            for(auto& client : clients)
+            {
+                client->Update(now, stats);
+            }
+
+            // Measure once the match runs and the warmup is over
+            if(windowStart == 0.0 && match.IsStarted() && now - start >= config.WarmupSeconds)
+            {
+                windowStart = now;
+                lateStart = match.GetLateCommands();
+                stats = LockstepClientStats{};
+            }
+            if(windowStart > 0.0 && now - windowStart >= config.StepSeconds)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        const f64 perClient = std::max(server.LockstepPlayers, 1u) * std::max(NetClock::Now() - windowStart, 1e-3);
+        u32 desynced = 0;
+        for(auto& client : clients)
+        {
+            desynced += client->GetSession().IsDesynced();
+        }
+        printf("%8u %8u %11.2f %12.0f %12.0f %12.3f %9llu %8u\n", units * server.LockstepPlayers, server.LockstepPlayers,
+               (f64)stats.Turns / perClient, (f64)stats.BytesReceived / perClient, (f64)stats.BytesSent / perClient,
+               stats.Turns > 0 ? stats.SimSeconds / (f64)stats.Turns * 1e3 : 0.0,
+               (unsigned long long)(match.GetLateCommands() - lateStart), desynced);
+        fflush(stdout);
+    }
+}
+
+static void PrintUsage()
+{
+    puts("Usage: x_loadtest [--port 7777] [--clients-start 4] [--clients-step 4] [--clients-max 32]\n"
+         "                  [--step-seconds 5] [--latency ms] [--jitter ms] [--loss %] [--reorder %]\n"
+         "                  [--navmesh ../assets/save.txt] [--snapshot-budget 1100]\n"
+         "                  [--stream-budget 2400] [--units-per-client 1]\n"
+         "                  [--net-stats <file.csv|file.json>] [--capture <file>]\n"
+         "                  [--compression-model <file>] [--external] [--transport socket|batched]");
+}
+
+static bool ParseArgs(i32 argc, char** argv, LoadTestConfig& config)
+{
+    for(i32 i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "--lockstep"))
+        {
+            config.bLockstep = true;
+            continue;
+        }
+        if(!strcmp(argv[i], "--external"))
+        {
+            config.bExternal = true;
+            continue;
+        }
+        if(i + 1 >= argc)
+        {
+            return false;
+        }
+        const char* value = argv[i + 1];
+        if(!strcmp(argv[i], "--port")) config.Server.Port = (u16)atoi(value);
+        else if(!strcmp(argv[i], "--clients-start")) config.ClientsStart = (u32)atoi(value);
+        else if(!strcmp(argv[i], "--clients-step")) config.ClientsStep = (u32)atoi(value);
+        else if(!strcmp(argv[i], "--clients-max")) config.ClientsMax = (u32)atoi(value);
+        else if(!strcmp(argv[i], "--step-seconds")) config.StepSeconds = atof(value);
+        else if(!strcmp(argv[i], "--latency")) config.Conditioner.LatencyMs = (f32)atof(value);
+        else if(!strcmp(argv[i], "--jitter")) config.Conditioner.JitterMs = (f32)atof(value);
+        else if(!strcmp(argv[i], "--loss")) config.Conditioner.LossPercent = (f32)atof(value);
+        else if(!strcmp(argv[i], "--reorder")) config.Conditioner.ReorderPercent = (f32)atof(value);
+        else if(!strcmp(argv[i], "--navmesh")) config.Server.NavMeshPath = value;
+        else if(!strcmp(argv[i], "--snapshot-budget")) config.Server.Priority.SnapshotBytesPerTick = (u32)atoi(value);
+        else if(!strcmp(argv[i], "--stream-budget")) config.Server.Stream.BytesPerTick = (u32)atoi(value);
+        else if(!strcmp(argv[i], "--units-per-client")) config.Server.UnitsPerClient = (u32)atoi(value);
+        else if(!strcmp(argv[i], "--net-stats")) config.Server.TelemetryPath = value;
+        else if(!strcmp(argv[i], "--capture")) config.Server.CapturePath = value;
+        else if(!strcmp(argv[i], "--compression-model")) config.Server.CompressionModelPath = value;
+        else if(!strcmp(argv[i], "--players")) config.Server.LockstepPlayers = (u32)atoi(value);
+        else if(!strcmp(argv[i], "--units-start")) config.UnitsStart = (u32)atoi(value);
+        else if(!strcmp(argv[i], "--units-max")) config.UnitsMax = (u32)atoi(value);
+        else if(!strcmp(argv[i], "--transport"))
+            config.Server.Transport = !strcmp(value, "batched") ? ENetTransportKind::Batched : ENetTransportKind::Socket;
+        else return false;
+        i++;
+    }
+    return config.ClientsStart > 0 && config.ClientsMax >= config.ClientsStart && config.StepSeconds > 0.0 &&
+           config.UnitsStart > 0 && config.UnitsMax >= config.UnitsStart;
+}
+
+int main(int argc, char** argv)
+{
+    LoadTestConfig config;
+    if(!ParseArgs(argc, argv, config))
+    {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+    config.Server.MaxClients = config.ClientsMax;
+
+    if(NetPacketPool::Initialize() != 0)
+    {
+        fprintf(stderr, "An error occurred while initializing ENet.\n");
+        return EXIT_FAILURE;
+    }
+    std::atexit(enet_deinitialize);
+
+    printf("Conditioner: %.0f ms latency, %.0f ms jitter, %.1f%% loss, %.1f%% reorder\n", config.Conditioner.LatencyMs,
+           config.Conditioner.JitterMs, config.Conditioner.LossPercent, config.Conditioner.ReorderPercent);
+    if(config.bLockstep)
+    {
+        std::thread conditioner(RunConditioner, std::cref(config));
+        RunLockstep(config);
+        bRunning.store(false);
+        conditioner.join();
+        return EXIT_SUCCESS;
+    }
+    printf("%8s %9s %10s %10s %12s %12s %9s %9s %9s %10s %12s %12s %9s %9s %9s %10s %10s\n", "clients", "connected", "tick avg", "tick p99",
+           "down B/s/cl", "up B/s/cl", "lat p50", "lat p90", "lat p99", "CPU %/cl", "deferred/cl", "heap allocs", "join p50",
+           "join max", "transfers", "syscalls/s", "dgram/call");
+
+    SharedStats shared;
+    // An external server reports no tick times or deferred entities
+    std::thread server;
+    if(!config.bExternal)
+    {
+        server = std::thread(RunServer, std::cref(config), std::ref(shared));
+    }
+    std::thread conditioner(RunConditioner, std::cref(config));
+    std::thread clients(RunClients, std::cref(config), std::ref(shared));
+
+    for(u32 count = config.ClientsStart; count <= config.ClientsMax && bRunning.load(); count += std::max(config.ClientsStep, 1u))
+    {
+        TargetClients.store(count);
+        std::this_thread::sleep_for(std::chrono::duration<f64>(config.WarmupSeconds));
+
+        {
+            std::lock_guard<std::mutex> lock(shared.Mutex);
+            shared.Clients = SimClientStats{};
+            shared.TickMs.clear();
+            shared.Deferred = 0;
+        }
+        NetTransportStats transportStart, transportEnd;
+        {
+            std::lock_guard<std::mutex> lock(shared.Mutex);
+            transportStart = shared.Transport;
+        }
+        const NetPacketPoolStats poolStart = NetPacketPool::GetStats();
+        const std::clock_t cpuStart = std::clock();
+        const f64 wallStart = NetClock::Now();
+        std::this_thread::sleep_for(std::chrono::duration<f64>(config.StepSeconds));
+        const f64 wall = NetClock::Now() - wallStart;
+        const f64 cpu = (f64)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        // Packet memory the pool could not recycle during the window
+        const NetPacketPoolStats poolEnd = NetPacketPool::GetStats();
+        const u64 heapAllocations = poolEnd.BlocksCreated - poolStart.BlocksCreated + poolEnd.HeapAllocations - poolStart.HeapAllocations;
+
+        SimClientStats window;
+        std::vector<f32> tickMs;
+        u32 connected;
+        u64 deferred;
+        std::vector<f32> joinMs;
+        {
+            std::lock_guard<std::mutex> lock(shared.Mutex);
+            window = std::move(shared.Clients);
+            tickMs = std::move(shared.TickMs);
+            connected = shared.Connected;
+            deferred = shared.Deferred;
+            transportEnd = shared.Transport;
+            joinMs = std::move(shared.JoinMs);
+            shared.JoinMs.clear();
+            shared.Clients = SimClientStats{};
+            shared.TickMs.clear();
+            shared.Deferred = 0;
+        }
+
+        f64 tickSum = 0.0;
+        for(f32 ms : tickMs)
+        {
+            tickSum += ms;
+        }
+        const f64 perClient = std::max(connected, 1u) * wall;
+        // Server side only: system calls that moved datagrams and how many each moved
+        const u64 calls = transportEnd.SendCalls - transportStart.SendCalls + transportEnd.ReceiveCalls - transportStart.ReceiveCalls;
+        const u64 datagrams = transportEnd.Sent - transportStart.Sent + transportEnd.Received - transportStart.Received;
+        printf("%8u %9u %8.3fms %8.3fms %12.0f %12.0f %7.1fms %7.1fms %7.1fms %9.2f%% %12.2f %12llu %7.0fms %7.0fms %9llu %10.0f %10.2f\n", count, connected,
+               tickMs.empty() ? 0.0 : tickSum / (f64)tickMs.size(), Percentile(tickMs, 99.f),
+               (f64)window.BytesReceived / perClient, (f64)window.BytesSent / perClient,
+               Percentile(window.LatencyMs, 50.f), Percentile(window.LatencyMs, 90.f), Percentile(window.LatencyMs, 99.f),
+               cpu / perClient * 100.0, tickMs.empty() ? 0.0 : (f64)deferred / (f64)tickMs.size() / std::max(connected, 1u),
+               (unsigned long long)heapAllocations, Percentile(joinMs, 50.f), Percentile(joinMs, 100.f),
+               (unsigned long long)window.Transfers, (f64)calls / wall, calls > 0 ? (f64)datagrams / (f64)calls : 0.0);
+        fflush(stdout);
+    }
+
+    bRunning.store(false);
+    clients.join();
+    conditioner.join();
+    if(server.joinable())
+    {
+        server.join();
+    }
+    return EXIT_SUCCESS;
+}
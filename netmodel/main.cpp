@@ -0,0 +1,196 @@
+#include <Network/NetCapture.h>
+#include <Network/NetClock.h>
+#include <Network/NetCompression.h>
+#include <Network/NetMessage.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Trains compression models from captures and measures what they save and cost.
+static void PrintUsage()
+{
+    puts("Usage: x_netmodel train <model> <capture>... [--received]\n"
+         "       x_netmodel bench <model> <capture>... [--received] [--passes 20]\n"
+         "Uses the packets a capture sent, which for server captures is the traffic clients receive.\n"
+         "--received uses the received packets instead, for client captures. Bench on a capture the\n"
+         "model was not trained on to see what it does for new traffic.");
+}
+
+// Uncompressed packets of the chosen direction from every capture
+static bool LoadPackets(const std::vector<std::string>& paths, bool bReceived, std::vector<std::vector<u8>>& outPackets)
+{
+    const ENetCaptureKind kind = bReceived ? ENetCaptureKind::Receive : ENetCaptureKind::Send;
+    u64 skipped = 0;
+    for(const std::string& path : paths)
+    {
+        NetCaptureReader reader;
+        if(!reader.Open(path))
+        {
+            fprintf(stderr, "Could not open capture %s.\n", path.c_str());
+            return false;
+        }
+
+        NetCaptureRecord record;
+        while(reader.Next(record))
+        {
+            if(record.Kind != kind || record.Data.size() < 2)
+            {
+                continue;
+            }
+            if((ENetMsg)record.Data[1] == ENetMsg::Compressed)
+            {
+                skipped++;
+                continue;
+            }
+            outPackets.push_back(std::move(record.Data));
+        }
+    }
+    if(skipped > 0)
+    {
+        printf("Skipped %llu packets that were already compressed.\n", (unsigned long long)skipped);
+    }
+    return true;
+}
+
+static i32 Train(const std::string& modelPath, const std::vector<std::vector<u8>>& packets)
+{
+    NetCompressionTrainer trainer;
+    for(const std::vector<u8>& packet : packets)
+    {
+        trainer.AddPacket(packet.data(), (u32)packet.size());
+    }
+
+    NetCompressionModel model;
+    trainer.Build(model);
+    if(!model.Save(modelPath))
+    {
+        fprintf(stderr, "Could not write model %s.\n", modelPath.c_str());
+        return EXIT_FAILURE;
+    }
+    printf("Trained model %08x on %llu packets, %llu bytes.\n", model.GetId(), (unsigned long long)trainer.GetPacketCount(),
+           (unsigned long long)trainer.GetByteCount());
+    return EXIT_SUCCESS;
+}
+
+static i32 Bench(const std::string& modelPath, const std::vector<std::vector<u8>>& packets, u32 passes)
+{
+    NetCompressionModel model;
+    if(!model.Load(modelPath))
+    {
+        fprintf(stderr, "Could not load model %s.\n", modelPath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::vector<u8>> coded(packets.size());
+    std::vector<u8> decoded;
+    u64 rawBytes = 0, wireBytes = 0, keptRaw = 0, mismatches = 0;
+    for(size_t i = 0; i < packets.size(); i++)
+    {
+        const std::vector<u8>& packet = packets[i];
+        const u32 size = (u32)packet.size();
+        coded[i].resize(size + 16);
+        coded[i].resize(model.Encode(packet.data(), size, coded[i].data(), (u32)coded[i].size()));
+
+        decoded.resize(size);
+        if(!model.Decode(coded[i].data(), (u32)coded[i].size(), decoded.data(), size) || decoded != packet)
+        {
+            mismatches++;
+        }
+
+        // What NetCompression::Compress sends: the Compressed header and size varint, unless that is not smaller
+        u32 header = 2 + 1;
+        for(u32 rest = size >> 7; rest > 0; rest >>= 7)
+        {
+            header++;
+        }
+        const u32 compressed = header + (u32)coded[i].size();
+        rawBytes += size;
+        wireBytes += compressed < size ? compressed : size;
+        keptRaw += compressed >= size;
+    }
+
+    std::vector<u8> scratch(NetCompressionMaxRawSize + 16);
+    const f64 encodeStart = NetClock::Now();
+    for(u32 pass = 0; pass < passes; pass++)
+    {
+        for(const std::vector<u8>& packet : packets)
+        {
+            model.Encode(packet.data(), (u32)packet.size(), scratch.data(), (u32)scratch.size());
+        }
+    }
+    const f64 encodeSeconds = NetClock::Now() - encodeStart;
+
+    const f64 decodeStart = NetClock::Now();
+    for(u32 pass = 0; pass < passes; pass++)
+    {
+        for(size_t i = 0; i < packets.size(); i++)
+        {
+            model.Decode(coded[i].data(), (u32)coded[i].size(), scratch.data(), (u32)packets[i].size());
+        }
+    }
+    const f64 decodeSeconds = NetClock::Now() - decodeStart;
+
+    const f64 count = (f64)packets.size() * passes, bytes = (f64)rawBytes * passes;
+    printf("model %08x, %zu packets, %llu bytes\n", model.GetId(), packets.size(), (unsigned long long)rawBytes);
+    printf("on the wire   %llu bytes, %.1f%% saved, %llu packets left uncompressed\n", (unsigned long long)wireBytes,
+           rawBytes > 0 ? 100.0 * (1.0 - (f64)wireBytes / (f64)rawBytes) : 0.0, (unsigned long long)keptRaw);
+    printf("encode        %.2f us/packet, %.1f MB/s\n", encodeSeconds / count * 1e6, bytes / encodeSeconds / 1e6);
+    printf("decode        %.2f us/packet, %.1f MB/s\n", decodeSeconds / count * 1e6, bytes / decodeSeconds / 1e6);
+    if(wireBytes < rawBytes)
+    {
+        const f64 saved = (f64)(rawBytes - wireBytes) * passes;
+        printf("per saved byte %.1f ns encode, %.1f ns decode\n", encodeSeconds / saved * 1e9, decodeSeconds / saved * 1e9);
+    }
+    if(mismatches > 0)
+    {
+        fprintf(stderr, "%llu packets did not survive the round trip.\n", (unsigned long long)mismatches);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 4)
+    {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string command = argv[1], modelPath = argv[2];
+    std::vector<std::string> captures;
+    bool bReceived = false;
+    u32 passes = 20;
+    for(i32 i = 3; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "--received")) bReceived = true;
+        else if(!strcmp(argv[i], "--passes") && i + 1 < argc) passes = std::max(1, atoi(argv[++i]));
+        else captures.emplace_back(argv[i]);
+    }
+
+    std::vector<std::vector<u8>> packets;
+    if(captures.empty() || !LoadPackets(captures, bReceived, packets))
+    {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+    if(packets.empty())
+    {
+        fprintf(stderr, "The captures hold no packets in that direction.\n");
+        return EXIT_FAILURE;
+    }
+
+    if(command == "train")
+    {
+        return Train(modelPath, packets);
+    }
+    if(command == "bench")
+    {
+        return Bench(modelPath, packets, passes);
+    }
+    PrintUsage();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,303 @@
+#include "Gateway.h"
+#include <Network/NetBatch.h>
+#include <Network/NetMsgType.h>
+#include <Network/NetPacketPool.h>
+#include <cstdint>
+#include <cstdio>
+
+template<typename T>
+static bool SendTo(ENetPeer* peer, const T& message)
+{
+    if(!peer || peer->state != ENET_PEER_STATE_CONNECTED)
+    {
+        return false;
+    }
+    ENetPacket* packet = NetPacketPool::Create(NetMaxMessageSize, ENET_PACKET_FLAG_RELIABLE);
+    if(!packet)
+    {
+        return false;
+    }
+    const u32 size = WriteNetMessage(message, packet->data, NetMaxMessageSize);
+    if(size == 0)
+    {
+        enet_packet_destroy(packet);
+        return false;
+    }
+    enet_packet_resize(packet, size);
+    if(enet_peer_send(peer, (u8)ENetChannelId::Reliable, packet) != 0)
+    {
+        enet_packet_destroy(packet);
+        return false;
+    }
+    return true;
+}
+
+Gateway::~Gateway()
+{
+    Stop();
+}
+
+bool Gateway::Start()
+{
+    Map.Load();
+    v2 min(0.f), max(0.f);
+    if(!Map.GetBounds(min, max))
+    {
+        fprintf(stderr, "The gateway needs a navigation mesh to split the world.\n");
+        return false;
+    }
+    Layout = NetZoneLayout(min.x, max.x, Config.Zone.Count);
+
+    ENetAddress address{};
+    address.host = ENET_HOST_ANY;
+    address.port = Config.Port;
+    if(pClientHost = enet_host_create(&address, Config.MaxClients, NetChannelCount, 0, 0); !pClientHost)
+    {
+        fprintf(stderr, "An error occurred while trying to create an ENet gateway host on port %u.\n", Config.Port);
+        return false;
+    }
+    if(pZoneHost = enet_host_create(nullptr, Config.MaxClients * Config.Zone.Count, NetChannelCount, 0, 0); !pZoneHost)
+    {
+        fprintf(stderr, "An error occurred while trying to create the ENet host for the zone connections.\n");
+        enet_host_destroy(pClientHost);
+        pClientHost = nullptr;
+        return false;
+    }
+    if(Transport = NetTransport::Create(Config.Transport); Transport)
+    {
+        Transport->Attach(pClientHost);
+    }
+    Clients.assign(pClientHost->peerCount, Client{});
+    printf("Gateway listening on port %u for %u zones on ports %u to %u.\n", Config.Port, Config.Zone.Count,
+           Config.Zone.GetClientPort(0), Config.Zone.GetClientPort(Config.Zone.Count - 1));
+    return true;
+}
+
+void Gateway::Stop()
+{
+    if(!pClientHost)
+    {
+        return;
+    }
+
+    for(u32 slot = 0; slot < Clients.size(); slot++)
+    {
+        if(Clients[slot].pPeer)
+        {
+            enet_peer_disconnect_now(Clients[slot].pPeer, 0);
+        }
+        Disconnect(slot);
+    }
+    enet_host_flush(pZoneHost);
+    if(Transport)
+    {
+        Transport->Detach();
+    }
+    enet_host_destroy(pZoneHost);
+    enet_host_destroy(pClientHost);
+    pZoneHost = nullptr;
+    pClientHost = nullptr;
+    Clients.clear();
+}
+
+void Gateway::Service()
+{
+    ENetEvent event;
+    while(enet_host_service(pClientHost, &event, 0) > 0)
+    {
+        HandleClientEvent(event);
+    }
+    while(enet_host_service(pZoneHost, &event, 0) > 0)
+    {
+        HandleZoneEvent(event);
+    }
+    enet_host_flush(pZoneHost);
+    enet_host_flush(pClientHost);
+}
+
+void Gateway::HandleClientEvent(const ENetEvent& event)
+{
+    const u32 slot = (u32)(event.peer - pClientHost->peers);
+    Client& client = Clients[slot];
+    switch(event.type)
+    {
+        case ENET_EVENT_TYPE_CONNECT:
+        {
+            client.pPeer = event.peer;
+            client.View = Map.GetSpawnPoint(slot);
+            client.Attached = Layout.GetZone(client.View.x);
+            client.Zones.assign(Config.Zone.Count, nullptr);
+            for(u32 zone = 0; zone < Config.Zone.Count; zone++)
+            {
+                ENetAddress address{};
+                enet_address_set_host(&address, "127.0.0.1");
+                address.port = Config.Zone.GetClientPort(zone);
+                // The zone spawns the units of client id slot + 1 at the same spawn point we attach to
+                ENetPeer* peer = enet_host_connect(pZoneHost, &address, NetChannelCount, slot + 1);
+                if(!peer)
+                {
+                    fprintf(stderr, "No free zone connection for client %u, disconnecting it.\n", slot + 1);
+                    enet_peer_disconnect(event.peer, 0);
+                    Disconnect(slot);
+                    return;
+                }
+                peer->data = (void*)(uintptr_t)(slot * Config.Zone.Count + zone + 1);
+                client.Zones[zone] = peer;
+            }
+            printf("Client %u connected to the gateway, attaching to zone %u.\n", slot + 1, client.Attached);
+            break;
+        }
+        case ENET_EVENT_TYPE_DISCONNECT:
+            printf("Client %u disconnected from the gateway.\n", slot + 1);
+            Disconnect(slot);
+            break;
+        case ENET_EVENT_TYPE_RECEIVE:
+        {
+            // One packet, queued on every zone; ENet frees it after the last send
+            for(ENetPeer* peer : client.Zones)
+            {
+                if(peer && peer->state == ENET_PEER_STATE_CONNECTED)
+                {
+                    enet_peer_send(peer, event.channelID, event.packet);
+                }
+            }
+            TrackView(slot, event.packet);
+            if(event.packet->referenceCount == 0)
+            {
+                enet_packet_destroy(event.packet);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void Gateway::HandleZoneEvent(const ENetEvent& event)
+{
+    // Zero once the client behind the connection is gone
+    const u32 key = (u32)(uintptr_t)event.peer->data;
+    if(key == 0)
+    {
+        if(event.type == ENET_EVENT_TYPE_RECEIVE)
+        {
+            enet_packet_destroy(event.packet);
+        }
+        return;
+    }
+    const u32 slot = (key - 1) / Config.Zone.Count;
+    const u32 zone = (key - 1) % Config.Zone.Count;
+    Client& client = Clients[slot];
+    switch(event.type)
+    {
+        case ENET_EVENT_TYPE_CONNECT:
+            if(zone == client.Attached)
+            {
+                Attach(slot, zone, false);
+            }
+            break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+            fprintf(stderr, "Zone %u dropped client %u, disconnecting it.\n", zone, slot + 1);
+            event.peer->data = nullptr;
+            client.Zones[zone] = nullptr;
+            if(client.pPeer)
+            {
+                enet_peer_disconnect(client.pPeer, 0);
+            }
+            Disconnect(slot);
+            break;
+        case ENET_EVENT_TYPE_RECEIVE:
+            // Detached zones replicate nothing, anything still in flight from the previous zone is stale
+            if(zone != client.Attached || !client.pPeer || enet_peer_send(client.pPeer, event.channelID, event.packet) != 0)
+            {
+                enet_packet_destroy(event.packet);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void Gateway::TrackView(u32 slot, const ENetPacket* packet)
+{
+    BitReader reader(packet->data, (u32)packet->dataLength);
+    ENetMsg type;
+    if(!ReadNetHeader(reader, type))
+    {
+        return;
+    }
+
+    bool bHasView = false;
+    v3 view(0.f);
+    if(type == ENetMsg::Batch)
+    {
+        const u32 headerSize = reader.GetBitsRead() / 8;
+        NetUnbatch::ForEach(packet->data + headerSize, (u32)packet->dataLength - headerSize,
+            [&bHasView, &view](ENetMsg frameType, BitReader& frame)
+            {
+                NetViewMessage message;
+                if(frameType == ENetMsg::ViewUpdate && message.Deserialize(frame))
+                {
+                    bHasView = true;
+                    view = message.Position;
+                }
+            });
+    }
+    else if(type == ENetMsg::ViewUpdate)
+    {
+        NetViewMessage message;
+        if(message.Deserialize(reader))
+        {
+            bHasView = true;
+            view = message.Position;
+        }
+    }
+    if(!bHasView)
+    {
+        return;
+    }
+
+    Client& client = Clients[slot];
+    client.View = view;
+    const u32 zone = Layout.GetZone(view.x, client.Attached, Config.Zone.HandoffMargin);
+    if(zone == client.Attached)
+    {
+        return;
+    }
+    SendTo(client.Zones[client.Attached], NetZoneAttachMessage(false));
+    Attach(slot, zone, true);
+    SendTo(client.pPeer, NetRpcCall<NetRpcZoneTransfer>(zone));
+    Transfers++;
+}
+
+void Gateway::Attach(u32 slot, u32 zone, bool bTransfer)
+{
+    Client& client = Clients[slot];
+    client.Attached = zone;
+    // Not connected yet: the zone's connect event attaches it
+    SendTo(client.Zones[zone], NetZoneAttachMessage(true, bTransfer, client.View));
+}
+
+void Gateway::Disconnect(u32 slot)
+{
+    Client& client = Clients[slot];
+    for(ENetPeer* peer : client.Zones)
+    {
+        if(peer)
+        {
+            peer->data = nullptr;
+            enet_peer_disconnect(peer, 0);
+        }
+    }
+    client = Client{};
+}
+
+u32 Gateway::GetClientCount() const
+{
+    u32 count = 0;
+    for(const Client& client : Clients)
+    {
+        count += client.pPeer ? 1 : 0;
+    }
+    return count;
+}
@@ -0,0 +1,59 @@
+#ifndef X_GATEWAY_H
+#define X_GATEWAY_H
+
+#include <Core/defines.h>
+#include <Network/NetZone.h>
+#include <vector>
+#include "ServerMatch.h"
+
+// Front door of a sharded world. Clients connect here and nowhere else. For every client the gateway
+// holds a connection to each zone, with the client id in the connect data, and forwards whatever the
+// client sends to all of them, since any zone may simulate some of its units. Only the zone the client
+// looks at, its attached zone, replicates to it and only that zone's packets reach the client. When the
+// view crosses a border the gateway moves the attachment and tells the client to expect a new server.
+class Gateway
+{
+    struct Client
+    {
+        ENetPeer* pPeer = nullptr;
+        // Per zone
+        std::vector<ENetPeer*> Zones;
+        u32 Attached = 0;
+        v3 View = v3(0.f);
+    };
+
+    ServerConfig Config;
+    NetZoneLayout Layout;
+    // Only for the navigation mesh extent and the spawn points, nothing is simulated
+    ServerScene Map;
+    ENetHost* pClientHost = nullptr;
+    ENetHost* pZoneHost = nullptr;
+    // On the client side, where the traffic of every client arrives on one socket
+    std::unique_ptr<NetTransport> Transport;
+    std::vector<Client> Clients;
+    u64 Transfers = 0;
+
+    void HandleClientEvent(const ENetEvent& event);
+    void HandleZoneEvent(const ENetEvent& event);
+    // Follows the view updates in a client packet and moves the attachment when it crosses a border.
+    void TrackView(u32 slot, const ENetPacket* packet);
+    void Attach(u32 slot, u32 zone, bool bTransfer);
+    void Disconnect(u32 slot);
+
+public:
+    explicit Gateway(const ServerConfig& config) : Config(config), Map(config.NavMeshPath) {}
+    Gateway(const Gateway&) = delete;
+    Gateway& operator=(const Gateway&) = delete;
+    ~Gateway();
+
+    bool Start();
+    void Stop();
+
+    // Forwards everything pending in both directions without blocking.
+    void Service();
+
+    [[nodiscard]] u32 GetClientCount() const;
+    [[nodiscard]] inline u64 GetTransfers() const { return Transfers; }
+};
+
+#endif //X_GATEWAY_H
@@ -0,0 +1,264 @@
+#include "LockstepMatch.h"
+#include <Network/NetMsgType.h>
+#include <cstdio>
+#include <random>
+
+LockstepMatch::~LockstepMatch()
+{
+    Stop();
+}
+
+bool LockstepMatch::Start()
+{
+    if(Config.LockstepPlayers == 0 || Config.LockstepPlayers > NetLockstepMaxPlayers)
+    {
+        fprintf(stderr, "Lockstep matches take 1 to %u players.\n", NetLockstepMaxPlayers);
+        return false;
+    }
+
+    ENetAddress address{};
+    address.host = ENET_HOST_ANY;
+    address.port = Config.Port;
+    if(pHost = enet_host_create(&address, Config.LockstepPlayers, NetChannelCount, 0, 0); !pHost)
+    {
+        fprintf(stderr, "An error occurred while trying to create an ENet server host on port %u.\n", Config.Port);
+        return false;
+    }
+
+    PeerPlayers.assign(pHost->peerCount, -1);
+    Reset();
+    printf("Lockstep match listening on port %u for %u players with %u units each.\n", Config.Port, Config.LockstepPlayers,
+           Config.LockstepUnitsPerPlayer);
+    return true;
+}
+
+void LockstepMatch::Stop()
+{
+    if(!pHost)
+    {
+        return;
+    }
+
+    for(size_t i = 0; i < pHost->peerCount; i++)
+    {
+        if(pHost->peers[i].state == ENET_PEER_STATE_CONNECTED)
+        {
+            enet_peer_disconnect_now(&pHost->peers[i], 0);
+        }
+    }
+    enet_host_destroy(pHost);
+    pHost = nullptr;
+    Reset();
+}
+
+void LockstepMatch::Reset()
+{
+    Players.clear();
+    bStarted = false;
+    TickCount = 0;
+    NextTurn = 0;
+    for(TurnCommands& pending : Pending)
+    {
+        pending.Turn = ~0u;
+    }
+    for(TurnHash& hash : Hashes)
+    {
+        hash = TurnHash();
+    }
+}
+
+void LockstepMatch::Service()
+{
+    ENetEvent event;
+    i32 result;
+    while((result = enet_host_service(pHost, &event, 0)) > 0)
+    {
+        HandleEvent(event);
+    }
+    if(result < 0)
+    {
+        fprintf(stderr, "An error occurred while servicing the ENet host on port %u.\n", Config.Port);
+    }
+}
+
+void LockstepMatch::HandleEvent(const ENetEvent& event)
+{
+    const u32 peerId = (u32)(event.peer - pHost->peers);
+    switch(event.type)
+    {
+        case ENET_EVENT_TYPE_CONNECT:
+        {
+            // The world is fixed once the match started, nobody can join it halfway
+            if(bStarted)
+            {
+                enet_peer_disconnect(event.peer, 0);
+                break;
+            }
+            PeerPlayers[peerId] = (i32)Players.size();
+            Players.push_back((i32)peerId);
+            printf("Peer %u joined lockstep match on port %u as player %d.\n", peerId, Config.Port, PeerPlayers[peerId]);
+            if(Players.size() < Config.LockstepPlayers)
+            {
+                break;
+            }
+
+            Seed = std::random_device()();
+            for(u32 player = 0; player < (u32)Players.size(); player++)
+            {
+                Batcher.Add((u32)Players[player], (u8)ENetChannelId::Reliable, ENET_PACKET_FLAG_RELIABLE,
+                            NetLockstepStartMessage{Seed, (u32)Players.size(), player, Config.LockstepUnitsPerPlayer});
+            }
+            bStarted = true;
+            printf("Lockstep match on port %u started with seed %08x.\n", Config.Port, Seed);
+            break;
+        }
+        case ENET_EVENT_TYPE_DISCONNECT:
+        {
+            const i32 player = PeerPlayers[peerId];
+            PeerPlayers[peerId] = -1;
+            if(player < 0)
+            {
+                break;
+            }
+            printf("Player %d left lockstep match on port %u.\n", player, Config.Port);
+            // The player's units stay in the world and receive empty commands from now on
+            Players[player] = -1;
+            bool bAnyLeft = false;
+            for(i32 peer : Players)
+            {
+                bAnyLeft |= peer >= 0;
+            }
+            if(!bStarted || !bAnyLeft)
+            {
+                // Before the start the slots are handed out again in join order
+                if(!bStarted)
+                {
+                    Players.erase(Players.begin() + player);
+                    for(u32 i = 0; i < (u32)Players.size(); i++)
+                    {
+                        PeerPlayers[Players[i]] = (i32)i;
+                    }
+                }
+                else
+                {
+                    printf("Lockstep match on port %u ended after %u turns.\n", Config.Port, NextTurn);
+                    Reset();
+                }
+            }
+            break;
+        }
+        case ENET_EVENT_TYPE_RECEIVE:
+            HandlePacket(peerId, event.packet);
+            enet_packet_destroy(event.packet);
+            break;
+        default:
+            break;
+    }
+}
+
+void LockstepMatch::HandlePacket(u32 peerId, const ENetPacket* packet)
+{
+    const i32 player = PeerPlayers[peerId];
+    BitReader reader(packet->data, (u32)packet->dataLength);
+    ENetMsg type;
+    if(player < 0 || !bStarted || !ReadNetHeader(reader, type))
+    {
+        return;
+    }
+
+    auto dispatch = [this, player](ENetMsg frameType, BitReader& frame)
+    {
+        NetLockstepInputMessage input;
+        if(frameType == ENetMsg::LockstepInput && input.Deserialize(frame))
+        {
+            ReceiveInput((u32)player, input);
+        }
+    };
+    if(type == ENetMsg::Batch)
+    {
+        const u32 headerSize = reader.GetBitsRead() / 8;
+        if(!NetUnbatch::ForEach(packet->data + headerSize, (u32)packet->dataLength - headerSize, dispatch))
+        {
+            fprintf(stderr, "Dropping the rest of a malformed batch from peer %u.\n", peerId);
+        }
+        return;
+    }
+    dispatch(type, reader);
+}
+
+void LockstepMatch::ReceiveInput(u32 player, const NetLockstepInputMessage& input)
+{
+    if(input.Turn < NextTurn)
+    {
+        LateCommands++;
+    }
+    else if(input.Turn - NextTurn < NetLockstepWindow)
+    {
+        TurnCommands& pending = Pending[input.Turn % NetLockstepWindow];
+        if(pending.Turn != input.Turn)
+        {
+            pending.Turn = input.Turn;
+            for(NetLockstepCommand& command : pending.Commands)
+            {
+                command = NetLockstepCommand();
+            }
+        }
+        pending.Commands[player] = input.Command;
+    }
+
+    // Hashes of turns that fell out of the window can no longer be compared
+    if(input.HashTurn >= NextTurn || NextTurn - input.HashTurn > NetLockstepWindow)
+    {
+        return;
+    }
+    TurnHash& hash = Hashes[input.HashTurn % NetLockstepWindow];
+    if(hash.Turn != input.HashTurn)
+    {
+        hash = TurnHash{input.HashTurn, input.Hash, false};
+    }
+    else if(hash.Hash != input.Hash && !hash.bMismatch)
+    {
+        hash.bMismatch = true;
+        Desyncs++;
+        fprintf(stderr, "Lockstep match on port %u desynced at turn %u, player %u disagrees.\n", Config.Port, input.HashTurn, player);
+        Broadcast(NetLockstepDesyncMessage{input.HashTurn});
+    }
+}
+
+void LockstepMatch::Tick()
+{
+    if(bStarted && ++TickCount % NetLockstepTurnTicks == 0)
+    {
+        CloseTurn(NextTurn++);
+    }
+    Batcher.Flush();
+    SendReady();
+}
+
+void LockstepMatch::CloseTurn(u32 turn)
+{
+    TurnCommands& pending = Pending[turn % NetLockstepWindow];
+    NetLockstepTurnMessage message;
+    message.Turn = turn;
+    message.Count = (u32)Players.size();
+    for(u32 player = 0; player < message.Count; player++)
+    {
+        message.Commands[player] = pending.Turn == turn ? pending.Commands[player] : NetLockstepCommand();
+    }
+    pending.Turn = ~0u;
+    Broadcast(message);
+}
+
+void LockstepMatch::SendReady()
+{
+    for(NetOutbound& outbound : Batcher.GetReady())
+    {
+        ENetPeer* peer = outbound.PeerId < pHost->peerCount ? &pHost->peers[outbound.PeerId] : nullptr;
+        if(!peer || peer->state != ENET_PEER_STATE_CONNECTED || enet_peer_send(peer, outbound.Channel, outbound.pPacket) != 0)
+        {
+            enet_packet_destroy(outbound.pPacket);
+        }
+    }
+    Batcher.GetReady().clear();
+    enet_host_flush(pHost);
+}
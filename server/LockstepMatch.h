@@ -0,0 +1,89 @@
+#ifndef X_LOCKSTEP_MATCH_H
+#define X_LOCKSTEP_MATCH_H
+
+#include <Core/defines.h>
+#include <Network/NetBatch.h>
+#include <Network/NetLockstep.h>
+#include <vector>
+#include "ServerMatch.h"
+
+// A lockstep match: the server runs no world, it only paces turns. Every NetLockstepTurnTicks ticks it
+// closes the next turn with whatever commands arrived for it, empty for the rest, and sends it to every
+// player reliably. Commands that arrive after their turn closed are dropped. Players report a state
+// hash per turn and the first mismatch is announced to everyone.
+class LockstepMatch
+{
+    struct TurnCommands
+    {
+        u32 Turn = ~0u;
+        NetLockstepCommand Commands[NetLockstepMaxPlayers];
+    };
+
+    struct TurnHash
+    {
+        u32 Turn = ~0u;
+        u64 Hash = 0;
+        bool bMismatch = false;
+    };
+
+    ServerConfig Config;
+    ENetHost* pHost = nullptr;
+    NetBatcher Batcher;
+    u32 Seed = 0;
+
+    // ENet peer slot of every player in join order, -1 once it left
+    std::vector<i32> Players;
+    // Player index of every ENet peer slot, -1 for none
+    std::vector<i32> PeerPlayers;
+    bool bStarted = false;
+    u64 TickCount = 0;
+    u32 NextTurn = 0;
+    TurnCommands Pending[NetLockstepWindow];
+    TurnHash Hashes[NetLockstepWindow];
+
+    u64 LateCommands = 0;
+    u64 Desyncs = 0;
+
+    void HandleEvent(const ENetEvent& event);
+    void HandlePacket(u32 peerId, const ENetPacket* packet);
+    void ReceiveInput(u32 player, const NetLockstepInputMessage& input);
+    void CloseTurn(u32 turn);
+    void Reset();
+    void SendReady();
+
+    template<typename T>
+    void Broadcast(const T& message)
+    {
+        for(i32 peerId : Players)
+        {
+            if(peerId >= 0)
+            {
+                Batcher.Add((u32)peerId, (u8)ENetChannelId::Reliable, ENET_PACKET_FLAG_RELIABLE, message);
+            }
+        }
+    }
+
+public:
+    explicit LockstepMatch(const ServerConfig& config) : Config(config) {}
+    LockstepMatch(const LockstepMatch&) = delete;
+    LockstepMatch& operator=(const LockstepMatch&) = delete;
+    ~LockstepMatch();
+
+    bool Start();
+    void Stop();
+
+    // Drains every pending network event without blocking.
+    void Service();
+
+    // Closes a turn every NetLockstepTurnTicks calls once every player joined.
+    void Tick();
+
+    [[nodiscard]] inline u16 GetPort() const { return Config.Port; }
+    [[nodiscard]] inline bool IsStarted() const { return bStarted; }
+    // Turns closed so far
+    [[nodiscard]] inline u32 GetTurn() const { return NextTurn; }
+    [[nodiscard]] inline u64 GetLateCommands() const { return LateCommands; }
+    [[nodiscard]] inline u64 GetDesyncs() const { return Desyncs; }
+};
+
+#endif //X_LOCKSTEP_MATCH_H
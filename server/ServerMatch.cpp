@@ -0,0 +1,366 @@
+#include "ServerMatch.h"
+#include <Network/NetAnimation.h>
+#include <Network/NetInput.h>
+#include <Network/NetMsgType.h>
+#include <algorithm>
+#include <cstdio>
+
+ServerMatch::~ServerMatch()
+{
+    Stop();
+}
+
+bool ServerMatch::Start()
+{
+    Rpcs.Bind<NetRpcSnapshotAck, &ServerMatch::OnSnapshotAck>(*this);
+
+    ENetAddress address{};
+    address.host = ENET_HOST_ANY;
+    address.port = Config.Port;
+
+    if(pHost = enet_host_create(&address, Config.MaxClients, NetChannelCount, 0, 0); !pHost)
+    {
+        fprintf(stderr, "An error occurred while trying to create an ENet server host on port %u.\n", Config.Port);
+        return false;
+    }
+    if(Transport = NetTransport::Create(Config.Transport); Transport)
+    {
+        Transport->Attach(pHost);
+    }
+    else
+    {
+        fprintf(stderr, "The requested transport is not available here, using ENet's own socket calls.\n");
+    }
+
+    Batcher.SetTelemetry(&Telemetry);
+    NextTelemetryTime = Config.TelemetryInterval;
+    if(!Config.TelemetryPath.empty() && !TelemetryWriter.Open(Config.TelemetryPath))
+    {
+        fprintf(stderr, "Could not open telemetry file %s.\n", Config.TelemetryPath.c_str());
+    }
+
+    if(!Config.CompressionModelPath.empty() && !Compression.Load(Config.CompressionModelPath))
+    {
+        fprintf(stderr, "Could not load compression model %s, sending uncompressed.\n", Config.CompressionModelPath.c_str());
+    }
+    CompressedPeers.assign(pHost->peerCount, false);
+    ViewTimes.assign(pHost->peerCount, 0);
+
+    if(!Config.CapturePath.empty() && !Capture.Open(Config.CapturePath, NetClock::Now()))
+    {
+        fprintf(stderr, "Could not open capture file %s.\n", Config.CapturePath.c_str());
+    }
+
+    Replicator.Bind(World.GetRegistry());
+    World.Start();
+    if(Config.Zone.IsSharded())
+    {
+        v2 min(0.f), max(0.f);
+        if(!World.GetBounds(min, max))
+        {
+            fprintf(stderr, "Zone %u needs a navigation mesh to split the world.\n", Config.Zone.Index);
+            return false;
+        }
+        ZoneLayout = NetZoneLayout(min.x, max.x, Config.Zone.Count);
+        World.SetNetIdBase((Config.Zone.Index << NetZoneIdBits) + 1);
+        if(!Zones.Start(Config.Zone, ZoneLayout))
+        {
+            return false;
+        }
+        printf("Zone %u of %u listening on port %u.\n", Config.Zone.Index, Config.Zone.Count, Config.Port);
+        return true;
+    }
+    printf("Match listening on port %u.\n", Config.Port);
+    return true;
+}
+
+void ServerMatch::Stop()
+{
+    if(!pHost)
+    {
+        return;
+    }
+
+    for(size_t i = 0; i < pHost->peerCount; i++)
+    {
+        if(pHost->peers[i].state == ENET_PEER_STATE_CONNECTED)
+        {
+            enet_peer_disconnect_now(&pHost->peers[i], 0);
+        }
+    }
+    if(Transport)
+    {
+        Transport->Detach();
+    }
+    enet_host_destroy(pHost);
+    pHost = nullptr;
+    if(Zones.IsRunning())
+    {
+        printf("Zone %u handed off %llu entities and took over %llu.\n", Config.Zone.Index,
+               (unsigned long long)Zones.GetHandoffsSent(), (unsigned long long)Zones.GetHandoffsReceived());
+    }
+    for(u32 id = 0; id < NetRpcCount; id++)
+    {
+        const NetRpcStats& stats = Rpcs.GetStats((ENetRpc)id);
+        if(stats.Received > 0 || stats.Sent > 0)
+        {
+            printf("RPC %s: %llu received (%llu bytes), %llu sent (%llu bytes).\n", GetNetRpcName((ENetRpc)id),
+                   (unsigned long long)stats.Received, (unsigned long long)stats.ReceivedBytes,
+                   (unsigned long long)stats.Sent, (unsigned long long)stats.SentBytes);
+        }
+    }
+    Zones.Stop();
+    Connected.clear();
+    World.Clean();
+    Replicator.Unbind(World.GetRegistry());
+    History.Clear();
+    TelemetryWriter.Close();
+    Capture.Close();
+}
+
+void ServerMatch::Service()
+{
+    ENetEvent event;
+    i32 result;
+    while((result = enet_host_service(pHost, &event, 0)) > 0)
+    {
+        HandleEvent(event);
+    }
+    if(result < 0)
+    {
+        fprintf(stderr, "An error occurred while servicing the ENet host on port %u.\n", Config.Port);
+    }
+    if(Zones.IsRunning())
+    {
+        Zones.Service(World.GetRegistry(), ZoneClients, NetClock::Now());
+    }
+}
+
+void ServerMatch::HandleEvent(const ENetEvent& event)
+{
+    const u32 peerId = (u32)(event.peer - pHost->peers);
+    switch(event.type)
+    {
+        case ENET_EVENT_TYPE_CONNECT:
+        {
+            if(Config.Zone.IsSharded() && (event.data == 0 || !IsZoneLocalAddress(event.peer->address)))
+            {
+                // A zone only serves clients through the gateway, which never leaves the zone alone
+                fprintf(stderr, "Refusing peer %u, zone %u only takes gateway connections.\n", peerId, Config.Zone.Index);
+                enet_peer_disconnect_now(event.peer, 0);
+                break;
+            }
+            Connected.push_back(peerId);
+            if(Config.Zone.IsSharded())
+            {
+                // The gateway puts the client id into the connect data and attaches the client once it looks at us
+                ZoneClients.Add(peerId, event.data);
+                printf("Client %u connected to zone %u as peer %u.\n", event.data, Config.Zone.Index, peerId);
+                Capture.Record(ENetCaptureKind::Connect, peerId, 0, nullptr, 0, NetClock::Now());
+                const v3 spawn = World.GetSpawnPoint(event.data - 1);
+                if(ZoneLayout.GetZone(spawn.x) == Config.Zone.Index)
+                {
+                    World.SpawnUnits(peerId, spawn, Config.UnitsPerClient);
+                }
+                break;
+            }
+            // Clients put the id of their compression model into the connect data
+            CompressedPeers[peerId] = Compression.IsValid() && event.data == Compression.GetId();
+            printf("Peer %u connected to port %u%s.\n", peerId, Config.Port, CompressedPeers[peerId] ? ", compressed" : "");
+            Capture.Record(ENetCaptureKind::Connect, peerId, 0, nullptr, 0, NetClock::Now());
+            const v3 spawn = World.GetSpawnPoint(peerId);
+            Replicator.AddClient(peerId);
+            Replicator.SetView(peerId, spawn);
+            World.SpawnUnits(peerId, spawn, Config.UnitsPerClient);
+            break;
+        }
+        case ENET_EVENT_TYPE_DISCONNECT:
+            printf("Peer %u disconnected from port %u.\n", peerId, Config.Port);
+            CompressedPeers[peerId] = false;
+            Connected.erase(std::remove(Connected.begin(), Connected.end(), peerId), Connected.end());
+            ZoneClients.Remove(peerId);
+            Capture.Record(ENetCaptureKind::Disconnect, peerId, 0, nullptr, 0, NetClock::Now());
+            Replicator.RemoveClient(peerId);
+            World.RemoveUnits(peerId);
+            break;
+        case ENET_EVENT_TYPE_RECEIVE:
+            Telemetry.RecordReceive(peerId, (u32)event.packet->dataLength);
+            Capture.Record(ENetCaptureKind::Receive, peerId, event.channelID, event.packet->data,
+                           (u32)event.packet->dataLength, NetClock::Now());
+            HandlePacket(peerId, event.packet);
+            enet_packet_destroy(event.packet);
+            break;
+        default:
+            break;
+    }
+}
+
+void ServerMatch::HandlePacket(u32 peerId, const ENetPacket* packet)
+{
+    BitReader reader(packet->data, (u32)packet->dataLength);
+    ENetMsg type;
+    if(!ReadNetHeader(reader, type))
+    {
+        fprintf(stderr, "Dropping message with unknown type or protocol version from peer %u.\n", peerId);
+        return;
+    }
+
+    if(type == ENetMsg::Batch)
+    {
+        const u32 headerSize = reader.GetBitsRead() / 8;
+        bool bValid = NetUnbatch::ForEach(packet->data + headerSize, (u32)packet->dataLength - headerSize,
+            [this, peerId](ENetMsg frameType, BitReader& frame)
+            {
+                const u32 size = NetBatchFrameHeaderSize + frame.GetBitsRemaining() / 8;
+                const f64 start = NetClock::Now();
+                Dispatch(frameType, frame, peerId);
+                Telemetry.RecordDecoded(frameType, size, NetClock::Now() - start);
+            });
+        if(!bValid)
+        {
+            fprintf(stderr, "Dropping the rest of a malformed batch from peer %u.\n", peerId);
+        }
+        return;
+    }
+
+    const f64 start = NetClock::Now();
+    Dispatch(type, reader, peerId);
+    Telemetry.RecordDecoded(type, (u32)packet->dataLength, NetClock::Now() - start);
+}
+
+void ServerMatch::Dispatch(ENetMsg type, BitReader& reader, u32 peerId)
+{
+    switch(type)
+    {
+        case ENetMsg::Rpc:
+            if(!Rpcs.Dispatch(reader, peerId))
+            {
+                fprintf(stderr, "Dropping unknown or malformed RPC from peer %u.\n", peerId);
+            }
+            break;
+        case ENetMsg::ViewUpdate:
+        {
+            NetViewMessage view;
+            if(view.Deserialize(reader))
+            {
+                Replicator.SetView(peerId, view.Position);
+            }
+            break;
+        }
+        case ENetMsg::ZoneAttach:
+        {
+            if(!IsGatewayPeer(peerId))
+            {
+                fprintf(stderr, "Dropping ZoneAttach from peer %u, it is not a gateway connection.\n", peerId);
+                break;
+            }
+            NetZoneAttachMessage attach;
+            if(!attach.Deserialize(reader))
+            {
+                break;
+            }
+            if(attach.bAttached)
+            {
+                Replicator.AddClient(peerId, !attach.bTransfer);
+                Replicator.SetView(peerId, attach.View);
+            }
+            else
+            {
+                Replicator.DetachClient(peerId);
+            }
+            break;
+        }
+        case ENetMsg::Input:
+        {
+            NetInputMessage input;
+            if(input.Deserialize(reader))
+            {
+                ViewTimes[peerId] = input.ViewTimeMs;
+                Replicator.ReceiveInput(peerId, input);
+            }
+            break;
+        }
+        case ENetMsg::ZoneGhosts:
+        case ENetMsg::ZoneHandoff:
+            // Only zone links carry these, and those have their own host
+            fprintf(stderr, "Dropping %s from peer %u, it is not a zone link.\n", GetNetMsgName(type), peerId);
+            break;
+        default:
+            break;
+    }
+}
+
+void ServerMatch::OnSnapshotAck(u32 peerId, u32 sequence)
+{
+    Replicator.Acknowledge(peerId, sequence);
+}
+
+void ServerMatch::Tick()
+{
+    entt::registry& registry = World.GetRegistry();
+    for(u32 peerId : Connected)
+    {
+        NetInput::Consume(registry, peerId, Replicator.GetInput(peerId), World.GetNavMesh());
+    }
+    World.Update(NetInputTickDelta);
+    if(Zones.IsRunning())
+    {
+        Zones.Tick(registry, ZoneClients);
+    }
+
+    TickCount++;
+    const u32 serverTimeMs = (u32)(TickCount * 1000 / (u64)NetInputTickRate);
+    NetAnimation::Advance(registry, serverTimeMs, NetInputTickDelta);
+    // Same time and positions as the snapshot sent below, which is what clients interpolate between
+    History.Record(registry, serverTimeMs);
+    Replicator.Tick(registry, serverTimeMs, Batcher);
+    Batcher.Flush();
+    SendReady();
+    SampleTelemetry();
+}
+
+void ServerMatch::SendReady()
+{
+    for(NetOutbound& outbound : Batcher.GetReady())
+    {
+        if(Capture.IsOpen())
+        {
+            Capture.Record(ENetCaptureKind::Send, outbound.PeerId, outbound.Channel, outbound.pPacket->data,
+                           (u32)outbound.pPacket->dataLength, NetClock::Now());
+        }
+        ENetPeer* peer = outbound.PeerId < pHost->peerCount ? &pHost->peers[outbound.PeerId] : nullptr;
+        if(peer && CompressedPeers[outbound.PeerId])
+        {
+            const f64 start = NetClock::Now();
+            outbound.pPacket = NetCompression::Compress(Compression, outbound.pPacket);
+            Telemetry.RecordEncoded(ENetMsg::Compressed, (u32)outbound.pPacket->dataLength, NetClock::Now() - start);
+        }
+        const u32 size = (u32)outbound.pPacket->dataLength;
+        if(!peer || peer->state != ENET_PEER_STATE_CONNECTED || enet_peer_send(peer, outbound.Channel, outbound.pPacket) != 0)
+        {
+            enet_packet_destroy(outbound.pPacket);
+            continue;
+        }
+        Telemetry.RecordSend(outbound.PeerId, size);
+    }
+    Batcher.GetReady().clear();
+    enet_host_flush(pHost);
+}
+
+void ServerMatch::SampleTelemetry()
+{
+    for(size_t i = 0; i < pHost->peerCount; i++)
+    {
+        Telemetry.UpdatePeer((u32)i, pHost->peers[i]);
+    }
+
+    // Match time rather than wall time, so records line up with server ticks
+    const f64 time = (f64)TickCount / (f64)NetInputTickRate;
+    if(time >= NextTelemetryTime)
+    {
+        std::swap(TelemetryPrevious, TelemetryCurrent);
+        Telemetry.Sample(time, TelemetryCurrent);
+        TelemetryWriter.Write(TelemetryCurrent, TelemetryPrevious);
+        NextTelemetryTime = time + Config.TelemetryInterval;
+    }
+}
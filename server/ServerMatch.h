@@ -0,0 +1,117 @@
+#ifndef X_SERVER_MATCH_H
+#define X_SERVER_MATCH_H
+
+#include <Core/defines.h>
+#include <Network/NetBatch.h>
+#include <Network/NetCapture.h>
+#include <Network/NetCompression.h>
+#include <Network/NetLagCompensation.h>
+#include <Network/NetReplicator.h>
+#include <Network/NetRpc.h>
+#include <Network/NetTransport.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ServerScene.h"
+#include "ZoneLink.h"
+
+struct ServerConfig
+{
+    u16 Port = 7777;
+    u32 MaxClients = 32;
+    // How datagrams reach the kernel, Batched saves system calls with many clients
+    ENetTransportKind Transport = ENetTransportKind::Socket;
+    std::string NavMeshPath = "../assets/save.txt";
+    NetPriorityConfig Priority;
+    NetJoinStreamConfig Stream;
+    // Units every client gets on joining, in a square around its spawn point
+    u32 UnitsPerClient = 1;
+    // Network telemetry export, CSV or JSON lines depending on the extension. Empty disables it.
+    std::string TelemetryPath;
+    f64 TelemetryInterval = 1.0;
+    // Records all traffic of the match, the input for training compression models. Empty disables it.
+    std::string CapturePath;
+    // Compresses what is sent to clients that connect with the same model. Empty disables it.
+    std::string CompressionModelPath;
+    NetHistoryConfig History;
+    // One zone of a sharded world, which takes its clients from a gateway, see NetZone
+    NetZoneConfig Zone;
+    // Lockstep matches start once this many players joined, each with this many units
+    u32 LockstepPlayers = 2;
+    u32 LockstepUnitsPerPlayer = 500;
+};
+
+// One match: its own ENet host, world and replication state. A server process runs any
+// number of them side by side on consecutive ports.
+class ServerMatch
+{
+    ServerConfig Config;
+    ENetHost* pHost = nullptr;
+    std::unique_ptr<NetTransport> Transport;
+    ServerScene World;
+    NetReplicator Replicator;
+    NetBatcher Batcher;
+    NetRpcTable Rpcs;
+    u64 TickCount = 0;
+
+    NetTelemetry Telemetry;
+    NetTelemetrySample TelemetryCurrent;
+    NetTelemetrySample TelemetryPrevious;
+    NetTelemetryWriter TelemetryWriter;
+    f64 NextTelemetryTime = 0.0;
+
+    NetCaptureWriter Capture;
+
+    NetCompressionModel Compression;
+    // Per ENet peer slot, set when the client offered our model
+    std::vector<bool> CompressedPeers;
+
+    NetTransformHistory History;
+    // Per ENet peer slot, the view time of the client's latest input
+    std::vector<u32> ViewTimes;
+
+    // Every connected peer slot, replicated to or not
+    std::vector<u32> Connected;
+    ZoneClientMap ZoneClients;
+    NetZoneLayout ZoneLayout;
+    ZoneLink Zones;
+
+    void HandleEvent(const ENetEvent& event);
+    void HandlePacket(u32 peerId, const ENetPacket* packet);
+    void Dispatch(ENetMsg type, BitReader& reader, u32 peerId);
+    void OnSnapshotAck(u32 peerId, u32 sequence);
+    // Only a sharded zone has gateway connections, one per client, see HandleEvent
+    [[nodiscard]] inline bool IsGatewayPeer(u32 peerId) const { return Config.Zone.IsSharded() && ZoneClients.GetId(peerId) != 0; }
+    void SendReady();
+    void SampleTelemetry();
+
+public:
+    explicit ServerMatch(const ServerConfig& config)
+        : Config(config), World(config.NavMeshPath), Replicator(NetInterestConfig(), config.Priority, config.Stream),
+          History(config.History) {}
+    ServerMatch(const ServerMatch&) = delete;
+    ServerMatch& operator=(const ServerMatch&) = delete;
+    ~ServerMatch();
+
+    bool Start();
+    void Stop();
+
+    // Drains every pending network event without blocking.
+    void Service();
+
+    // Consumes client input, advances the world by one fixed tick and replicates it.
+    void Tick();
+
+    [[nodiscard]] inline u16 GetPort() const { return Config.Port; }
+    [[nodiscard]] inline u32 GetClientCount() const { return (u32)Replicator.GetPeers().size(); }
+    [[nodiscard]] inline const NetReplicator& GetReplicator() const { return Replicator; }
+    [[nodiscard]] inline const NetTelemetry& GetTelemetry() const { return Telemetry; }
+    [[nodiscard]] inline const NetRpcTable& GetRpcs() const { return Rpcs; }
+    // Authoritative checks on behalf of a client run against History at the client's view time.
+    [[nodiscard]] inline const NetTransformHistory& GetHistory() const { return History; }
+    [[nodiscard]] inline u32 GetViewTimeMs(u32 peerId) const { return History.ClampTime(peerId < ViewTimes.size() ? ViewTimes[peerId] : 0); }
+    [[nodiscard]] inline const ZoneLink& GetZoneLink() const { return Zones; }
+    [[nodiscard]] inline NetTransportStats GetTransportStats() const { return Transport ? Transport->GetStats() : NetTransportStats{}; }
+};
+
+#endif //X_SERVER_MATCH_H
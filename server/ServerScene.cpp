@@ -0,0 +1,130 @@
+#include "ServerScene.h"
+#include <Components/AnimationComponent.h>
+#include <Components/FollowComponent.h>
+#include <Components/NetworkComponent.h>
+#include <Components/TransformComponent.h>
+#include <Navigation/PathFollow.h>
+#include <Network/NetAnimation.h>
+#include <cmath>
+#include <cstdio>
+
+void ServerScene::Start()
+{
+    Load();
+}
+
+namespace
+{
+constexpr f32 IdleRate = 0.5f;
+// Ground a unit covers in one loop of the walk clip, so the feet keep up with FollowSpeed
+constexpr f32 WalkStride = 40.f;
+}
+
+void ServerScene::Update(f32 deltaTime)
+{
+    Scene::Update(deltaTime);
+
+    // Walk while following a path, stand otherwise
+    for(auto [e, follow, animation] : Registry.view<CFollow, CAnimation>().each())
+    {
+        if(follow.bFollow)
+        {
+            NetAnimation::Play(Registry, e, (u32)EUnitClip::Walk, Navigation::FollowSpeed / WalkStride);
+        }
+        else
+        {
+            NetAnimation::Play(Registry, e, (u32)EUnitClip::Idle, IdleRate);
+        }
+    }
+}
+
+void ServerScene::Clean()
+{
+    Registry.clear();
+    Entities.clear();
+}
+
+void ServerScene::Load()
+{
+    Points.clear();
+    Tris.clear();
+    if(!Navigation::LoadNavMesh(NavMeshPath, Points, Tris))
+    {
+        fprintf(stderr, "Could not load navigation mesh %s, units will not path.\n", NavMeshPath.c_str());
+    }
+}
+
+v3 ServerScene::GetSpawnPoint(u32 index) const
+{
+    std::vector<const Navigation::TriangleNode*> walkable;
+    for(const Navigation::TriangleNode& node : Tris)
+    {
+        if(!node.IsBlocked())
+        {
+            walkable.push_back(&node);
+        }
+    }
+    if(walkable.empty())
+    {
+        return {(f32)(index % 8) * 20.f, 0.f, (f32)(index / 8) * 20.f};
+    }
+
+    // Stride through the triangles so consecutive players land apart
+    const Triangle2D& triangle = walkable[(index * 7919u) % walkable.size()]->GetTriangle();
+    const v2 centroid = (triangle.vertices[0] + triangle.vertices[1] + triangle.vertices[2]) / 3.f;
+    return {centroid.x, 0.f, centroid.y};
+}
+
+bool ServerScene::GetBounds(v2& outMin, v2& outMax) const
+{
+    if(Points.empty())
+    {
+        return false;
+    }
+    outMin = outMax = Points[0];
+    for(const v2& point : Points)
+    {
+        outMin = glm::min(outMin, point);
+        outMax = glm::max(outMax, point);
+    }
+    return true;
+}
+
+entt::entity ServerScene::SpawnUnit(u32 ownerPeerId, const v3& position)
+{
+    entt::entity e = CreateEntity();
+    CTransform3d transform{};
+    transform.WorldPosition = position;
+    AddComponent(e, CNetwork{NextNetId++});
+    AddComponent(e, transform);
+    AddComponent(e, CFollow());
+    AddComponent(e, CNetOwner{ownerPeerId});
+    // Still, Update starts the idle clip before the unit is first replicated
+    AddComponent(e, CAnimation{});
+    return e;
+}
+
+void ServerScene::SpawnUnits(u32 ownerPeerId, const v3& position, u32 count)
+{
+    constexpr f32 spacing = 2.f;
+    const u32 side = (u32)std::ceil(std::sqrt((f32)count));
+    const f32 offset = (f32)(side - 1) * spacing * 0.5f;
+    for(u32 i = 0; i < count; i++)
+    {
+        SpawnUnit(ownerPeerId, position + v3((f32)(i % side) * spacing - offset, 0.f, (f32)(i / side) * spacing - offset));
+    }
+}
+
+void ServerScene::RemoveUnits(u32 ownerPeerId)
+{
+    auto view = Registry.view<CNetOwner>();
+    std::vector<entt::entity> owned;
+    for(entt::entity e : view)
+    {
+        if(view.get<CNetOwner>(e).PeerId == ownerPeerId)
+        {
+            owned.push_back(e);
+        }
+    }
+    Registry.destroy(owned.begin(), owned.end());
+}
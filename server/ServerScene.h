@@ -0,0 +1,49 @@
+#ifndef X_SERVER_SCENE_H
+#define X_SERVER_SCENE_H
+
+#include <Core/Scene.h>
+#include <Navigation/Navigation.h>
+#include <string>
+#include <vector>
+
+// Clips of the unit mesh, in the order the mesh file has them
+enum class EUnitClip : u32
+{
+    Idle = 0,
+    Walk,
+};
+
+// Authoritative world of one match. Holds the navigation mesh and the units clients control.
+class ServerScene final : public Scene
+{
+    std::string NavMeshPath;
+    std::vector<v2> Points;
+    std::vector<Navigation::TriangleNode> Tris;
+    u32 NextNetId = 1;
+
+public:
+    explicit ServerScene(std::string navMeshPath) : NavMeshPath(std::move(navMeshPath)) {}
+
+    void Start() override;
+    void Update(f32 deltaTime) override;
+    void Clean() override;
+    void HandleInput(const SDL_Event&) override {}
+    void Save() override {}
+    void Load() override;
+    void DrawUI() override {}
+
+    // A walkable point for the n-th player, spread over the navigation mesh.
+    [[nodiscard]] v3 GetSpawnPoint(u32 index) const;
+    entt::entity SpawnUnit(u32 ownerPeerId, const v3& position);
+    // count units in a square formation centered on position
+    void SpawnUnits(u32 ownerPeerId, const v3& position, u32 count);
+    void RemoveUnits(u32 ownerPeerId);
+    // Network ids are handed out from base on, see NetZoneIdBits
+    void SetNetIdBase(u32 base) { NextNetId = base; }
+    // Extent of the navigation mesh, false if none is loaded
+    bool GetBounds(v2& outMin, v2& outMax) const;
+
+    [[nodiscard]] inline std::vector<Navigation::TriangleNode>* GetNavMesh() { return Tris.empty() ? nullptr : &Tris; }
+};
+
+#endif //X_SERVER_SCENE_H
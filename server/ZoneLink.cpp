@@ -0,0 +1,525 @@
+#include "ZoneLink.h"
+#include <Components/FollowComponent.h>
+#include <Components/NetworkComponent.h>
+#include <Components/TransformComponent.h>
+#include <Network/NetMsgType.h>
+#include <Network/NetSnapshot.h>
+#include <algorithm>
+#include <cstdio>
+
+// Longest path a handoff may carry, anything longer is malformed
+static constexpr u32 MaxHandoffPathPoints = 4096;
+
+void ZoneClientMap::Add(u32 slot, u32 clientId)
+{
+    if(slot >= Ids.size())
+    {
+        Ids.resize(slot + 1, 0);
+    }
+    Ids[slot] = clientId;
+    Slots[clientId] = slot;
+}
+
+void ZoneClientMap::Remove(u32 slot)
+{
+    if(slot < Ids.size())
+    {
+        Slots.erase(Ids[slot]);
+        Ids[slot] = 0;
+    }
+}
+
+bool ZoneClientMap::GetSlot(u32 clientId, u32& outSlot) const
+{
+    auto it = Slots.find(clientId);
+    if(it == Slots.end())
+    {
+        return false;
+    }
+    outSlot = it->second;
+    return true;
+}
+
+ZoneLink::~ZoneLink()
+{
+    Stop();
+}
+
+bool ZoneLink::Start(const NetZoneConfig& config, const NetZoneLayout& layout)
+{
+    Config = config;
+    Layout = layout;
+
+    ENetAddress address{};
+    address.host = ENET_HOST_ANY;
+    address.port = Config.GetLinkPort(Config.Index);
+    if(pHost = enet_host_create(&address, 2, NetChannelCount, 0, 0); !pHost)
+    {
+        fprintf(stderr, "An error occurred while trying to create the zone link on port %u.\n", address.port);
+        return false;
+    }
+
+    Neighbours.clear();
+    if(Config.Index > 0)
+    {
+        Neighbour below;
+        below.Zone = Config.Index - 1;
+        Neighbours.push_back(below);
+    }
+    if(Config.Index + 1 < Config.Count)
+    {
+        Neighbour above;
+        above.Zone = Config.Index + 1;
+        above.bInitiator = true;
+        Neighbours.push_back(above);
+    }
+    return true;
+}
+
+void ZoneLink::Stop()
+{
+    if(!pHost)
+    {
+        return;
+    }
+    for(Neighbour& neighbour : Neighbours)
+    {
+        if(neighbour.pPeer && neighbour.bConnected)
+        {
+            enet_peer_disconnect_now(neighbour.pPeer, 0);
+        }
+    }
+    enet_host_destroy(pHost);
+    pHost = nullptr;
+    Neighbours.clear();
+    Ghosts.clear();
+}
+
+ZoneLink::Neighbour* ZoneLink::FindNeighbour(u32 zone)
+{
+    for(Neighbour& neighbour : Neighbours)
+    {
+        if(neighbour.Zone == zone)
+        {
+            return &neighbour;
+        }
+    }
+    return nullptr;
+}
+
+void ZoneLink::Connect(Neighbour& neighbour, f64 now)
+{
+    ENetAddress address{};
+    enet_address_set_host(&address, "127.0.0.1");
+    address.port = Config.GetLinkPort(neighbour.Zone);
+    // The connect data tells the other side which zone we are
+    neighbour.pPeer = enet_host_connect(pHost, &address, NetChannelCount, Config.Index);
+    neighbour.NextConnectTime = now + RetryInterval;
+}
+
+void ZoneLink::Service(entt::registry& registry, const ZoneClientMap& clients, f64 now)
+{
+    for(Neighbour& neighbour : Neighbours)
+    {
+        if(neighbour.bInitiator && !neighbour.pPeer && now >= neighbour.NextConnectTime)
+        {
+            Connect(neighbour, now);
+        }
+    }
+
+    ENetEvent event;
+    while(enet_host_service(pHost, &event, 0) > 0)
+    {
+        HandleEvent(event, registry, clients, now);
+    }
+}
+
+void ZoneLink::HandleEvent(const ENetEvent& event, entt::registry& registry, const ZoneClientMap& clients, f64 now)
+{
+    Neighbour* neighbour = nullptr;
+    for(Neighbour& candidate : Neighbours)
+    {
+        if(candidate.pPeer == event.peer)
+        {
+            neighbour = &candidate;
+        }
+    }
+
+    switch(event.type)
+    {
+        case ENET_EVENT_TYPE_CONNECT:
+            // Accepted from the zone below, which named itself in the connect data
+            if(!neighbour && IsZoneLocalAddress(event.peer->address) && (neighbour = FindNeighbour(event.data)) &&
+               !neighbour->bInitiator && !neighbour->bConnected)
+            {
+                neighbour->pPeer = event.peer;
+            }
+            if(!neighbour || neighbour->pPeer != event.peer)
+            {
+                enet_peer_disconnect_now(event.peer, 0);
+                break;
+            }
+            neighbour->bConnected = true;
+            neighbour->Ghosted.clear();
+            printf("Zone %u linked to zone %u.\n", Config.Index, neighbour->Zone);
+            break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+            if(neighbour)
+            {
+                if(neighbour->bConnected)
+                {
+                    printf("Zone %u lost its link to zone %u.\n", Config.Index, neighbour->Zone);
+                }
+                neighbour->bConnected = false;
+                neighbour->pPeer = nullptr;
+                neighbour->NextConnectTime = now + RetryInterval;
+                DropGhosts(registry, neighbour->Zone, 0, true);
+            }
+            break;
+        case ENET_EVENT_TYPE_RECEIVE:
+        {
+            if(neighbour && neighbour->bConnected)
+            {
+                BitReader reader(event.packet->data, (u32)event.packet->dataLength);
+                ENetMsg type;
+                if(ReadNetHeader(reader, type) && type == ENetMsg::Batch)
+                {
+                    const u32 headerSize = reader.GetBitsRead() / 8;
+                    NetUnbatch::ForEach(event.packet->data + headerSize, (u32)event.packet->dataLength - headerSize,
+                        [&](ENetMsg frameType, BitReader& frame)
+                        {
+                            Dispatch(frameType, frame, *neighbour, registry, clients);
+                        });
+                }
+            }
+            enet_packet_destroy(event.packet);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void ZoneLink::Dispatch(ENetMsg type, BitReader& reader, Neighbour& from, entt::registry& registry, const ZoneClientMap& clients)
+{
+    switch(type)
+    {
+        case ENetMsg::ZoneGhosts:
+            ReceiveGhosts(reader, from, registry, clients);
+            break;
+        case ENetMsg::ZoneHandoff:
+            ReceiveHandoff(reader, registry, clients);
+            break;
+        default:
+            break;
+    }
+}
+
+static void SetOwner(entt::registry& registry, entt::entity e, u32 clientId, const ZoneClientMap& clients)
+{
+    u32 slot;
+    if(clientId != 0 && clients.GetSlot(clientId, slot))
+    {
+        registry.emplace_or_replace<CNetOwner>(e, CNetOwner{slot});
+    }
+    else
+    {
+        registry.remove<CNetOwner>(e);
+    }
+}
+
+// ZoneGhosts body: first and last part of this tick's update, the entities sorted by id, each with its owner
+// as a client id and its transform against the entity before it, then an AddComponent body.
+void ZoneLink::ReceiveGhosts(BitReader& reader, Neighbour& from, entt::registry& registry, const ZoneClientMap& clients)
+{
+    const NetQuantization& quantization = GetNetQuantization();
+    const bool bFirst = reader.ReadBool();
+    const bool bLast = reader.ReadBool();
+    const u32 count = reader.ReadVarU32();
+    if(bFirst)
+    {
+        from.Generation++;
+    }
+
+    NetEntityState previous{};
+    for(u32 i = 0; i < count; i++)
+    {
+        NetEntityState state;
+        state.NetId = previous.NetId + reader.ReadVarU32();
+        const u32 owner = reader.ReadVarU32();
+        if(!NetSnapshotCodec::ReadState(reader, previous, state))
+        {
+            fprintf(stderr, "Dropping malformed ghost update from zone %u.\n", from.Zone);
+            return;
+        }
+        previous = state;
+
+        CTransform3d transform{};
+        state.ToTransform(transform, quantization);
+        entt::entity e;
+        if(auto it = Ghosts.find(state.NetId); it != Ghosts.end())
+        {
+            e = it->second;
+            CTransform3d& current = registry.get<CTransform3d>(e);
+            current.WorldPosition = transform.WorldPosition;
+            current.WorldRotation = transform.WorldRotation;
+            current.WorldScale = transform.WorldScale;
+            registry.replace<CNetGhost>(e, CNetGhost{from.Zone, from.Generation, 0});
+        }
+        else
+        {
+            e = registry.create();
+            registry.emplace<CNetwork>(e, CNetwork{state.NetId});
+            registry.emplace<CTransform3d>(e, transform);
+            registry.emplace<CNetGhost>(e, CNetGhost{from.Zone, from.Generation, 0});
+            Ghosts[state.NetId] = e;
+        }
+        SetOwner(registry, e, owner, clients);
+    }
+
+    const bool bValid = GetNetComponents().ReadChanges(reader, registry, [this](u32 netId)
+    {
+        auto it = Ghosts.find(netId);
+        return it != Ghosts.end() ? it->second : entt::entity(entt::null);
+    });
+    if(!bValid)
+    {
+        fprintf(stderr, "Dropping malformed ghost components from zone %u.\n", from.Zone);
+    }
+    if(bLast)
+    {
+        DropGhosts(registry, from.Zone, from.Generation, false);
+    }
+}
+
+// ZoneHandoff body: id, owner as a client id, the exact transform and path, then an AddComponent body.
+void ZoneLink::ReceiveHandoff(BitReader& reader, entt::registry& registry, const ZoneClientMap& clients)
+{
+    const u32 netId = reader.ReadVarU32();
+    const u32 owner = reader.ReadVarU32();
+    CTransform3d transform{};
+    for(u32 axis = 0; axis < 3; axis++)
+    {
+        transform.WorldPosition[axis] = reader.ReadF32();
+        transform.WorldRotation[axis] = reader.ReadF32();
+        transform.WorldScale[axis] = reader.ReadF32();
+    }
+    CFollow follow{};
+    follow.bFollow = reader.ReadBool();
+    follow.index = (i32)reader.ReadVarU32();
+    follow.TargetPos.x = reader.ReadF32();
+    follow.TargetPos.y = reader.ReadF32();
+    const u32 points = reader.ReadVarU32();
+    if(reader.HasOverflowed() || points > MaxHandoffPathPoints)
+    {
+        fprintf(stderr, "Dropping malformed handoff of entity %u.\n", netId);
+        return;
+    }
+    follow.StringPath.resize(points);
+    for(v2& point : follow.StringPath)
+    {
+        point.x = reader.ReadF32();
+        point.y = reader.ReadF32();
+    }
+    if(reader.HasOverflowed())
+    {
+        fprintf(stderr, "Dropping malformed handoff of entity %u.\n", netId);
+        return;
+    }
+
+    // Usually a ghost of it already exists and simply becomes authoritative
+    entt::entity e;
+    if(auto it = Ghosts.find(netId); it != Ghosts.end())
+    {
+        e = it->second;
+        Ghosts.erase(it);
+        registry.remove<CNetGhost>(e);
+        registry.replace<CTransform3d>(e, transform);
+    }
+    else
+    {
+        e = registry.create();
+        registry.emplace<CNetwork>(e, CNetwork{netId});
+        registry.emplace<CTransform3d>(e, transform);
+    }
+    registry.emplace_or_replace<CFollow>(e, std::move(follow));
+    SetOwner(registry, e, owner, clients);
+
+    GetNetComponents().ReadChanges(reader, registry, [e, netId](u32 id) { return id == netId ? e : entt::entity(entt::null); });
+    HandoffsReceived++;
+}
+
+void ZoneLink::DropGhosts(entt::registry& registry, u32 zone, u32 generation, bool bAll)
+{
+    for(auto it = Ghosts.begin(); it != Ghosts.end();)
+    {
+        CNetGhost& ghost = registry.get<CNetGhost>(it->second);
+        if(ghost.Zone != zone || (!bAll && ghost.Generation == generation))
+        {
+            ++it;
+            continue;
+        }
+        if(!bAll && ghost.Grace > 0)
+        {
+            ghost.Grace--;
+            ++it;
+            continue;
+        }
+        registry.destroy(it->second);
+        it = Ghosts.erase(it);
+    }
+}
+
+void ZoneLink::Tick(entt::registry& registry, const ZoneClientMap& clients)
+{
+    SendHandoffs(registry, clients);
+    for(u32 i = 0; i < Neighbours.size(); i++)
+    {
+        SendGhosts(registry, clients, i);
+    }
+
+    Batcher.Flush();
+    for(NetOutbound& outbound : Batcher.GetReady())
+    {
+        const Neighbour& neighbour = Neighbours[outbound.PeerId];
+        if(!neighbour.bConnected || enet_peer_send(neighbour.pPeer, outbound.Channel, outbound.pPacket) != 0)
+        {
+            enet_packet_destroy(outbound.pPacket);
+        }
+    }
+    Batcher.GetReady().clear();
+    enet_host_flush(pHost);
+}
+
+void ZoneLink::SendHandoffs(entt::registry& registry, const ZoneClientMap& clients)
+{
+    const NetComponentRegistry& components = GetNetComponents();
+
+    Crossed.clear();
+    auto units = registry.view<CNetwork, CTransform3d, CFollow>(entt::exclude<CNetGhost>);
+    for(entt::entity e : units)
+    {
+        if(Layout.GetZone(units.get<CTransform3d>(e).WorldPosition.x, Config.Index, Config.HandoffMargin) != Config.Index)
+        {
+            Crossed.push_back(e);
+        }
+    }
+
+    for(entt::entity e : Crossed)
+    {
+        // Authority moves one zone at a time, the next one passes it on if it has to
+        const u32 target = Layout.GetZone(registry.get<CTransform3d>(e).WorldPosition.x) > Config.Index ? Config.Index + 1 : Config.Index - 1;
+        Neighbour* neighbour = FindNeighbour(target);
+        if(!neighbour || !neighbour->bConnected)
+        {
+            continue;
+        }
+
+        const u32 netId = registry.get<CNetwork>(e).Id;
+        const CNetOwner* owner = registry.try_get<CNetOwner>(e);
+        const u32 ownerId = owner ? clients.GetId(owner->PeerId) : 0;
+        const NetComponentChange change{netId, e, components.GetMask(registry, e)};
+        const u32 index = (u32)(neighbour - Neighbours.data());
+        Batcher.Write(index, (u8)ENetChannelId::Reliable, ENET_PACKET_FLAG_RELIABLE, ENetMsg::ZoneHandoff, [&](BitWriter& writer)
+        {
+            const CTransform3d& transform = registry.get<CTransform3d>(e);
+            const CFollow& follow = registry.get<CFollow>(e);
+            writer.WriteVarU32(netId);
+            writer.WriteVarU32(ownerId);
+            for(u32 axis = 0; axis < 3; axis++)
+            {
+                writer.WriteF32(transform.WorldPosition[axis]);
+                writer.WriteF32(transform.WorldRotation[axis]);
+                writer.WriteF32(transform.WorldScale[axis]);
+            }
+            writer.WriteBool(follow.bFollow);
+            writer.WriteVarU32((u32)std::max(follow.index, 0));
+            writer.WriteF32(follow.TargetPos.x);
+            writer.WriteF32(follow.TargetPos.y);
+            writer.WriteVarU32((u32)follow.StringPath.size());
+            for(const v2& point : follow.StringPath)
+            {
+                writer.WriteF32(point.x);
+                writer.WriteF32(point.y);
+            }
+            components.WriteChanges(writer, registry, &change, change.Mask ? 1 : 0);
+        });
+
+        // Stays as a ghost, so clients of this zone never see it disappear, until the new owner lists it
+        registry.remove<CFollow>(e);
+        registry.emplace<CNetGhost>(e, CNetGhost{target, 0, HandoffGrace});
+        Ghosts[netId] = e;
+        HandoffsSent++;
+    }
+}
+
+void ZoneLink::SendGhosts(entt::registry& registry, const ZoneClientMap& clients, u32 index)
+{
+    Neighbour& neighbour = Neighbours[index];
+    if(!neighbour.bConnected)
+    {
+        return;
+    }
+
+    const bool bAbove = neighbour.Zone > Config.Index;
+    const f32 border = Layout.GetBorder(bAbove ? Config.Index : neighbour.Zone);
+    Border.clear();
+    auto authoritative = registry.view<CNetwork, CTransform3d>(entt::exclude<CNetGhost>);
+    for(entt::entity e : authoritative)
+    {
+        const f32 x = authoritative.get<CTransform3d>(e).WorldPosition.x;
+        if(bAbove ? x >= border - Config.GhostMargin : x <= border + Config.GhostMargin)
+        {
+            Border.push_back(GhostRecord{authoritative.get<CNetwork>(e).Id, e});
+        }
+    }
+    std::sort(Border.begin(), Border.end(), [](const GhostRecord& a, const GhostRecord& b) { return a.NetId < b.NetId; });
+
+    const NetComponentRegistry& components = GetNetComponents();
+    const NetQuantization& quantization = GetNetQuantization();
+    Ghosted.clear();
+    // At least one part even without ghosts, so the neighbour drops the ones that left
+    for(size_t start = 0; start == 0 || start < Border.size(); start += GhostsPerMessage)
+    {
+        const size_t end = std::min(Border.size(), start + GhostsPerMessage);
+        Changes.clear();
+        for(size_t i = start; i < end; i++)
+        {
+            const GhostRecord& record = Border[i];
+            u32 mask = 0;
+            if(!std::binary_search(neighbour.Ghosted.begin(), neighbour.Ghosted.end(), record.NetId))
+            {
+                mask = components.GetMask(registry, record.Entity);
+            }
+            else if(const CNetDirty* dirty = registry.try_get<CNetDirty>(record.Entity))
+            {
+                mask = dirty->Mask;
+            }
+            if(mask)
+            {
+                Changes.push_back(NetComponentChange{record.NetId, record.Entity, mask});
+            }
+            Ghosted.push_back(record.NetId);
+        }
+
+        Batcher.Write(index, (u8)ENetChannelId::Reliable, ENET_PACKET_FLAG_RELIABLE, ENetMsg::ZoneGhosts, [&](BitWriter& writer)
+        {
+            writer.WriteBool(start == 0);
+            writer.WriteBool(end == Border.size());
+            writer.WriteVarU32((u32)(end - start));
+            NetEntityState previous{};
+            for(size_t i = start; i < end; i++)
+            {
+                const GhostRecord& record = Border[i];
+                const NetEntityState state = NetEntityState::FromTransform(record.NetId, registry.get<CTransform3d>(record.Entity), quantization);
+                const CNetOwner* owner = registry.try_get<CNetOwner>(record.Entity);
+                writer.WriteVarU32(state.NetId - previous.NetId);
+                writer.WriteVarU32(owner ? clients.GetId(owner->PeerId) : 0);
+                NetSnapshotCodec::WriteState(writer, state, previous);
+                previous = state;
+            }
+            components.WriteChanges(writer, registry, Changes.data(), (u32)Changes.size());
+        });
+    }
+    neighbour.Ghosted.swap(Ghosted);
+}
@@ -0,0 +1,114 @@
+#ifndef X_ZONE_LINK_H
+#define X_ZONE_LINK_H
+
+#include <Core/defines.h>
+#include <Network/NetBatch.h>
+#include <Network/NetComponents.h>
+#include <Network/NetZone.h>
+#include <entt.hpp>
+#include <unordered_map>
+#include <vector>
+
+// The gateway and every zone of a match run on one machine and reach each other over loopback, see
+// Gateway and ZoneLink::Connect. Zone traffic from anywhere else is refused.
+[[nodiscard]] inline bool IsZoneLocalAddress(const ENetAddress& address)
+{
+    return address.host == ENET_HOST_TO_NET_32(0x7F000001);
+}
+
+// ENet peer slots of a zone's gateway connections and the gateway client ids behind them. Owners
+// travel between zones as client ids, every zone has its own slot for the same client.
+class ZoneClientMap
+{
+    std::vector<u32> Ids;
+    std::unordered_map<u32, u32> Slots;
+
+public:
+    void Add(u32 slot, u32 clientId);
+    void Remove(u32 slot);
+
+    // 0 if the slot holds no client
+    [[nodiscard]] u32 GetId(u32 slot) const { return slot < Ids.size() ? Ids[slot] : 0; }
+    [[nodiscard]] bool GetSlot(u32 clientId, u32& outSlot) const;
+};
+
+// One zone's links to the zones on either side of it, over ENet on the link ports. The lower zone
+// connects to the upper one. Every tick a zone hands off the entities that walked past a border, with
+// their path and components, and mirrors everything within GhostMargin of a border to the neighbour.
+// Ghosts are plain replicated entities without CFollow, so input never moves them, and they vanish
+// when their zone stops listing them.
+class ZoneLink
+{
+    static constexpr u32 GhostsPerMessage = 256;
+    static constexpr u32 HandoffGrace = 2;
+    static constexpr f64 RetryInterval = 1.0;
+
+    struct Neighbour
+    {
+        u32 Zone = 0;
+        ENetPeer* pPeer = nullptr;
+        bool bConnected = false;
+        // Only the lower zone of a pair connects
+        bool bInitiator = false;
+        f64 NextConnectTime = 0.0;
+        // Mirrored last tick, sorted. New ghosts get all their components, the rest what changed.
+        std::vector<u32> Ghosted;
+        // Of the ghost update being received
+        u32 Generation = 0;
+    };
+
+    struct GhostRecord
+    {
+        u32 NetId = 0;
+        entt::entity Entity = entt::null;
+    };
+
+    NetZoneConfig Config;
+    NetZoneLayout Layout;
+    ENetHost* pHost = nullptr;
+    std::vector<Neighbour> Neighbours;
+    NetBatcher Batcher;
+
+    // Ghosts of either neighbour by network id
+    std::unordered_map<u32, entt::entity> Ghosts;
+    std::vector<GhostRecord> Border;
+    std::vector<u32> Ghosted;
+    std::vector<NetComponentChange> Changes;
+    std::vector<entt::entity> Crossed;
+
+    u64 HandoffsSent = 0;
+    u64 HandoffsReceived = 0;
+
+    Neighbour* FindNeighbour(u32 zone);
+    void Connect(Neighbour& neighbour, f64 now);
+    void HandleEvent(const ENetEvent& event, entt::registry& registry, const ZoneClientMap& clients, f64 now);
+    void Dispatch(ENetMsg type, BitReader& reader, Neighbour& from, entt::registry& registry, const ZoneClientMap& clients);
+    void ReceiveGhosts(BitReader& reader, Neighbour& from, entt::registry& registry, const ZoneClientMap& clients);
+    void ReceiveHandoff(BitReader& reader, entt::registry& registry, const ZoneClientMap& clients);
+    void DropGhosts(entt::registry& registry, u32 zone, u32 generation, bool bAll);
+
+    void SendHandoffs(entt::registry& registry, const ZoneClientMap& clients);
+    void SendGhosts(entt::registry& registry, const ZoneClientMap& clients, u32 index);
+
+public:
+    ZoneLink() = default;
+    ZoneLink(const ZoneLink&) = delete;
+    ZoneLink& operator=(const ZoneLink&) = delete;
+    ~ZoneLink();
+
+    bool Start(const NetZoneConfig& config, const NetZoneLayout& layout);
+    void Stop();
+
+    // Applies the ghosts and handoffs of the neighbours and keeps the links up.
+    void Service(entt::registry& registry, const ZoneClientMap& clients, f64 now);
+
+    // Hands off and mirrors entities. After the simulation step and before replication clears the dirty bits.
+    void Tick(entt::registry& registry, const ZoneClientMap& clients);
+
+    [[nodiscard]] inline bool IsRunning() const { return pHost != nullptr; }
+    [[nodiscard]] inline u32 GetGhostCount() const { return (u32)Ghosts.size(); }
+    [[nodiscard]] inline u64 GetHandoffsSent() const { return HandoffsSent; }
+    [[nodiscard]] inline u64 GetHandoffsReceived() const { return HandoffsReceived; }
+};
+
+#endif //X_ZONE_LINK_H
@@ -0,0 +1,196 @@
+#include <Network/NetInput.h>
+#include <Network/NetPacketPool.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Gateway.h"
+#include "LockstepMatch.h"
+#include "ServerMatch.h"
+
+static std::atomic<bool> bRunning = true;
+
+static void Shutdown(int)
+{
+    bRunning.store(false);
+}
+
+static void PrintUsage()
+{
+    puts("Usage: x_server [--port 7777] [--matches 1] [--max-clients 32] [--navmesh ../assets/save.txt]\n"
+         "                [--snapshot-budget 1100] [--stream-budget 2400] [--units-per-client 1]\n"
+         "                [--net-stats <file.csv|file.json>] [--net-stats-interval 1]\n"
+         "                [--capture <file>] [--compression-model <file>]\n"
+         "                [--zones 1] [--zone 0] [--zone-port 7800] [--ghost-margin 360] [--gateway]\n"
+         "                [--transport socket|batched] [--lockstep] [--players 2] [--units 500]");
+}
+
+// stats.csv -> stats.7778.csv, empty paths stay empty
+static std::string AppendPort(const std::string& path, u16 port)
+{
+    if(path.empty())
+    {
+        return path;
+    }
+    const size_t slash = path.find_last_of("/\\");
+    size_t dot = path.rfind('.');
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        dot = path.size();
+    }
+    return path.substr(0, dot) + "." + std::to_string(port) + path.substr(dot);
+}
+
+int main(int argc, char** argv)
+{
+    ServerConfig config;
+    u32 matchCount = 1;
+    bool bLockstep = false;
+    bool bGateway = false;
+    for(i32 i = 1; i < argc; i++)
+    {
+        const bool bHasValue = i + 1 < argc;
+        if(!strcmp(argv[i], "--port") && bHasValue) config.Port = (u16)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--matches") && bHasValue) matchCount = (u32)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--max-clients") && bHasValue) config.MaxClients = (u32)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--navmesh") && bHasValue) config.NavMeshPath = argv[++i];
+        else if(!strcmp(argv[i], "--snapshot-budget") && bHasValue) config.Priority.SnapshotBytesPerTick = (u32)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--stream-budget") && bHasValue) config.Stream.BytesPerTick = (u32)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--units-per-client") && bHasValue) config.UnitsPerClient = (u32)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--net-stats") && bHasValue) config.TelemetryPath = argv[++i];
+        else if(!strcmp(argv[i], "--net-stats-interval") && bHasValue) config.TelemetryInterval = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--capture") && bHasValue) config.CapturePath = argv[++i];
+        else if(!strcmp(argv[i], "--compression-model") && bHasValue) config.CompressionModelPath = argv[++i];
+        else if(!strcmp(argv[i], "--zones") && bHasValue) config.Zone.Count = (u32)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--zone") && bHasValue) config.Zone.Index = (u32)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--zone-port") && bHasValue) config.Zone.BasePort = (u16)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--ghost-margin") && bHasValue) config.Zone.GhostMargin = (f32)atof(argv[++i]);
+        else if(!strcmp(argv[i], "--gateway")) bGateway = true;
+        else if(!strcmp(argv[i], "--transport") && bHasValue)
+            config.Transport = !strcmp(argv[++i], "batched") ? ENetTransportKind::Batched : ENetTransportKind::Socket;
+        else if(!strcmp(argv[i], "--lockstep")) bLockstep = true;
+        else if(!strcmp(argv[i], "--players") && bHasValue) config.LockstepPlayers = (u32)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--units") && bHasValue) config.LockstepUnitsPerPlayer = (u32)atoi(argv[++i]);
+        else
+        {
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(NetPacketPool::Initialize() != 0)
+    {
+        fprintf(stderr, "An error occurred while initializing ENet.\n");
+        return EXIT_FAILURE;
+    }
+    std::atexit(enet_deinitialize);
+
+    std::signal(SIGINT, Shutdown);
+    std::signal(SIGTERM, Shutdown);
+
+    if(config.Zone.Count == 0 || config.Zone.Index >= config.Zone.Count || (bGateway && !config.Zone.IsSharded()))
+    {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+    if(bGateway)
+    {
+        // Nothing to simulate, just relay, so poll often rather than once per tick
+        Gateway gateway(config);
+        if(!gateway.Start())
+        {
+            return EXIT_FAILURE;
+        }
+        while(bRunning.load())
+        {
+            gateway.Service();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        printf("Shutting down after %llu zone transfers.\n", (unsigned long long)gateway.GetTransfers());
+        return EXIT_SUCCESS;
+    }
+    if(config.Zone.IsSharded())
+    {
+        // One zone per process, the gateway finds it by its index
+        matchCount = 1;
+        bLockstep = false;
+        config.Port = config.Zone.GetClientPort(config.Zone.Index);
+    }
+
+    std::vector<std::unique_ptr<ServerMatch>> matches;
+    std::vector<std::unique_ptr<LockstepMatch>> lockstepMatches;
+    for(u32 i = 0; i < matchCount; i++)
+    {
+        ServerConfig matchConfig = config;
+        matchConfig.Port = (u16)(config.Port + i);
+        if(matchCount > 1)
+        {
+            // One file per match, named after its port
+            matchConfig.TelemetryPath = AppendPort(config.TelemetryPath, matchConfig.Port);
+            matchConfig.CapturePath = AppendPort(config.CapturePath, matchConfig.Port);
+        }
+        if(bLockstep)
+        {
+            auto match = std::make_unique<LockstepMatch>(matchConfig);
+            if(!match->Start())
+            {
+                return EXIT_FAILURE;
+            }
+            lockstepMatches.push_back(std::move(match));
+            continue;
+        }
+        auto match = std::make_unique<ServerMatch>(matchConfig);
+        if(!match->Start())
+        {
+            return EXIT_FAILURE;
+        }
+        matches.push_back(std::move(match));
+    }
+
+    // Fixed tick at the input rate, clients predict with the same step. The thread sleeps
+    // until the next tick is due instead of spinning.
+    using Clock = std::chrono::steady_clock;
+    const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<f64>(1.0 / NetInputTickRate));
+    auto nextTick = Clock::now();
+    while(bRunning.load())
+    {
+        for(auto& match : matches)
+        {
+            match->Service();
+        }
+        for(auto& match : lockstepMatches)
+        {
+            match->Service();
+        }
+        for(auto& match : matches)
+        {
+            match->Tick();
+        }
+        for(auto& match : lockstepMatches)
+        {
+            match->Tick();
+        }
+
+        nextTick += tickDuration;
+        const auto now = Clock::now();
+        if(now - nextTick > tickDuration * 4)
+        {
+            // Too far behind to catch up, drop the missed ticks instead of running them back to back
+            fprintf(stderr, "Server fell %lld ms behind, skipping ticks.\n",
+                    (long long)std::chrono::duration_cast<std::chrono::milliseconds>(now - nextTick).count());
+            nextTick = now;
+        }
+        std::this_thread::sleep_until(nextTick);
+    }
+
+    puts("Shutting down.");
+    matches.clear();
+    lockstepMatches.clear();
+    return EXIT_SUCCESS;
+}
@@ -5,6 +5,8 @@
 #include <Core/Camera.h>
 #include <Util/Util.h>
 #include <Navigation/Navigation.h>
+#include <Navigation/PathFollow.h>
+#include <Network/NetworkDriver.h>
 #include <Components/FollowComponent.h>
 #include <Components/SkeletalMeshComponent.h>
 #include <Renderer/Renderer.h>
@@ -79,30 +81,7 @@ void MainScene::Update(f32 deltaTime)
 
     for(entt::entity entity : FollowEntities)
     {
-        v2& targetPos = Registry.get<CFollow>(entity).TargetPos;
-        v3 TargetPos3d = {targetPos.x, 0.f, targetPos.y};
-
-        v3& FollowPos = Registry.get<CTransform3d>(entity).WorldPosition;
-        CFollow& follow = GetComponent<CFollow>(entity);
-
-        std::vector<v2>& StringPath = follow.StringPath;
-        if(!follow.bFollow)
-        {
-            continue;
-        }
-
-        if(glm::distance(FollowPos, TargetPos3d) > 0.01f)
-        {
-            FollowPos += glm::normalize(TargetPos3d - FollowPos) * 50.0f * deltaTime;
-        }
-        else
-        {
-            follow.index++;
-            if(StringPath.size() > follow.index)
-            {
-                targetPos = StringPath[follow.index];
-            }
-        }
+        Navigation::StepFollow(GetComponent<CFollow>(entity), GetComponent<CTransform3d>(entity).WorldPosition, deltaTime);
     }
     lifeTime += deltaTime;
     auto view = Registry.view<CTransform3d, CSkeletalMesh>();
@@ -145,21 +124,12 @@ void MainScene::HandleInput(const SDL_Event &event)
 
         for(const entt::entity& ent : FollowEntities)
         {
-            std::vector<Navigation::TriangleNode*> path;
-            CFollow& follow = GetComponent<CFollow>(ent);
-            follow.bFollow = true;
-            follow.index = 1;
-
             StartPoint = {GetComponent<CTransform3d>(ent).WorldPosition.x, GetComponent<CTransform3d>(ent).WorldPosition.z};
-            Navigation::AStar(StartPoint, EndPoint, path, Portals, Tris);
-
-            std::vector<v2>& StringPath = follow.StringPath;
-
-            StringPath = Navigation::StringPull(Portals, StartPoint, EndPoint);
-            Portals.clear();
-
-            follow.TargetPos = StringPath[follow.index];
+            Navigation::StartFollow(GetComponent<CFollow>(ent), Navigation::FindPath(StartPoint, EndPoint, Tris));
         }
+
+        // Units owned on a server are moved through predicted input commands instead
+        NetworkDriver::Get().GetPrediction().IssueMove(EndPoint);
     }
     if(event.type == SDL_KEYDOWN)
     {
@@ -256,31 +226,9 @@ void MainScene::Save()
 
 void MainScene::Load()
 {
-    std::ifstream file;
-    file.open("../assets/save.txt");
-    if(file.is_open())
+    if(Navigation::LoadNavMesh("../assets/save.txt", points, Tris))
     {
-        std::string line;
-        while(std::getline(file, line) && line != "TRIANGLES")
-        {
-            std::stringstream ss(line);
-            f32 x, y;
-            ss >> x >> y;
-            points.emplace_back(x, y);
-        }
-
-        Tris = Navigation::BowyerWatson(points);
-
-        while(std::getline(file, line))
-        {
-            std::stringstream ss(line);
-            u32 idx;
-            bool blocked;
-            ss >> idx >> blocked;
-            Tris[idx].SetBlocked(blocked);
-        }
-
-        file.close();
+        NetworkDriver::Get().GetPrediction().SetNavMesh(&Tris);
 
         for(const Navigation::TriangleNode& graphTriangle : Tris)
         {
@@ -305,6 +253,85 @@ void MainScene::DrawUI()
         u32 fps = x::Engine::GetFPS();
         ImGui::Text("FPS: %d", fps);
 
+        // Rates over the last telemetry interval
+        const NetworkDriver& network = NetworkDriver::Get();
+        const ENetConnectionState connection = network.GetConnectionState();
+        ImGui::Text("Server %s:%u: %s", network.GetConnectConfig().Host.c_str(), network.GetConnectConfig().Port,
+                    GetNetConnectionStateName(connection));
+        if(connection == ENetConnectionState::Retrying || connection == ENetConnectionState::Connecting)
+        {
+            ImGui::SameLine();
+            ImGui::Text("(attempt %u)", network.GetConnectAttempts());
+        }
+        else if(connection == ENetConnectionState::Failed)
+        {
+            ImGui::SameLine();
+            if(ImGui::SmallButton("Reconnect"))
+            {
+                NetworkDriver::Get().Reconnect();
+            }
+        }
+        if(const u32 streaming = network.GetStreamRemaining())
+        {
+            ImGui::Text("Loading world: %u entities left", streaming);
+        }
+        const NetTelemetrySample& current = network.GetTelemetry();
+        const NetTelemetrySample& previous = network.GetPreviousTelemetry();
+        const f64 seconds = current.Time - previous.Time;
+        if(seconds > 0.0 && ImGui::CollapsingHeader("Network", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            ImGui::Text("Queues: %u in, %u out", current.InboundDepth, current.OutboundDepth);
+            for(u32 i = 0; i < NetTelemetryMaxPeers; i++)
+            {
+                const NetPeerSample& now = current.Peers[i];
+                const NetPeerSample& before = previous.Peers[i];
+                if(now.bConnected)
+                {
+                    ImGui::Text("Peer %u: RTT %u +- %u ms, loss %.1f%%, in %.0f B/s, out %.0f B/s", i, now.RoundTripMs,
+                                now.RoundTripVarianceMs, now.PacketLoss * 100.f, (f64)(now.BytesIn - before.BytesIn) / seconds,
+                                (f64)(now.BytesOut - before.BytesOut) / seconds);
+                }
+            }
+
+            if(ImGui::BeginTable("NetTypes", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit))
+            {
+                ImGui::TableSetupColumn("Type");
+                ImGui::TableSetupColumn("In/s");
+                ImGui::TableSetupColumn("In B/s");
+                ImGui::TableSetupColumn("Decode us");
+                ImGui::TableSetupColumn("Out/s");
+                ImGui::TableSetupColumn("Out B/s");
+                ImGui::TableSetupColumn("Encode us");
+                ImGui::TableHeadersRow();
+                for(u32 i = 0; i < NetMsgTypeCount; i++)
+                {
+                    const NetTypeSample& now = current.Types[i];
+                    const NetTypeSample& before = previous.Types[i];
+                    const u64 messagesIn = now.MessagesIn - before.MessagesIn, messagesOut = now.MessagesOut - before.MessagesOut;
+                    if(messagesIn == 0 && messagesOut == 0)
+                    {
+                        continue;
+                    }
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(GetNetMsgName((ENetMsg)i));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.0f", (f64)messagesIn / seconds);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.0f", (f64)(now.BytesIn - before.BytesIn) / seconds);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", messagesIn > 0 ? (f64)(now.DecodeNs - before.DecodeNs) / (f64)messagesIn / 1e3 : 0.0);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.0f", (f64)messagesOut / seconds);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.0f", (f64)(now.BytesOut - before.BytesOut) / seconds);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", messagesOut > 0 ? (f64)(now.EncodeNs - before.EncodeNs) / (f64)messagesOut / 1e3 : 0.0);
+                }
+                ImGui::EndTable();
+            }
+        }
+
         if(ImGui::Button("Save"))
         {
             Save();
@@ -16,7 +16,6 @@ class MainScene final : public Scene
 
     std::vector<v2> points;
 
-    std::vector<Edge2D> Portals = {};
     std::vector<Navigation::TriangleNode> Tris = {};
 
     Bone Skeleton = {};
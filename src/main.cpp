@@ -1,8 +1,50 @@
 #include "../engine/engine.h"
 #include "Scenes/MainScene.h"
+#include <Network/NetworkDriver.h>
+#include <cstdlib>
+#include <cstring>
 
-int main()
+int main(int argc, char** argv)
 {
+    // --capture <file> records the session, --replay <file> [--fast] plays one back instead of connecting,
+    // --net-stats <file.csv|file.json> [seconds] exports network telemetry, --net-model <file> asks the server
+    // to compress with that model, --connect <host[:port]> picks the server
+    for(i32 i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "--capture") && i + 1 < argc)
+        {
+            NetworkDriver::Get().SetCapture(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "--replay") && i + 1 < argc)
+        {
+            const char* path = argv[++i];
+            const bool bFast = i + 1 < argc && !strcmp(argv[i + 1], "--fast");
+            i += bFast;
+            NetworkDriver::Get().SetReplay(path, !bFast);
+        }
+        else if(!strcmp(argv[i], "--net-model") && i + 1 < argc)
+        {
+            NetworkDriver::Get().SetCompressionModel(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "--connect") && i + 1 < argc)
+        {
+            NetConnectConfig config;
+            config.Host = argv[++i];
+            if(const size_t colon = config.Host.rfind(':'); colon != std::string::npos)
+            {
+                config.Port = (u16)atoi(config.Host.c_str() + colon + 1);
+                config.Host.resize(colon);
+            }
+            NetworkDriver::Get().SetConnectConfig(config);
+        }
+        else if(!strcmp(argv[i], "--net-stats") && i + 1 < argc)
+        {
+            const char* path = argv[++i];
+            const f64 interval = i + 1 < argc && argv[i + 1][0] != '-' ? atof(argv[++i]) : 1.0;
+            NetworkDriver::Get().SetTelemetryExport(path, interval > 0.0 ? interval : 1.0);
+        }
+    }
+
     Scene* mainScene = new MainScene();
     return x::Engine::Get().Run(mainScene);
 }
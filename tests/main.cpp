@@ -0,0 +1,117 @@
+#include <Components/NetInterpolationComponent.h>
+#include <Components/NetPredictedComponent.h>
+#include <Components/TransformComponent.h>
+#include <Network/NetPrediction.h>
+#include <Network/NetPriority.h>
+#include <Network/NetSnapshot.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Checks of the networking code that need no sockets. Exits with failure on the first one that does not hold.
+static bool Check(bool bCondition, const char* what)
+{
+    if(!bCondition)
+    {
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return bCondition;
+}
+
+// Every entity moves every tick while the client acknowledges only every tenth snapshot, so the baseline
+// lags far behind the last sent snapshot. The encoded snapshot must still stay within the budget.
+static bool SnapshotBudgetWithLaggingBaseline()
+{
+    constexpr u32 PeerId = 1;
+    constexpr u32 EntityCount = 300;
+    constexpr u32 BudgetBytes = 600;
+
+    NetSnapshotSender sender;
+    NetSnapshotReceiver receiver;
+    NetPriorityAccumulator priorities;
+    NetSnapshot visible;
+    NetSnapshot budgeted;
+    std::vector<f32> weights(EntityCount);
+    std::vector<u8> buffer(64 * 1024);
+
+    for(u32 tick = 1; tick <= 60; tick++)
+    {
+        visible.Sequence = tick;
+        visible.ServerTimeMs = tick * 50;
+        visible.Entities.resize(EntityCount);
+        for(u32 i = 0; i < EntityCount; i++)
+        {
+            NetEntityState& state = visible.Entities[i];
+            state.NetId = i + 1;
+            state.Position[0] = 1000 + i * 37 + tick * 11;
+            state.Position[2] = 5000 + i * 13 + tick * 7;
+            state.Rotation[1] = tick * 3;
+            weights[i] = 1.f + (f32)(i % 4);
+        }
+
+        priorities.Select(visible, weights, sender.GetLastSent(PeerId), sender.GetBaseline(PeerId, tick), BudgetBytes, budgeted);
+        BitWriter writer(buffer.data(), (u32)buffer.size());
+        if(!Check(sender.Encode(PeerId, budgeted, writer), "snapshot encodes"))
+        {
+            return false;
+        }
+        writer.Flush();
+        if(!Check(writer.GetBytesWritten() <= BudgetBytes, "encoded snapshot stays within the byte budget"))
+        {
+            fprintf(stderr, "  tick %u: %u bytes for a budget of %u\n", tick, writer.GetBytesWritten(), BudgetBytes);
+            return false;
+        }
+
+        BitReader reader(buffer.data(), writer.GetBytesWritten());
+        if(!Check(receiver.Receive(reader), "client reconstructs the snapshot"))
+        {
+            return false;
+        }
+        if(tick % 10 == 1)
+        {
+            sender.Acknowledge(PeerId, tick);
+        }
+    }
+    return Check(priorities.GetDeferredCount() > 0, "the budget defers some updates");
+}
+
+// A snapshot overtakes the spawn of an owned unit, so the client first creates it as a remote entity the way
+// it does for any snapshot entity it has not seen. The spawn that follows must turn it into a predicted unit.
+static bool OwnedSpawnAfterSnapshot()
+{
+    entt::registry registry;
+    NetPrediction prediction;
+
+    CTransform3d transform{};
+    transform.WorldPosition = v3(10.f, 0.f, 20.f);
+    const entt::entity e = registry.create();
+    registry.emplace<CTransform3d>(e, transform);
+    prediction.SetOwned(registry, e, false);
+    if(!Check(registry.all_of<CNetInterpolation>(e) && !registry.all_of<CNetPredicted>(e), "snapshot spawns an interpolated entity"))
+    {
+        return false;
+    }
+
+    prediction.SetOwned(registry, e, true);
+    if(!Check(registry.all_of<CNetPredicted>(e) && !registry.all_of<CNetInterpolation>(e), "owned spawn makes the entity predicted"))
+    {
+        return false;
+    }
+    const CNetPredicted& unit = registry.get<CNetPredicted>(e);
+    bool bPassed = Check(unit.Position == transform.WorldPosition, "prediction starts at the spawn position");
+
+    // A repeated spawn keeps the prediction it already runs
+    registry.get<CNetPredicted>(e).ErrorOffset = v3(1.f);
+    prediction.SetOwned(registry, e, true);
+    bPassed &= Check(registry.get<CNetPredicted>(e).ErrorOffset == v3(1.f), "repeated owned spawn keeps the prediction");
+    return bPassed;
+}
+
+i32 main()
+{
+    bool bPassed = true;
+    bPassed &= SnapshotBudgetWithLaggingBaseline();
+    bPassed &= OwnedSpawnAfterSnapshot();
+    puts(bPassed ? "All network checks passed." : "Network checks failed.");
+    return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}